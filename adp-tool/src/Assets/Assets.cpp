@@ -17,6 +17,7 @@ struct BrushData
 	wxBrush SensorBar = wxBrush(wxColour(25, 25, 25), wxBRUSHSTYLE_SOLID);
 	wxBrush ReleaseMargin = wxBrush(wxColour(50, 50, 50), wxBRUSHSTYLE_SOLID);
 	wxBrush DarkGray = wxBrush(wxColour(50, 50, 50), wxBRUSHSTYLE_SOLID);
+	wxBrush SuggestedThreshold = wxBrush(wxColour(110, 200, 240), wxBRUSHSTYLE_SOLID);
 };
 static BrushData* brushes;
 
@@ -25,6 +26,7 @@ BRUSH(SensorOn)
 BRUSH(SensorBar)
 BRUSH(ReleaseMargin)
 BRUSH(DarkGray)
+BRUSH(SuggestedThreshold)
 
 // ====================================================================================================================
 // Pens.
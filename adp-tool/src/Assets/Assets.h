@@ -14,6 +14,7 @@ struct Brushes
 	static const wxBrush& SensorBar();
 	static const wxBrush& ReleaseMargin();
 	static const wxBrush& DarkGray();
+	static const wxBrush& SuggestedThreshold();
 };
 
 struct Pens
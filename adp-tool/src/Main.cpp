@@ -23,16 +23,22 @@ using json = nlohmann::json;
 #include "View/MappingTab.h"
 #include "View/LightsTab.h"
 #include "View/DeviceTab.h"
+#include "View/DiagnosticsTab.h"
+#include "View/ScopeTab.h"
 #include "View/AboutTab.h"
 #include "View/LogTab.h"
 
+#include "Model/Daemon.h"
 #include "Model/Log.h"
-#include "Model/Updater.h"
+#include "Model/Server.h"
+#include "Update/Updater.h"
 #include "View/UpdaterView.h"
 
 namespace adp {
 
-enum Ids { PROFILE_LOAD = 1, PROFILE_SAVE = 2, MENU_EXIT = 3};
+enum Ids { PROFILE_LOAD = 1, PROFILE_SAVE = 2, MENU_EXIT = 3, RECORD_START = 4, RECORD_STOP = 5,
+    REPLAY_OPEN = 6, REPLAY_OPEN_FAST = 7, EMULATOR_START = 8, EMULATOR_START_8KHZ = 9, VIRTUAL_CLOSE = 10,
+    SERVER_START = 11, SERVER_STOP = 12, SHARING_START = 13, SHARING_STOP = 14};
 
 
 // ====================================================================================================================
@@ -56,6 +62,20 @@ public:
 
         fileMenu->Append(PROFILE_LOAD, wxT("Load profile"));
         fileMenu->Append(PROFILE_SAVE, wxT("Save profile"));
+        fileMenu->AppendSeparator();
+        fileMenu->Append(RECORD_START, wxT("Start recording..."));
+        fileMenu->Append(RECORD_STOP, wxT("Stop recording"));
+        fileMenu->Append(REPLAY_OPEN, wxT("Replay recording..."));
+        fileMenu->Append(REPLAY_OPEN_FAST, wxT("Replay recording as fast as possible..."));
+        fileMenu->Append(EMULATOR_START, wxT("Start emulator"));
+        fileMenu->Append(EMULATOR_START_8KHZ, wxT("Start emulator at 8 kHz"));
+        fileMenu->Append(VIRTUAL_CLOSE, wxT("Close replay or emulator"));
+        fileMenu->AppendSeparator();
+        fileMenu->Append(SERVER_START, wxT("Start web client server"));
+        fileMenu->Append(SERVER_STOP, wxT("Stop web client server"));
+        fileMenu->Append(SHARING_START, wxT("Share sensor state with games"));
+        fileMenu->Append(SHARING_STOP, wxT("Stop sharing sensor state"));
+        fileMenu->AppendSeparator();
         fileMenu->Append(MENU_EXIT, wxT("Exit"));
 
         SetMenuBar(menuBar);
@@ -150,9 +170,79 @@ public:
         }
     }
 
+    void RecordStart(wxCommandEvent & event)
+    {
+        if (!Device::Pad() || Device::IsRecording())
+            return;
+
+        wxFileDialog dlg(this, L"Record session", L"", L"session", L"ADP recording (*.adpr)|*.adpr|All files (*)|*",
+        wxFD_SAVE|wxFD_OVERWRITE_PROMPT);
+
+        if (dlg.ShowModal() == wxID_CANCEL)
+            return;
+
+        Device::StartRecording(dlg.GetPath().ToStdString().c_str());
+    }
+
+    void RecordStop(wxCommandEvent & event)
+    {
+        Device::StopRecording();
+    }
+
+    void ReplayOpen(wxCommandEvent & event)
+    {
+        wxFileDialog dlg(this, L"Replay recording", L"", L"", L"ADP recording (*.adpr)|*.adpr|All files (*)|*",
+        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+        if (dlg.ShowModal() == wxID_CANCEL)
+            return;
+
+        if (Device::OpenReplay(dlg.GetPath().ToStdString().c_str(), event.GetId() == REPLAY_OPEN))
+            HandleDeviceChange();
+    }
+
+    void EmulatorStart(wxCommandEvent & event)
+    {
+        EmulatorSettings settings;
+        if (event.GetId() == EMULATOR_START_8KHZ)
+            settings.reportRate = EmulatorSettings::MAX_REPORT_RATE;
+
+        if (Device::StartEmulator(settings))
+            HandleDeviceChange();
+    }
+
+    void VirtualClose(wxCommandEvent & event)
+    {
+        Device::CloseVirtualDevice();
+        HandleDeviceChange();
+    }
+
+    void ServerStart(wxCommandEvent & event)
+    {
+        if (!Server::IsRunning())
+            Server::Start();
+    }
+
+    void ServerStop(wxCommandEvent & event)
+    {
+        Server::Stop();
+    }
+
+    void SharingStart(wxCommandEvent & event)
+    {
+        if (!Device::IsSharing())
+            Device::StartSharing();
+    }
+
+    void SharingStop(wxCommandEvent & event)
+    {
+        Device::StopSharing();
+    }
+
     void Tick()
     {
         auto changes = Device::Update();
+        Server::Update(changes);
 
         if (changes & DCF_DEVICE) {
             UpdatePages();
@@ -217,10 +307,16 @@ private:
             AddTab(0, new SensitivityTab(myTabs, pad), SensitivityTab::Title, true);
             AddTab(1, new MappingTab(myTabs, pad), MappingTab::Title);
             AddTab(2, new DeviceTab(myTabs), DeviceTab::Title);
+            int index = 3;
             auto lights = Device::Lights();
             if (pad->featureLights && lights)
             {
-                AddTab(3, new LightsTab(myTabs, lights), LightsTab::Title);
+                AddTab(index++, new LightsTab(myTabs, lights), LightsTab::Title);
+            }
+            AddTab(index++, new DiagnosticsTab(myTabs), DiagnosticsTab::Title);
+            if (pad->featureRawAdc)
+            {
+                AddTab(index++, new ScopeTab(myTabs, pad), ScopeTab::Title);
             }
         }
         else
@@ -229,6 +325,14 @@ private:
         }
     }
 
+    void HandleDeviceChange()
+    {
+        UpdatePages();
+        UpdateStatusText();
+        for (auto tab : myTabList)
+            tab->HandleChanges(DCF_DEVICE);
+    }
+
     void UpdateStatusText()
     {
         auto pad = Device::Pad();
@@ -241,7 +345,10 @@ private:
     void UpdatePollingRate()
     {
         auto rate = Device::PollingRate();
-        if (rate > 0)
+        auto reports = Device::Reports();
+        if (rate > 0 && reports && reports->extended)
+            SetStatusText(wxString::Format("%iHz, %llu dropped, %.1fms", rate, (unsigned long long)reports->dropped, reports->latency), 1);
+        else if (rate > 0)
             SetStatusText(wxString::Format("%iHz", rate), 1);
         else
             SetStatusText(wxEmptyString, 1);
@@ -283,6 +390,17 @@ BEGIN_EVENT_TABLE(MainWindow, wxFrame)
     EVT_MENU(MENU_EXIT, MainWindow::CloseApp)
     EVT_MENU(PROFILE_LOAD, MainWindow::ProfileLoad)
     EVT_MENU(PROFILE_SAVE, MainWindow::ProfileSave)
+    EVT_MENU(RECORD_START, MainWindow::RecordStart)
+    EVT_MENU(RECORD_STOP, MainWindow::RecordStop)
+    EVT_MENU(REPLAY_OPEN, MainWindow::ReplayOpen)
+    EVT_MENU(REPLAY_OPEN_FAST, MainWindow::ReplayOpen)
+    EVT_MENU(EMULATOR_START, MainWindow::EmulatorStart)
+    EVT_MENU(EMULATOR_START_8KHZ, MainWindow::EmulatorStart)
+    EVT_MENU(VIRTUAL_CLOSE, MainWindow::VirtualClose)
+    EVT_MENU(SERVER_START, MainWindow::ServerStart)
+    EVT_MENU(SERVER_STOP, MainWindow::ServerStop)
+    EVT_MENU(SHARING_START, MainWindow::SharingStart)
+    EVT_MENU(SHARING_STOP, MainWindow::SharingStop)
 END_EVENT_TABLE()
 
 // ====================================================================================================================
@@ -332,6 +450,11 @@ bool Application::OnInit()
     Assets::Init();
     Device::Init();
 
+    // Share the pad with the other tools if an adp daemon owns it.
+    auto daemonPath = DaemonSocketPath();
+    if (IsDaemonRunning(daemonPath))
+        Device::UseDaemon(daemonPath.c_str());
+
     wxImage::AddHandler(new wxPNGHandler());
 
     wxIconBundle icons;
@@ -367,6 +490,7 @@ void Application::Restart()
 int Application::OnExit()
 {
     //Updater::Shutdown();
+    Server::Stop();
     Device::Shutdown();
     Assets::Shutdown();
     Log::Shutdown();
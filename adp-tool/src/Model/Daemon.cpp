@@ -0,0 +1,808 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Model/Daemon.h"
+#include "Model/Device.h"
+#include "Model/Log.h"
+
+using namespace std;
+
+namespace adp {
+
+constexpr int REQUEST_TIMEOUT_MS = 2000;
+constexpr size_t MAX_CLIENT_INPUT = 4096;
+
+// Requests carry at most one report, a client with a longer partial message is not speaking the protocol.
+constexpr size_t MAX_REQUEST_SIZE = DAEMON_HEADER_SIZE + MAX_REPORT_SIZE;
+
+// Encoded messages are shared by every client they are sent to.
+typedef shared_ptr<const vector<uint8_t>> Message;
+
+static void PutHeader(vector<uint8_t>& out, uint8_t type, size_t size)
+{
+	auto u16 = WriteU16LE((int)size);
+	out.push_back(type);
+	out.push_back(0);
+	out.insert(out.end(), u16.bytes, u16.bytes + sizeof(u16.bytes));
+}
+
+static Message EncodeMessage(uint8_t type, const uint8_t* payload, size_t size)
+{
+	auto message = make_shared<vector<uint8_t>>();
+	message->reserve(DAEMON_HEADER_SIZE + size);
+	PutHeader(*message, type, size);
+	message->insert(message->end(), payload, payload + size);
+	return message;
+}
+
+// Calls the handler for every complete message at the start of the buffer and removes them.
+template <typename Handler>
+static void ParseMessages(vector<uint8_t>& buffer, Handler handler)
+{
+	size_t pos = 0;
+	while (buffer.size() - pos >= DAEMON_HEADER_SIZE)
+	{
+		size_t size = ReadU16LE(&buffer[pos + 2]);
+		if (buffer.size() - pos < DAEMON_HEADER_SIZE + size)
+			break;
+
+		handler(buffer[pos], &buffer[pos + DAEMON_HEADER_SIZE], size);
+		pos += DAEMON_HEADER_SIZE + size;
+	}
+
+	buffer.erase(buffer.begin(), buffer.begin() + pos);
+}
+
+string DaemonSocketPath()
+{
+	auto path = getenv("ADP_DAEMON_SOCKET");
+	if (path && *path)
+		return path;
+
+#ifdef _WIN32
+	return string();
+#else
+	auto runtimeDir = getenv("XDG_RUNTIME_DIR");
+	if (runtimeDir && *runtimeDir)
+		return string(runtimeDir) + "/adp.sock";
+
+	return "/tmp/adp-" + to_string(getuid()) + ".sock";
+#endif
+}
+
+#ifdef _WIN32
+
+// Unix domain sockets are not used on Windows, the pad is always opened directly there.
+
+bool Daemon::Start(const char* path)
+{
+	Log::Write(L"Daemon :: not supported on this platform");
+	return false;
+}
+
+bool IsDaemonRunning(const string& path) { return false; }
+void Daemon::Stop() {}
+bool Daemon::IsRunning() { return false; }
+int Daemon::NumClients() { return 0; }
+void Daemon::Update() {}
+
+DaemonConnection::DaemonConnection(int socket) : mySocket(socket) {}
+DaemonConnection::~DaemonConnection() {}
+unique_ptr<DaemonConnection> DaemonConnection::Connect(const string& path) { return nullptr; }
+ReadDataResult DaemonConnection::Get(SensorValuesReport& report) { return ReadDataResult::FAILURE; }
+bool DaemonConnection::GetFeature(uint8_t* report, size_t size) { return false; }
+bool DaemonConnection::SendFeature(const uint8_t* report, size_t size) { return false; }
+bool DaemonConnection::SendOutput(uint8_t reportId) { return false; }
+
+#else
+
+static bool WouldBlock()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+static bool MakeAddress(const string& path, sockaddr_un& address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path))
+		return false;
+
+	memcpy(address.sun_path, path.c_str(), path.size());
+	return true;
+}
+
+bool IsDaemonRunning(const string& path)
+{
+	sockaddr_un address;
+	if (!MakeAddress(path, address))
+		return false;
+
+	int s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s < 0)
+		return false;
+
+	bool running = connect(s, (const sockaddr*)&address, sizeof(address)) == 0;
+	close(s);
+	return running;
+}
+
+// ====================================================================================================================
+// Daemon.
+// ====================================================================================================================
+
+struct DaemonClient
+{
+	int socket = -1;
+	bool closed = false;
+	vector<uint8_t> received;
+
+	deque<Message> queue;
+	size_t queuedBytes = 0;
+	size_t sendOffset = 0;
+	uint64_t droppedInput = 0;
+
+	// Selection properties as this client last set them.
+	map<uint32_t, uint32_t> selection;
+
+	// Whether the client began a transaction (TransactionReport) it did not commit yet.
+	bool inTransaction = false;
+
+	struct Request
+	{
+		uint8_t type;
+		vector<uint8_t> payload;
+	};
+	deque<Request> requests;
+};
+
+class DaemonServer
+{
+public:
+	DaemonServer(int listener, const string& path)
+		: myListener(listener)
+		, myPath(path)
+	{
+		Device::SetInputListener([this](const SensorValuesReport& report) { myInput.push_back(report); });
+	}
+
+	~DaemonServer()
+	{
+		Device::SetInputListener(nullptr);
+
+		for (auto& client : myClients)
+			close(client->socket);
+
+		close(myListener);
+		unlink(myPath.c_str());
+	}
+
+	int NumClients() const { return (int)myClients.size(); }
+
+	void Update()
+	{
+		Accept();
+
+		bool padConnected = Device::Pad() != nullptr;
+		if (padConnected != myPadConnected)
+		{
+			myPadConnected = padConnected;
+			myDeviceSelection.clear();
+			myIdentification.clear();
+			myInput.clear();
+
+			// The pad commits open transactions when it reconnects.
+			myOpenTransactions = 0;
+			for (auto& client : myClients)
+				client->inTransaction = false;
+
+			uint8_t status = padConnected ? 1 : 0;
+			auto message = EncodeMessage(DAEMON_STATUS, &status, 1);
+			for (auto& client : myClients)
+				Queue(*client, message, false);
+		}
+
+		for (auto& client : myClients)
+			Receive(*client);
+
+		ServeRequests();
+		SendInput();
+
+		for (auto& client : myClients)
+			Flush(*client);
+
+		for (auto it = myClients.begin(); it != myClients.end();)
+		{
+			if ((*it)->closed)
+			{
+				if (myPadConnected)
+					SetTransaction(**it, false);
+				Log::Writef(L"Daemon :: client disconnected, %llu input reports dropped", (unsigned long long)(*it)->droppedInput);
+				close((*it)->socket);
+				it = myClients.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+private:
+	void Accept()
+	{
+		while (true)
+		{
+			int s = accept(myListener, nullptr, nullptr);
+			if (s < 0)
+				return;
+
+			fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+
+			auto client = make_unique<DaemonClient>();
+			client->socket = s;
+
+			uint8_t status = Device::Pad() ? 1 : 0;
+			Queue(*client, EncodeMessage(DAEMON_STATUS, &status, 1), false);
+
+			myClients.push_back(move(client));
+			Log::Writef(L"Daemon :: client connected (%i)", (int)myClients.size());
+		}
+	}
+
+	// Input is dropped for clients that are too far behind, other messages are always queued.
+	void Queue(DaemonClient& client, const Message& message, bool isInput)
+	{
+		if (isInput && client.queuedBytes + message->size() > DAEMON_MAX_QUEUED_BYTES)
+		{
+			client.droppedInput += (message->size() - DAEMON_HEADER_SIZE) / sizeof(SensorValuesReport);
+			return;
+		}
+
+		client.queue.push_back(message);
+		client.queuedBytes += message->size();
+	}
+
+	void Reply(DaemonClient& client, bool success, const uint8_t* report = nullptr, size_t size = 0)
+	{
+		vector<uint8_t> payload;
+		payload.reserve(1 + size);
+		payload.push_back(success ? 1 : 0);
+		if (report)
+			payload.insert(payload.end(), report, report + size);
+
+		Queue(client, EncodeMessage(DAEMON_REPLY, payload.data(), payload.size()), false);
+	}
+
+	void Receive(DaemonClient& client)
+	{
+		uint8_t buffer[4096];
+		while (!client.closed)
+		{
+			auto size = recv(client.socket, buffer, sizeof(buffer), 0);
+			if (size == 0 || (size < 0 && !WouldBlock()))
+				client.closed = true;
+			if (size <= 0)
+				break;
+
+			client.received.insert(client.received.end(), buffer, buffer + size);
+			ParseMessages(client.received, [&](uint8_t type, const uint8_t* payload, size_t size)
+			{
+				client.requests.push_back({ type, vector<uint8_t>(payload, payload + size) });
+			});
+
+			if (client.received.size() >= MAX_REQUEST_SIZE)
+			{
+				Log::Write(L"Daemon :: dropped a client that sent a message longer than any request");
+				client.closed = true;
+			}
+		}
+	}
+
+	void Flush(DaemonClient& client)
+	{
+		while (!client.closed && !client.queue.empty())
+		{
+			auto& message = *client.queue.front();
+			auto sent = send(client.socket, message.data() + client.sendOffset, message.size() - client.sendOffset, MSG_NOSIGNAL);
+			if (sent < 0)
+			{
+				if (!WouldBlock())
+					client.closed = true;
+				return;
+			}
+
+			client.sendOffset += sent;
+			if (client.sendOffset < message.size())
+				return;
+
+			client.queuedBytes -= message.size();
+			client.queue.pop_front();
+			client.sendOffset = 0;
+		}
+	}
+
+	// Reports that are read from the pad according to a selection property.
+	static int SelectionProperty(uint8_t reportId)
+	{
+		switch (reportId)
+		{
+		case REPORT_LIGHT_RULE: return SetPropertyReport::SELECTED_LIGHT_RULE_INDEX;
+		case REPORT_LED_MAPPING: return SetPropertyReport::SELECTED_LED_MAPPING_INDEX;
+		case REPORT_SENSOR: return SetPropertyReport::SELECTED_SENSOR_INDEX;
+		case REPORT_BUTTON: return SetPropertyReport::SELECTED_BUTTON_INDEX;
+		}
+		return -1;
+	}
+
+	static bool IsSelectionProperty(uint32_t propertyId)
+	{
+		return propertyId == SetPropertyReport::SELECTED_LIGHT_RULE_INDEX
+			|| propertyId == SetPropertyReport::SELECTED_LED_MAPPING_INDEX
+			|| propertyId == SetPropertyReport::SELECTED_SENSOR_INDEX
+			|| propertyId == SetPropertyReport::SELECTED_BUTTON_INDEX;
+	}
+
+	// Makes the pad select what the client selected, if the property matters for the report.
+	bool ApplySelection(DaemonClient& client, uint8_t reportId)
+	{
+		int property = SelectionProperty(reportId);
+		if (property < 0)
+			return true;
+
+		auto selected = client.selection.find(property);
+		uint32_t value = selected != client.selection.end() ? selected->second : 0;
+
+		auto current = myDeviceSelection.find(property);
+		if (current != myDeviceSelection.end() && current->second == value)
+			return true;
+
+		SetPropertyReport report;
+		for (int i = 0; i < 4; ++i)
+		{
+			report.propertyId.bytes[i] = (property >> (i * 8)) & 0xFF;
+			report.propertyValue.bytes[i] = (value >> (i * 8)) & 0xFF;
+		}
+
+		if (!Device::SendFeatureReport(reinterpret_cast<const uint8_t*>(&report), sizeof(report)))
+			return false;
+
+		myDeviceSelection[property] = value;
+		return true;
+	}
+
+	// Runs the requests one at a time, taking one request of every client in turn.
+	void ServeRequests()
+	{
+		// Answers of this round, by report id and selection, so identical requests cost one transfer.
+		map<pair<uint8_t, uint32_t>, vector<uint8_t>> answers;
+
+		bool pending = true;
+		while (pending)
+		{
+			pending = false;
+			for (auto& client : myClients)
+			{
+				if (client->requests.empty() || client->closed)
+					continue;
+
+				auto request = move(client->requests.front());
+				client->requests.pop_front();
+				pending |= !client->requests.empty();
+
+				if (!Device::Pad())
+				{
+					Reply(*client, false);
+					continue;
+				}
+
+				switch (request.type)
+				{
+				case DAEMON_GET_FEATURE:
+					ServeGet(*client, request.payload, answers);
+					break;
+				case DAEMON_SEND_FEATURE:
+					ServeSend(*client, request.payload);
+					answers.clear();
+					break;
+				case DAEMON_SEND_OUTPUT:
+					Reply(*client, request.payload.size() == 1 && Device::SendOutputReport(request.payload[0]));
+					answers.clear();
+					break;
+				default:
+					Log::Writef(L"Daemon :: unknown request %i", request.type);
+					client->closed = true;
+					break;
+				}
+			}
+		}
+	}
+
+	void ServeGet(DaemonClient& client, vector<uint8_t>& report, map<pair<uint8_t, uint32_t>, vector<uint8_t>>& answers)
+	{
+		if (report.empty() || report.size() > MAX_REPORT_SIZE)
+		{
+			Reply(client, false);
+			return;
+		}
+
+		uint8_t reportId = report[0];
+		bool isIdentification = (reportId == REPORT_IDENTIFICATION || reportId == REPORT_IDENTIFICATION_V2);
+
+		auto cached = myIdentification.find(reportId);
+		if (isIdentification && cached != myIdentification.end() && cached->second.size() == report.size())
+		{
+			Reply(client, true, cached->second.data(), cached->second.size());
+			return;
+		}
+
+		int property = SelectionProperty(reportId);
+		uint32_t selection = property >= 0 && client.selection.count(property) ? client.selection[property] : 0;
+		auto key = make_pair(reportId, selection);
+
+		auto answer = answers.find(key);
+		if (answer != answers.end() && answer->second.size() == report.size())
+		{
+			Reply(client, true, answer->second.data(), answer->second.size());
+			return;
+		}
+
+		if (!ApplySelection(client, reportId) || !Device::GetFeatureReport(report.data(), report.size()))
+		{
+			Reply(client, false);
+			return;
+		}
+
+		// Raw samples are not passed on, clients should not offer them.
+		if (reportId == REPORT_IDENTIFICATION_V2 && report.size() >= sizeof(IdentificationV2Report))
+		{
+			auto& features = reinterpret_cast<IdentificationV2Report*>(report.data())->features;
+			features.bytes[1] &= (uint8_t)~(IdentificationV2Report::FEATURE_RAW_ADC >> 8);
+		}
+
+		answers[key] = report;
+		if (isIdentification)
+			myIdentification[reportId] = report;
+
+		Reply(client, true, report.data(), report.size());
+	}
+
+	void ServeSend(DaemonClient& client, const vector<uint8_t>& report)
+	{
+		if (report.empty() || report.size() > MAX_REPORT_SIZE)
+		{
+			Reply(client, false);
+			return;
+		}
+
+		// Selections are sent to the pad when a request depends on them, not when the client makes them.
+		if (report[0] == REPORT_SET_PROPERTY && report.size() == sizeof(SetPropertyReport))
+		{
+			uint32_t property = ReadU32LE(&report[1]);
+			if (IsSelectionProperty(property))
+			{
+				client.selection[property] = ReadU32LE(&report[5]);
+				Reply(client, true);
+				return;
+			}
+
+			// Every client reads the input of the daemon, which passes packed input on as scans, so the format stays
+			// as the daemon chose it. Raw samples are not passed on at all, the identification leaves out FEATURE_RAW_ADC.
+			if (property == SetPropertyReport::INPUT_REPORT_FORMAT)
+			{
+				Reply(client, ReadU32LE(&report[5]) != SetPropertyReport::INPUT_FORMAT_RAW_ADC);
+				return;
+			}
+		}
+
+		if (report[0] == REPORT_TRANSACTION && report.size() == sizeof(TransactionReport))
+		{
+			Reply(client, SetTransaction(client, report[1] == TransactionReport::BEGIN));
+			return;
+		}
+
+		Reply(client, Device::SendFeatureReport(report.data(), report.size()));
+	}
+
+	// The pad has one transaction for all clients. It begins with the first client that begins one and is committed
+	// once the last of them commits or disconnects.
+	bool SetTransaction(DaemonClient& client, bool begin)
+	{
+		if (client.inTransaction == begin)
+			return true;
+
+		client.inTransaction = begin;
+		myOpenTransactions += begin ? 1 : -1;
+		if (myOpenTransactions != (begin ? 1 : 0))
+			return true;
+
+		TransactionReport report;
+		report.action = begin ? TransactionReport::BEGIN : TransactionReport::COMMIT;
+		return Device::SendFeatureReport(reinterpret_cast<const uint8_t*>(&report), sizeof(report));
+	}
+
+	void SendInput()
+	{
+		if (myInput.empty())
+			return;
+
+		// One message for every update, shared by all clients.
+		size_t count = min(myInput.size(), (0xFFFF) / sizeof(SensorValuesReport));
+		auto message = EncodeMessage(DAEMON_INPUT, reinterpret_cast<const uint8_t*>(myInput.data()), count * sizeof(SensorValuesReport));
+		myInput.clear();
+
+		for (auto& client : myClients)
+			Queue(*client, message, true);
+	}
+
+	int myListener;
+	string myPath;
+	vector<unique_ptr<DaemonClient>> myClients;
+	vector<SensorValuesReport> myInput;
+	bool myPadConnected = false;
+	map<uint32_t, uint32_t> myDeviceSelection;
+	map<uint8_t, vector<uint8_t>> myIdentification;
+	int myOpenTransactions = 0;
+};
+
+static DaemonServer* daemonServer = nullptr;
+
+bool Daemon::Start(const char* path)
+{
+	Stop();
+
+	sockaddr_un address;
+	if (!MakeAddress(path, address))
+	{
+		Log::Writef(L"Daemon :: invalid socket path %hs", path);
+		return false;
+	}
+
+	int s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s < 0)
+		return false;
+
+	// A socket file without a daemon behind it is left over from a daemon that did not stop cleanly.
+	if (IsDaemonRunning(path))
+	{
+		Log::Writef(L"Daemon :: another daemon is serving %hs", path);
+		close(s);
+		return false;
+	}
+	unlink(path);
+
+	if (::bind(s, (const sockaddr*)&address, sizeof(address)) != 0 || listen(s, 16) != 0)
+	{
+		Log::Writef(L"Daemon :: could not listen on %hs", path);
+		close(s);
+		return false;
+	}
+
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+	daemonServer = new DaemonServer(s, path);
+
+	Log::Writef(L"Daemon :: serving %hs", path);
+	return true;
+}
+
+void Daemon::Stop()
+{
+	delete daemonServer;
+	daemonServer = nullptr;
+}
+
+bool Daemon::IsRunning()
+{
+	return daemonServer != nullptr;
+}
+
+int Daemon::NumClients()
+{
+	return daemonServer ? daemonServer->NumClients() : 0;
+}
+
+void Daemon::Update()
+{
+	if (daemonServer)
+		daemonServer->Update();
+}
+
+// ====================================================================================================================
+// Daemon connection.
+// ====================================================================================================================
+
+DaemonConnection::DaemonConnection(int socket)
+	: mySocket(socket)
+{
+}
+
+DaemonConnection::~DaemonConnection()
+{
+	close(mySocket);
+}
+
+unique_ptr<DaemonConnection> DaemonConnection::Connect(const string& path)
+{
+	sockaddr_un address;
+	if (!MakeAddress(path, address))
+		return nullptr;
+
+	int s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s < 0)
+		return nullptr;
+
+	if (connect(s, (const sockaddr*)&address, sizeof(address)) != 0)
+	{
+		close(s);
+		return nullptr;
+	}
+
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+	unique_ptr<DaemonConnection> connection(new DaemonConnection(s));
+
+	// The daemon starts with its status, only keep the connection if it has a pad to offer.
+	if (!connection->Receive(REQUEST_TIMEOUT_MS) || !connection->myIsConnected || !connection->myPadConnected)
+		return nullptr;
+
+	return connection;
+}
+
+// Reads what the daemon sent, waits up to the timeout if nothing is available. Returns false if nothing was read.
+bool DaemonConnection::Receive(int timeoutMs)
+{
+	if (!myIsConnected)
+		return false;
+
+	if (timeoutMs > 0)
+	{
+		pollfd entry = { mySocket, POLLIN, 0 };
+		if (poll(&entry, 1, timeoutMs) <= 0)
+			return false;
+	}
+
+	uint8_t buffer[16384];
+	bool received = false;
+	while (true)
+	{
+		auto size = recv(mySocket, buffer, sizeof(buffer), 0);
+		if (size == 0 || (size < 0 && !WouldBlock()))
+		{
+			Log::Write(L"DaemonConnection :: daemon closed the connection");
+			myIsConnected = false;
+			break;
+		}
+		if (size < 0)
+			break;
+
+		myReceived.insert(myReceived.end(), buffer, buffer + size);
+		received = true;
+	}
+
+	ParseMessages(myReceived, [&](uint8_t type, const uint8_t* payload, size_t size)
+	{
+		HandleMessage(type, payload, size);
+	});
+
+	return received;
+}
+
+void DaemonConnection::HandleMessage(uint8_t type, const uint8_t* payload, size_t size)
+{
+	switch (type)
+	{
+	case DAEMON_STATUS:
+		myPadConnected = size > 0 && payload[0] != 0;
+		if (!myPadConnected)
+			myInput.clear();
+		break;
+
+	case DAEMON_INPUT:
+		for (size_t offset = 0; offset + sizeof(SensorValuesReport) <= size; offset += sizeof(SensorValuesReport))
+		{
+			if (myInput.size() == MAX_CLIENT_INPUT)
+				myInput.pop_front();
+
+			myInput.emplace_back();
+			memcpy(&myInput.back(), payload + offset, sizeof(SensorValuesReport));
+		}
+		break;
+
+	case DAEMON_REPLY:
+		myReply.assign(payload, payload + size);
+		myHasReply = true;
+		break;
+	}
+}
+
+bool DaemonConnection::Request(uint8_t type, const uint8_t* payload, size_t size)
+{
+	if (!myIsConnected || !myPadConnected)
+		return false;
+
+	vector<uint8_t> message;
+	PutHeader(message, type, size);
+	message.insert(message.end(), payload, payload + size);
+
+	// Requests are small, wait for the socket instead of keeping a send queue.
+	size_t offset = 0;
+	while (offset < message.size())
+	{
+		auto sent = send(mySocket, message.data() + offset, message.size() - offset, MSG_NOSIGNAL);
+		if (sent < 0)
+		{
+			pollfd entry = { mySocket, POLLOUT, 0 };
+			if (!WouldBlock() || poll(&entry, 1, REQUEST_TIMEOUT_MS) <= 0)
+			{
+				myIsConnected = false;
+				return false;
+			}
+			continue;
+		}
+		offset += sent;
+	}
+
+	// Input that arrives meanwhile is kept for Get.
+	myHasReply = false;
+	while (!myHasReply)
+	{
+		if (!Receive(REQUEST_TIMEOUT_MS) && !myHasReply)
+		{
+			Log::Write(L"DaemonConnection :: no reply from the daemon");
+			myIsConnected = false;
+			return false;
+		}
+	}
+
+	return !myReply.empty() && myReply[0] != 0;
+}
+
+ReadDataResult DaemonConnection::Get(SensorValuesReport& report)
+{
+	if (myInput.empty())
+		Receive(0);
+
+	if (!myInput.empty())
+	{
+		report = myInput.front();
+		myInput.pop_front();
+		return ReadDataResult::SUCCESS;
+	}
+
+	return (myIsConnected && myPadConnected) ? ReadDataResult::NO_DATA : ReadDataResult::FAILURE;
+}
+
+bool DaemonConnection::GetFeature(uint8_t* report, size_t size)
+{
+	if (!Request(DAEMON_GET_FEATURE, report, size) || myReply.size() != size + 1)
+		return false;
+
+	memcpy(report, myReply.data() + 1, size);
+	return true;
+}
+
+bool DaemonConnection::SendFeature(const uint8_t* report, size_t size)
+{
+	return Request(DAEMON_SEND_FEATURE, report, size);
+}
+
+bool DaemonConnection::SendOutput(uint8_t reportId)
+{
+	return Request(DAEMON_SEND_OUTPUT, &reportId, 1);
+}
+
+#endif
+
+}; // namespace adp.
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Daemon mode: one process owns the pad and serves it to other processes over a Unix domain socket, so the ui, the
+// command line and the web bridge can run side by side. Clients use the daemon as the backend of their Reporter,
+// every report goes through it as is and the rest of the model works as with a local pad.
+//
+// Messages in both directions start with a header: u8 type, u8 reserved, u16 payload size (little endian).
+//
+//   DAEMON_STATUS        daemon to client, u8 pad connected. Sent on connect and when the pad comes or goes.
+//   DAEMON_INPUT         daemon to client, the input reports read since the last update as whole SensorValuesReports.
+//   DAEMON_GET_FEATURE   client to daemon, the report with its id in the first byte, answered with DAEMON_REPLY.
+//   DAEMON_SEND_FEATURE  client to daemon, the report to send, answered with DAEMON_REPLY.
+//   DAEMON_SEND_OUTPUT   client to daemon, u8 report id of an output report, answered with DAEMON_REPLY.
+//   DAEMON_REPLY         daemon to client, u8 success followed by the report for DAEMON_GET_FEATURE.
+//
+// Clients wait for the reply to each request. The daemon runs the requests of all clients one at a time on the thread
+// that updates the device, so the transfers never overlap. Input reports are read once and shared by every client.
+// Identical feature requests of different clients in the same update are answered with one transfer, and the
+// identification, which cannot change, is read once per pad. Selection properties (SetPropertyReport) are kept per
+// client and only sent to the pad before a request that depends on them. Transactions (TransactionReport) of several
+// clients share the one of the pad, which is committed when the last client commits or disconnects. A client that
+// falls behind on input misses input reports, it never holds up the others. Raw ADC samples are not passed on, the
+// identification clients read does not have FEATURE_RAW_ADC.
+
+enum DaemonMessageType
+{
+	DAEMON_STATUS       = 1,
+	DAEMON_INPUT        = 2,
+	DAEMON_GET_FEATURE  = 3,
+	DAEMON_SEND_FEATURE = 4,
+	DAEMON_SEND_OUTPUT  = 5,
+	DAEMON_REPLY        = 6,
+};
+
+constexpr size_t DAEMON_HEADER_SIZE = 4;
+constexpr size_t DAEMON_MAX_QUEUED_BYTES = 256 * 1024;
+
+// $ADP_DAEMON_SOCKET if set, otherwise adp.sock in $XDG_RUNTIME_DIR or /tmp/adp-<uid>.sock.
+std::string DaemonSocketPath();
+
+// True if a daemon accepts connections at the path.
+bool IsDaemonRunning(const std::string& path);
+
+// The serving side, driven by the process that owns the pad.
+class Daemon
+{
+public:
+	static bool Start(const char* path);
+
+	static void Stop();
+
+	static bool IsRunning();
+
+	static int NumClients();
+
+	// Serves pending requests and sends the input read since the last call, call after Device::Update.
+	static void Update();
+};
+
+// The client side, the backend of a Reporter in processes that use the daemon.
+class DaemonConnection
+{
+public:
+	~DaemonConnection();
+
+	// Returns null if the daemon is not running or has no pad.
+	static std::unique_ptr<DaemonConnection> Connect(const std::string& path);
+
+	ReadDataResult Get(SensorValuesReport& report);
+
+	// Raw ADC samples are not passed on, the daemon keeps the pad on its own input report format.
+	ReadDataResult Get(RawAdcReport&) { return ReadDataResult::NO_DATA; }
+
+	bool GetFeature(uint8_t* report, size_t size);
+	bool SendFeature(const uint8_t* report, size_t size);
+	bool SendOutput(uint8_t reportId);
+
+	template <typename T>
+	bool Get(T& report) { return GetFeature(reinterpret_cast<uint8_t*>(&report), sizeof(T)); }
+
+	template <typename T>
+	bool Send(const T& report) { return SendFeature(reinterpret_cast<const uint8_t*>(&report), sizeof(T)); }
+
+private:
+	DaemonConnection(int socket);
+
+	bool Request(uint8_t type, const uint8_t* payload, size_t size);
+	bool Receive(int timeoutMs);
+	void HandleMessage(uint8_t type, const uint8_t* payload, size_t size);
+
+	int mySocket;
+	bool myIsConnected = true; // false once the daemon or its pad is gone
+	bool myPadConnected = false;
+	std::vector<uint8_t> myReceived;
+	std::deque<SensorValuesReport> myInput;
+	std::vector<uint8_t> myReply;
+	bool myHasReply = false;
+};
+
+}; // namespace adp.
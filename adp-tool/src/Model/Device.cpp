@@ -3,8 +3,11 @@
 #include <memory>
 #include <algorithm>
 #include <map>
+#include <deque>
 #include <chrono>
 #include <thread>
+#include <cstdio>
+#include <cmath>
 
 #include "hidapi.h"
 
@@ -13,7 +16,12 @@
 #include "Model/Log.h"
 #include "Model/Utils.h"
 #include "Model/Firmware.h"
-#include "Model/Updater.h"
+#include "Model/Version.h"
+#include "Model/Recorder.h"
+#include "Model/Replay.h"
+#include "Model/SharedState.h"
+#include "Model/Daemon.h"
+#include "Model/Emulator.h"
 
 using namespace std;
 using namespace chrono;
@@ -35,6 +43,16 @@ constexpr HidIdentifier HID_IDS[] =
 
 static_assert(sizeof(float) == sizeof(uint32_t), "32-bit float required");
 
+// Raw ADC samples kept until they are read, a few seconds at the rate of the firmware.
+constexpr size_t MAX_RAW_ADC_SAMPLES = 1 << 17;
+
+// Interval of reading the profiling counters and baselines of the firmware for metrics.
+constexpr auto FIRMWARE_READ_INTERVAL = 5s;
+
+static Recorder* recorder = nullptr;
+static SharedStateWriter* sharedState = nullptr;
+static function<void(const SensorValuesReport&)> inputListener;
+
 enum LedMappingFlags
 {
 	LMF_ENABLED = 1 << 0,
@@ -56,44 +74,10 @@ static bool IsBitSet(int bits, int index)
 	return (bits & (1 << index)) != 0;
 }
 
-static int ReadU16LE(uint16_le u16)
-{
-	return u16.bytes[0] | u16.bytes[1] << 8;
-}
-
-static uint32_t ReadU32LE(uint32_le u32)
-{
-	return u32.bytes[0] | (u32.bytes[1] << 8) | (u32.bytes[2] << 16) | (u32.bytes[3] << 24);
-}
-
-static float ReadF32LE(float32_le f32)
-{
-	uint32_t u32 = ReadU32LE(f32.bits);
-	return *reinterpret_cast<float*>(&u32);
-}
-
-static uint16_le WriteU16LE(int value)
-{
-	uint16_le u16;
-	u16.bytes[0] = value & 0xFF;
-	u16.bytes[1] = (value >> 8) & 0xFF;
-	return u16;
-}
-
-static uint32_le WriteU32LE(uint32_t value)
-{
-	uint32_le u32;
-	u32.bytes[0] = value & 0xFF;
-	u32.bytes[1] = (value >> 8) & 0xFF;
-	u32.bytes[2] = (value >> 16) & 0xFF;
-	u32.bytes[3] = (value >> 24) & 0xFF;
-	return u32;
-}
-
-static float32_le WriteF32LE(float value)
+static uint32_t ToMicroseconds(steady_clock::duration d)
 {
-	uint32_t u32 = *reinterpret_cast<uint32_t*>(&value);
-	return { WriteU32LE(u32) };
+	auto us = duration_cast<microseconds>(d).count();
+	return (uint32_t)clamp<int64_t>(us, 0, UINT32_MAX);
 }
 
 template <typename T>
@@ -119,6 +103,39 @@ static color24 ToColor24(RgbColor color)
 	return { color.red, color.green, color.blue };
 }
 
+RgbColor::RgbColor(const string& input)
+	:red(0), green(0), blue(0)
+{
+	unsigned int r = 0, g = 0, b = 0;
+	char end = 0;
+
+	if (input.size() == 7 && input[0] == '#' && sscanf(input.c_str() + 1, "%2x%2x%2x%c", &r, &g, &b, &end) == 3)
+	{
+		// #RRGGBB
+	}
+	else if (input.size() == 4 && input[0] == '#' && sscanf(input.c_str() + 1, "%1x%1x%1x%c", &r, &g, &b, &end) == 3)
+	{
+		r *= 0x11;
+		g *= 0x11;
+		b *= 0x11;
+	}
+	else if (sscanf(input.c_str(), " %*1[rR]%*1[gG]%*1[bB] ( %u , %u , %u )", &r, &g, &b) != 3 || r > 255 || g > 255 || b > 255)
+	{
+		return;
+	}
+
+	red = (uint8_t)r;
+	green = (uint8_t)g;
+	blue = (uint8_t)b;
+}
+
+const string RgbColor::ToString() const
+{
+	char buffer[8];
+	snprintf(buffer, sizeof(buffer), "#%02X%02X%02X", red, green, blue);
+	return buffer;
+}
+
 SensorReport SensorState::ToReport(int index)
 {
 	SensorReport report;
@@ -128,10 +145,24 @@ SensorReport SensorState::ToReport(int index)
 	report.releaseThreshold = WriteU16LE(ToDeviceSensorValue(releaseThreshold));
 	report.resistorValue = resistorValue;
 	report.buttonMapping = button == 0 ? 0xFF : (button - 1);
+	report.flags = WriteU16LE(flags);
 
 	return report;
 }
 
+int SensorState::JoystickAxis() const
+{
+	if (!(flags & SensorReport::JOYSTICK_AXIS))
+		return -1;
+
+	return (flags & SensorReport::JOYSTICK_AXIS_MASK) >> SensorReport::JOYSTICK_AXIS_SHIFT;
+}
+
+JoystickCurve SensorState::GetJoystickCurve() const
+{
+	return (JoystickCurve)((flags & SensorReport::JOYSTICK_CURVE_MASK) >> SensorReport::JOYSTICK_CURVE_SHIFT);
+}
+
 static void PrintPadConfigurationReport(const PadConfigurationReport& padConfiguration)
 {
 	Log::Write(L"pad configuration [");
@@ -182,6 +213,59 @@ static void PrintSensorReport(const SensorReport& r)
 	Log::Write(L"]");
 }
 
+static wstring DecodeDebugRecords(const uint8_t* data, int size)
+{
+	wstring result;
+	wchar_t line[128];
+
+	for (int pos = 0; pos < size;)
+	{
+		uint8_t event = data[pos];
+
+		if (event == DEBUG_EVENT_MESSAGE)
+		{
+			if (pos + 2 > size)
+				break;
+
+			int length = min((int)data[pos + 1], size - pos - 2);
+			result += widen((const char*)data + pos + 2, length);
+			pos += 2 + length;
+			continue;
+		}
+
+		DebugTraceRecord record;
+		if (pos + (int)sizeof(record) > size)
+			break;
+
+		memcpy(&record, data + pos, sizeof(record));
+		pos += sizeof(record);
+
+		int timestamp = ReadU16LE(record.timestamp);
+		int arg0 = ReadU16LE(record.args[0]);
+		int arg1 = ReadU16LE(record.args[1]);
+
+		switch (event)
+		{
+		case DEBUG_EVENT_PRESS:
+			swprintf(line, 128, L"[%5ius] button %i pressed (value %i)\n", timestamp, arg0 + 1, arg1);
+			break;
+		case DEBUG_EVENT_RELEASE:
+			swprintf(line, 128, L"[%5ius] button %i released\n", timestamp, arg0 + 1);
+			break;
+		case DEBUG_EVENT_SCAN_TIME:
+			swprintf(line, 128, L"[%5ius] scan time %ius (max %ius)\n", timestamp, arg0, arg1);
+			break;
+		default:
+			swprintf(line, 128, L"[%5ius] event %i (%i, %i)\n", timestamp, event, arg0, arg1);
+			break;
+		}
+
+		result += line;
+	}
+
+	return result;
+}
+
 // ====================================================================================================================
 // Pad device.
 // ====================================================================================================================
@@ -194,6 +278,24 @@ struct PollingData
 	int readsSinceLastUpdate = 0;
 	int pollingRate = 0;
 	time_point<system_clock> lastUpdate;
+
+	time_point<steady_clock> lastArrival;
+	Histogram intervals;
+	Histogram batchSizes;
+	Histogram deviceIntervals;
+	Histogram latency;
+};
+
+// Bookkeeping for the sequence numbers and timestamps of the extended input report.
+struct ReportTracking
+{
+	bool started = false;
+	uint16_t lastSequence = 0;
+	uint32_t lastTimestamp = 0;
+	int64_t deviceTime = 0; // device timestamp in us, extended past the 32-bit wrap around
+	int64_t minOffset = 0; // lowest host minus device time in the current window
+	int64_t previousMinOffset = 0; // lowest host minus device time in the previous window
+	time_point<steady_clock> windowStart;
 };
 
 class PadDevice
@@ -206,7 +308,8 @@ public:
 		const IdentificationV2Report& identification,
 		const vector<LightRuleReport>& lightRules,
 		const vector<LedMappingReport>& ledMappings,
-		const vector<SensorReport>& sensors)
+		const vector<SensorReport>& sensors,
+		const vector<ButtonReport>& buttons)
 		: myReporter(move(reporter))
 		, myPath(path)
 	{
@@ -229,14 +332,39 @@ public:
 
 		uint16_t features = ReadU16LE(identification.features);
 		myPad.featureDebug = (features & IdentificationV2Report::FEATURE_DEBUG) != 0;
+		myPad.featureDebugTrace = (features & IdentificationV2Report::FEATURE_DEBUG_TRACE) != 0;
+		myPad.featureExtendedInput = (features & IdentificationV2Report::FEATURE_EXTENDED_INPUT) != 0;
 		myPad.featureDigipot = (features & IdentificationV2Report::FEATURE_DIGIPOT) != 0;
 		myPad.featureLights = (features & IdentificationV2Report::FEATURE_LIGHTS) != 0;
+		myPad.featureProfiling = (features & IdentificationV2Report::FEATURE_PROFILING) != 0;
+		myPad.featureBaseline = (features & IdentificationV2Report::FEATURE_BASELINE) != 0;
+		myPad.featureJoystickAxes = (features & IdentificationV2Report::FEATURE_JOYSTICK_AXES) != 0;
+		myPad.featureButtonModes = (features & IdentificationV2Report::FEATURE_BUTTON_MODES) != 0;
+		myPad.featureTransactions = (features & IdentificationV2Report::FEATURE_TRANSACTIONS) != 0;
+		myPad.featureSofSync = (features & IdentificationV2Report::FEATURE_SOF_SYNC) != 0;
+		myPad.featureRawAdc = (features & IdentificationV2Report::FEATURE_RAW_ADC) != 0;
+		myPad.featurePackedInput = (features & IdentificationV2Report::FEATURE_PACKED_INPUT) != 0;
+
+		// A host that died between begin and commit left the transaction open, the pad would stage everything sent
+		// until its timeout. A commit without an open transaction does nothing.
+		if (myPad.featureTransactions)
+		{
+			TransactionReport report;
+			report.action = TransactionReport::COMMIT;
+			if (!myReporter->Send(report))
+				Log::Write(L"PadDevice :: could not commit a pending transaction");
+		}
 
 		for (auto sensor : sensors)
 		{
 			UpdateSensor(sensor);
 		}
 
+		for (auto& button : buttons)
+		{
+			UpdateButton(button);
+		}
+
 		if (myPad.firmwareVersion.IsNewer({ 1, 2 })) {
 			myPad.releaseThreshold = mySensors[0].releaseThreshold / mySensors[0].threshold;
 		}
@@ -246,11 +374,23 @@ public:
 
 		UpdateLightsConfiguration(lightRules, ledMappings);
 		myPollingData.lastUpdate = system_clock::now();
+		myLastStatisticsMinute = myPollingData.lastUpdate;
+
+		if (myPad.featureExtendedInput || myPad.featurePackedInput)
+		{
+			if (SetInputFormat(PreferredInputFormat()))
+				myIsPackedInput = myPad.featurePackedInput;
+			else
+				Log::Write(L"PadDevice :: could not enable the extended input report");
+		}
 	}
 
 	~PadDevice()
 	{
-
+		// The formats other than the default are for this tool, the pad keeps its format until it is reconnected.
+		// Nothing to report if the pad is already gone.
+		if (myInputFormat != SetPropertyReport::INPUT_FORMAT_DEFAULT)
+			SetInputFormat(SetPropertyReport::INPUT_FORMAT_DEFAULT);
 	}
 
 	void UpdateName(const NameReport& report)
@@ -313,20 +453,52 @@ public:
 
 	bool UpdateSensorValues()
 	{
+		if (myIsStreamingRawAdc)
+			return UpdateRawAdc();
+
 		SensorValuesReport report;
 
 		int aggregateValues[MAX_SENSOR_COUNT] = {};
 		int pressedButtons = 0;
 		int inputsRead = 0;
+		int reportsRead = 0;
+		time_point<steady_clock> arrival;
+		bool isNewReport;
+		int buttons;
+
+		// Buttons of the sensors, for the statistics of every report.
+		int buttonMasks[MAX_SENSOR_COUNT];
+		for (int i = 0; i < myPad.numSensors; ++i)
+			buttonMasks[i] = mySensors[i].button > 0 ? (1 << (mySensors[i].button - 1)) : 0;
 
 		for (int readsLeft = 100; readsLeft > 0; --readsLeft)
 		{
 			switch (myReporter->Get(report))
 			{
 			case ReadDataResult::SUCCESS:
-				pressedButtons |= ReadU16LE(report.buttonBits);
+				arrival = steady_clock::now();
+				isNewReport = !IsFurtherScan(report);
+				if (isNewReport)
+				{
+					if (myReportStats.received > 0)
+						myPollingData.intervals.Record(ToMicroseconds(arrival - myPollingData.lastArrival));
+					myPollingData.lastArrival = arrival;
+					++reportsRead;
+				}
+				TrackReport(report, arrival, isNewReport);
+				recorder->Push(report, arrival);
+				if (inputListener)
+					inputListener(report);
+				sharedState->Publish(report, duration_cast<microseconds>(arrival.time_since_epoch()).count(),
+					myReportStats.received, myPad.numSensors, mySensors);
+				buttons = ReadU16LE(report.buttonBits);
+				pressedButtons |= buttons;
 				for (int i = 0; i < myPad.numSensors; ++i)
-					aggregateValues[i] += ReadU16LE(report.sensorValues[i]);
+				{
+					int value = ReadU16LE(report.sensorValues[i]);
+					aggregateValues[i] += value;
+					myStatistics[i].Add(value, (buttons & buttonMasks[i]) != 0);
+				}
 				++inputsRead;
 				break;
 
@@ -339,6 +511,8 @@ public:
 			}
 		}
 
+		myPollingData.batchSizes.Record(reportsRead);
+
 		if (inputsRead > 0)
 		{
 			for (int i = 0; i < myPad.numSensors; ++i)
@@ -347,11 +521,25 @@ public:
 				auto value = (double)aggregateValues[i] / (double)inputsRead;
 				mySensors[i].pressed = button > 0 && IsBitSet(pressedButtons, button - 1);
 				mySensors[i].value = ToNormalizedSensorValue(value);
+				myStatistics[i].Summarize(mySensors[i].statistics);
 			}
-			myPollingData.readsSinceLastUpdate += inputsRead;
 		}
 
+		myPollingData.readsSinceLastUpdate += reportsRead;
+		UpdateTimers();
+		return true;
+	}
+
+	void UpdateTimers()
+	{
 		auto now = system_clock::now();
+		if (now > myLastStatisticsMinute + 1min)
+		{
+			for (int i = 0; i < myPad.numSensors; ++i)
+				myStatistics[i].NextMinute();
+			myLastStatisticsMinute = now;
+		}
+
 		if (now > myPollingData.lastUpdate + 1s)
 		{
 			auto dt = duration<double>(now - myPollingData.lastUpdate).count();
@@ -360,14 +548,222 @@ public:
 			myPollingData.lastUpdate = now;
 		}
 
+		// Reading the counters every few seconds also keeps them from wrapping around, see FirmwareProfile.
+		if (now > myLastFirmwareRead + FIRMWARE_READ_INTERVAL)
+		{
+			FirmwareProfile profile;
+			myHasProfile = ReadProfile(profile) || myHasProfile;
+			myHasBaselines = ReadBaselines(myBaselines) || myHasBaselines;
+			myLastFirmwareRead = now;
+		}
+
 		// Use the loop to save changes if needed
 		if (myHasUnsavedChanges && duration_cast<std::chrono::milliseconds>(now - myLastPendingChange).count() > 2000) {
 			SaveChanges();
 		}
+	}
+
+	// Packed input reports give every scan of the pad, extended ones let the host detect dropped reports.
+	int PreferredInputFormat() const
+	{
+		if (myPad.featurePackedInput)
+			return SetPropertyReport::INPUT_FORMAT_PACKED;
+		if (myPad.featureExtendedInput)
+			return SetPropertyReport::INPUT_FORMAT_EXTENDED;
+		return SetPropertyReport::INPUT_FORMAT_DEFAULT;
+	}
+
+	bool SetInputFormat(int format)
+	{
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(SetPropertyReport::INPUT_REPORT_FORMAT);
+		report.propertyValue = WriteU32LE(format);
+		if (!myReporter->Send(report))
+			return false;
+
+		myInputFormat = format;
+		return true;
+	}
+
+	bool StartRawAdc(int sensor)
+	{
+		if (!myPad.featureRawAdc || sensor >= myPad.numSensors)
+			return false;
+
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(SetPropertyReport::RAW_ADC_SENSOR);
+		report.propertyValue = WriteU32LE(sensor < 0 ? RawAdcReport::ALL_SENSORS : sensor);
+		if (!myReporter->Send(report) || !SetInputFormat(SetPropertyReport::INPUT_FORMAT_RAW_ADC))
+		{
+			Log::Write(L"PadDevice :: could not start streaming raw ADC samples");
+			return false;
+		}
+
+		// Like the buttons of the pad, the sensors are released while it is not scanned.
+		for (int i = 0; i < myPad.numSensors; ++i)
+		{
+			mySensors[i].pressed = false;
+			mySensors[i].value = 0.0;
+		}
+
+		myIsStreamingRawAdc = true;
+		myRawAdcSamples.clear();
+		myRawAdcTime = -1;
+		return true;
+	}
+
+	void StopRawAdc()
+	{
+		if (!myIsStreamingRawAdc)
+			return;
+
+		myIsStreamingRawAdc = false;
+		myRawAdcSamples.clear();
+		if (!SetInputFormat(PreferredInputFormat()))
+			Log::Write(L"PadDevice :: could not restore the input report format");
+	}
+
+	bool IsStreamingRawAdc() const { return myIsStreamingRawAdc; }
+
+	void ReadRawAdc(vector<RawAdcSample>& samples)
+	{
+		samples.assign(myRawAdcSamples.begin(), myRawAdcSamples.end());
+		myRawAdcSamples.clear();
+	}
+
+	bool UpdateRawAdc()
+	{
+		RawAdcReport report;
+		int reportsRead = 0;
+
+		for (int readsLeft = 100; readsLeft > 0; --readsLeft)
+		{
+			switch (myReporter->Get(report))
+			{
+			case ReadDataResult::SUCCESS:
+				AddRawAdcSamples(report);
+				++reportsRead;
+				break;
+
+			case ReadDataResult::NO_DATA:
+				readsLeft = 0;
+				break;
+
+			case ReadDataResult::FAILURE:
+				return false;
+			}
+		}
 
+		myPollingData.readsSinceLastUpdate += reportsRead;
+		UpdateTimers();
 		return true;
 	}
 
+	void AddRawAdcSamples(const RawAdcReport& report)
+	{
+		int count = min<int>(report.count, RawAdcReport::MAX_SAMPLES);
+		bool allSensors = (report.sensor == RawAdcReport::ALL_SENSORS);
+		int scanSize = allSensors ? max(1, myPad.numSensors) : 1;
+		int steps = count / scanSize;
+		if (steps == 0)
+			return;
+
+		// Extends the device clock past its wrap around, relative to the first report.
+		uint32_t timestamp = ReadU32LE(report.timestamp);
+		myRawAdcTime = (myRawAdcTime < 0) ? 0 : myRawAdcTime + (uint32_t)(timestamp - myRawAdcTimestamp);
+		myRawAdcTimestamp = timestamp;
+
+		int duration = ReadU16LE(report.duration);
+		for (int i = 0; i < steps * scanSize; ++i)
+		{
+			int bit = i * RawAdcReport::SAMPLE_BITS;
+			int packed = report.samples[bit / 8] | (report.samples[bit / 8 + 1] << 8);
+
+			RawAdcSample sample;
+			sample.sensor = allSensors ? i % scanSize : report.sensor;
+			sample.value = (packed >> (bit % 8)) & ((1 << RawAdcReport::SAMPLE_BITS) - 1);
+			sample.time = myRawAdcTime + (steps > 1 ? (int64_t)duration * (i / scanSize) / (steps - 1) : 0);
+			myRawAdcSamples.push_back(sample);
+		}
+
+		// Samples nobody reads are dropped, oldest first.
+		while (myRawAdcSamples.size() > MAX_RAW_ADC_SAMPLES)
+			myRawAdcSamples.pop_front();
+	}
+
+	// The scans of a packed input report arrive together, with the sequence number of their report.
+	bool IsFurtherScan(const SensorValuesReport& report) const
+	{
+		return myIsPackedInput && myReportTracking.started && report.reportId == REPORT_SENSOR_VALUES_EXTENDED
+			&& (uint16_t)ReadU16LE(report.sequence) == myReportTracking.lastSequence;
+	}
+
+	void TrackReport(const SensorValuesReport& report, time_point<steady_clock> arrival, bool isNewReport)
+	{
+		if (isNewReport)
+			++myReportStats.received;
+
+		if (report.reportId != REPORT_SENSOR_VALUES_EXTENDED)
+			return;
+
+		auto& tracking = myReportTracking;
+		uint16_t sequence = (uint16_t)ReadU16LE(report.sequence);
+		uint32_t timestamp = ReadU32LE(report.timestamp);
+
+		bool first = !tracking.started;
+		if (first)
+		{
+			tracking.started = true;
+			tracking.deviceTime = timestamp;
+			tracking.windowStart = arrival;
+			myReportStats.extended = true;
+		}
+		else
+		{
+			// A huge jump backwards means the device restarted its counter, not that 65k reports were lost.
+			uint16_t missing = (uint16_t)(sequence - tracking.lastSequence - 1);
+			if (isNewReport && missing > 0 && missing < 0x8000)
+			{
+				myReportStats.dropped += missing;
+				myReportStats.gaps += 1;
+				myReportStats.largestGap = max(myReportStats.largestGap, (int)missing);
+			}
+			uint32_t deviceInterval = timestamp - tracking.lastTimestamp;
+			tracking.deviceTime += deviceInterval;
+			myPollingData.deviceIntervals.Record(deviceInterval);
+		}
+		tracking.lastSequence = sequence;
+		tracking.lastTimestamp = timestamp;
+
+		// The clocks of the device and host are not synchronized, so the absolute latency is unknown. The lowest
+		// host minus device time seen over the last two windows serves as zero latency, which also follows the slow
+		// drift between both clocks.
+		int64_t hostTime = duration_cast<microseconds>(arrival.time_since_epoch()).count();
+		int64_t offset = hostTime - tracking.deviceTime;
+		if (first)
+		{
+			tracking.minOffset = offset;
+			tracking.previousMinOffset = offset;
+		}
+		else if (arrival > tracking.windowStart + 10s)
+		{
+			tracking.previousMinOffset = tracking.minOffset;
+			tracking.minOffset = offset;
+			tracking.windowStart = arrival;
+		}
+		else
+		{
+			tracking.minOffset = min(tracking.minOffset, offset);
+		}
+
+		int64_t relativeOffset = offset - min(tracking.minOffset, tracking.previousMinOffset);
+		myPollingData.latency.Record((uint32_t)min<int64_t>(relativeOffset, UINT32_MAX));
+
+		double latency = relativeOffset / 1000.0;
+		myReportStats.latency += (latency - myReportStats.latency) * 0.01;
+		myReportStats.maxLatency = max(myReportStats.maxLatency, latency);
+	}
+
 	bool SetThreshold(int sensorIndex, double threshold)
 	{
 		mySensors[sensorIndex].threshold = threshold;
@@ -382,8 +778,31 @@ public:
 		}
 	}
 
+	void BeginTransaction()
+	{
+		if (!myPad.featureTransactions || myTransactionDepth++ > 0)
+			return;
+
+		TransactionReport report;
+		report.action = TransactionReport::BEGIN;
+		if (!myReporter->Send(report))
+			Log::Write(L"PadDevice :: could not begin a transaction");
+	}
+
+	void CommitTransaction()
+	{
+		if (myTransactionDepth == 0 || --myTransactionDepth > 0)
+			return;
+
+		TransactionReport report;
+		report.action = TransactionReport::COMMIT;
+		if (!myReporter->Send(report))
+			Log::Write(L"PadDevice :: could not commit a transaction");
+	}
+
 	bool SetReleaseThreshold(double threshold)
 	{
+		Transaction transaction(this);
 		myPad.releaseThreshold = clamp(threshold, 0.01, 1.00);
 
 		// From v1.3 we have the SensorReport. Before that it's the PadConfiguration report
@@ -395,6 +814,13 @@ public:
 				}
 			}
 
+			for (int i = 0; myPad.featureButtonModes && i < myPad.numButtons; ++i) {
+				myButtons[i].releaseThreshold = myButtons[i].threshold * myPad.releaseThreshold;
+				if (!SendButton(i)) {
+					return false;
+				}
+			}
+
 			return true;
 		}
 		else {
@@ -402,6 +828,119 @@ public:
 		}
 	}
 
+	bool SetBaselineTracking(bool enabled)
+	{
+		if (!myPad.featureBaseline)
+			return false;
+
+		Transaction transaction(this);
+		for (int i = 0; i < myPad.numSensors; ++i)
+		{
+			auto& flags = mySensors[i].flags;
+			flags = enabled ? (flags | SensorReport::BASELINE_TRACKING) : (flags & ~SensorReport::BASELINE_TRACKING);
+			if (!SendSensor(i))
+				return false;
+		}
+		return true;
+	}
+
+	bool SetJoystickAxis(int sensorIndex, int axis, JoystickCurve curve)
+	{
+		if (!myPad.featureJoystickAxes)
+			return false;
+
+		auto& flags = mySensors[sensorIndex].flags;
+		flags &= ~(SensorReport::JOYSTICK_AXIS | SensorReport::JOYSTICK_AXIS_MASK | SensorReport::JOYSTICK_CURVE_MASK);
+		if (axis >= 0 && axis < JOYSTICK_AXIS_COUNT)
+		{
+			flags |= SensorReport::JOYSTICK_AXIS;
+			flags |= axis << SensorReport::JOYSTICK_AXIS_SHIFT;
+			flags |= (curve << SensorReport::JOYSTICK_CURVE_SHIFT) & SensorReport::JOYSTICK_CURVE_MASK;
+		}
+		myChanges |= DCF_BUTTON_MAPPING;
+
+		return SendSensor(sensorIndex);
+	}
+
+	bool SetButtonMode(int buttonIndex, ButtonMode mode, int count)
+	{
+		if (!myPad.featureButtonModes || buttonIndex < 0 || buttonIndex >= myPad.numButtons)
+			return false;
+
+		myButtons[buttonIndex].mode = mode;
+		myButtons[buttonIndex].count = clamp(count, 1, MAX_SENSOR_COUNT);
+		myChanges |= DCF_BUTTON_MAPPING;
+
+		return SendButton(buttonIndex);
+	}
+
+	bool SetButtonThreshold(int buttonIndex, double threshold)
+	{
+		if (!myPad.featureButtonModes || buttonIndex < 0 || buttonIndex >= myPad.numButtons)
+			return false;
+
+		myButtons[buttonIndex].threshold = threshold;
+		myButtons[buttonIndex].releaseThreshold = threshold * myPad.releaseThreshold;
+
+		return SendButton(buttonIndex);
+	}
+
+	bool SetSensorWeight(int sensorIndex, double weight)
+	{
+		if (!myPad.featureButtonModes)
+			return false;
+
+		mySensors[sensorIndex].weight = weight;
+		myChanges |= DCF_BUTTON_MAPPING;
+
+		// The pad only takes the weights of the sensors mapped to the button, others are sent once they are mapped.
+		int button = mySensors[sensorIndex].button;
+		return button > 0 ? SendButton(button - 1) : true;
+	}
+
+	void UpdateButton(const ButtonReport& button)
+	{
+		if (button.index >= myPad.numButtons || button.mode > ButtonReport::MODE_K_OF_N) {
+			return;
+		}
+
+		// Sum thresholds go above MAX_SENSOR_VALUE, they are not clamped like sensor values.
+		constexpr double scalar = 1.0 / (double)MAX_SENSOR_VALUE;
+		auto& state = myButtons[button.index];
+		state.mode = (ButtonMode)button.mode;
+		state.count = button.count;
+		state.threshold = ReadU16LE(button.threshold) * scalar;
+		state.releaseThreshold = ReadU16LE(button.releaseThreshold) * scalar;
+
+		// Every button report carries the weights of all sensors.
+		for (int i = 0; i < myPad.numSensors; ++i)
+			mySensors[i].weight = button.sensorWeights[i] / (double)ButtonReport::WEIGHT_ONE;
+	}
+
+	bool SendButton(int buttonIndex)
+	{
+		const auto& state = myButtons[buttonIndex];
+
+		ButtonReport report;
+		report.index = (uint8_t)buttonIndex;
+		report.mode = (uint8_t)state.mode;
+		report.count = (uint8_t)state.count;
+		report.threshold = WriteU16LE(clamp<long>(lround(state.threshold * MAX_SENSOR_VALUE), 0, UINT16_MAX));
+		report.releaseThreshold = WriteU16LE(clamp<long>(lround(state.releaseThreshold * MAX_SENSOR_VALUE), 0, UINT16_MAX));
+		memset(report.sensorWeights, 0, sizeof(report.sensorWeights));
+		for (int i = 0; i < myPad.numSensors; ++i)
+			report.sensorWeights[i] = (uint8_t)clamp<long>(lround(mySensors[i].weight * ButtonReport::WEIGHT_ONE), 0, UINT8_MAX);
+
+		bool success = myReporter->Send(report);
+
+		if (success) {
+			NotifyUnsavedChanges();
+			UpdateButton(report);
+		}
+
+		return success;
+	}
+
 	bool SetAdcConfig(int sensorIndex, int resistorValue)
 	{
 		mySensors[sensorIndex].resistorValue = resistorValue;
@@ -419,6 +958,7 @@ public:
 		mySensors[sensor.index].releaseThreshold = ToNormalizedSensorValue(ReadU16LE(sensor.releaseThreshold));
 		mySensors[sensor.index].resistorValue = sensor.resistorValue;
 		mySensors[sensor.index].button = (sensor.buttonMapping >= myPad.numButtons ? 0 : (sensor.buttonMapping + 1));
+		mySensors[sensor.index].flags = ReadU16LE(sensor.flags);
 	}
 
 	bool SendSensor(int sensorIndex)
@@ -441,12 +981,16 @@ public:
 		myChanges |= DCF_BUTTON_MAPPING;
 
 		// From v1.3 we have the SensorReport. Before that it's the PadConfiguration report
-		if (myPad.firmwareVersion.IsNewer({ 1, 2 })) {
-			return SendSensor(sensorIndex);
-		}
-		else {
+		if (!myPad.firmwareVersion.IsNewer({ 1, 2 })) {
 			return SendPadConfiguration();
 		}
+
+		if (!SendSensor(sensorIndex)) {
+			return false;
+		}
+
+		// The pad only takes the weight of a sensor from reports of the button it is mapped to.
+		return (myPad.featureButtonModes && button > 0) ? SendButton(button - 1) : true;
 	}
 
 	bool SendName(const char* name)
@@ -591,8 +1135,83 @@ public:
 
 	const DevicePath& Path() const { return myPath; }
 
+	bool IsVirtual() const { return myReporter->IsVirtual(); }
+
+	Reporter& GetReporter() { return *myReporter; }
+
 	const int PollingRate() const { return myPollingData.pollingRate; }
 
+	const ReportStats& Reports() const { return myReportStats; }
+
+	const FirmwareProfile* Profile() const { return myHasProfile ? &myProfile : nullptr; }
+
+	const FirmwareBaselines* Baselines() const { return myHasBaselines ? &myBaselines : nullptr; }
+
+	PollingSummary PollingStats() const
+	{
+		PollingSummary summary;
+		summary.intervals = myPollingData.intervals.Summary();
+		summary.batchSizes = myPollingData.batchSizes.Summary();
+		summary.deviceIntervals = myPollingData.deviceIntervals.Summary();
+		summary.latency = myPollingData.latency.Summary();
+		return summary;
+	}
+
+	void ResetPollingStats()
+	{
+		myPollingData.intervals.Reset();
+		myPollingData.batchSizes.Reset();
+		myPollingData.deviceIntervals.Reset();
+		myPollingData.latency.Reset();
+	}
+
+	void ResetSensorStatistics()
+	{
+		for (int i = 0; i < myPad.numSensors; ++i)
+		{
+			myStatistics[i].Reset();
+			myStatistics[i].Summarize(mySensors[i].statistics);
+		}
+	}
+
+	bool ReadProfile(FirmwareProfile& profile)
+	{
+		ProfilingReport report;
+		if (!myPad.featureProfiling || !myReporter->Get(report))
+			return false;
+
+		// Extends the counters past their wrap around by adding the difference to the previous read.
+		auto& last = myLastProfilingReport;
+		bool first = (last.reportId != REPORT_PROFILING);
+		myProfile.frames += ReadU32LE(report.frames) - (first ? 0 : ReadU32LE(last.frames));
+		myProfile.scans += ReadU32LE(report.scans) - (first ? 0 : ReadU32LE(last.scans));
+		myProfile.scanTime += ReadU32LE(report.scanTime) - (first ? 0 : ReadU32LE(last.scanTime));
+		myProfile.configurations += (uint16_t)(ReadU16LE(report.configurations) - (first ? 0 : ReadU16LE(last.configurations)));
+		myProfile.maxScanTime = ReadU16LE(report.maxScanTime);
+		myProfile.reports += ReadU32LE(report.reports) - (first ? 0 : ReadU32LE(last.reports));
+		myProfile.reportAge += ReadU32LE(report.reportAge) - (first ? 0 : ReadU32LE(last.reportAge));
+		myProfile.maxReportAge = ReadU16LE(report.maxReportAge);
+		last = report;
+
+		profile = myProfile;
+		return true;
+	}
+
+	bool ReadBaselines(FirmwareBaselines& baselines)
+	{
+		BaselineReport report;
+		if (!myPad.featureBaseline || !myReporter->Get(report))
+			return false;
+
+		for (int i = 0; i < myPad.numSensors; ++i)
+		{
+			baselines.baselines[i] = ToNormalizedSensorValue(ReadU16LE(report.baselines[i]));
+			// Offsets are signed, so not clamped like sensor values.
+			baselines.offsets[i] = (int16_t)ReadU16LE(report.offsets[i]) / (double)MAX_SENSOR_VALUE;
+		}
+		return true;
+	}
+
 	const PadState& State() const { return myPad; }
 
 	const LightsState& Lights() const { return myLights; }
@@ -602,6 +1221,11 @@ public:
 		return (index >= 0 && index < myPad.numSensors) ? (mySensors + index) : nullptr;
 	}
 
+	const ButtonState* Button(int index)
+	{
+		return (myPad.featureButtonModes && index >= 0 && index < myPad.numButtons) ? (myButtons + index) : nullptr;
+	}
+
 	wstring ReadDebug()
 	{
 		if (!myPad.featureDebug) {
@@ -613,13 +1237,18 @@ public:
 			return L"";
 		}
 
-		int messageSize = ReadU16LE(report.messageSize);
+		int messageSize = min(ReadU16LE(report.messageSize), (int)sizeof(report.messagePacket));
 
 		if (messageSize == 0) {
 			return L"";
 		}
 
-		return widen(report.messagePacket, messageSize);
+		// Older firmware sends plain text, newer firmware sends trace records.
+		if (!myPad.featureDebugTrace) {
+			return widen((const char*)report.messagePacket, messageSize);
+		}
+
+		return DecodeDebugRecords(report.messagePacket, messageSize);
 	}
 
 	DeviceChanges PopChanges()
@@ -635,15 +1264,41 @@ public:
 	}
 
 private:
+	// Keeps a transaction of the pad open for its lifetime, like DeviceTransaction.
+	struct Transaction
+	{
+		Transaction(PadDevice* pad) : pad(pad) { pad->BeginTransaction(); }
+		~Transaction() { pad->CommitTransaction(); }
+		PadDevice* pad;
+	};
+
 	unique_ptr<Reporter> myReporter;
 	DevicePath myPath;
 	PadState myPad;
 	LightsState myLights;
 	SensorState mySensors[MAX_SENSOR_COUNT];
+	ButtonState myButtons[MAX_BUTTON_COUNT];
+	int myTransactionDepth = 0;
 	DeviceChanges myChanges = 0;
 	bool myHasUnsavedChanges = false;
 	time_point<system_clock> myLastPendingChange;
 	PollingData myPollingData;
+	ReportTracking myReportTracking;
+	ReportStats myReportStats;
+	SensorStatisticsTracker myStatistics[MAX_SENSOR_COUNT];
+	time_point<system_clock> myLastStatisticsMinute;
+	ProfilingReport myLastProfilingReport = {0};
+	FirmwareProfile myProfile;
+	bool myHasProfile = false;
+	FirmwareBaselines myBaselines;
+	bool myHasBaselines = false;
+	time_point<system_clock> myLastFirmwareRead;
+	bool myIsPackedInput = false;
+	int myInputFormat = SetPropertyReport::INPUT_FORMAT_DEFAULT;
+	bool myIsStreamingRawAdc = false;
+	deque<RawAdcSample> myRawAdcSamples;
+	int64_t myRawAdcTime = -1;
+	uint32_t myRawAdcTimestamp = 0;
 };
 
 // ====================================================================================================================
@@ -659,6 +1314,14 @@ static bool ContainsDevice(hid_device_info* devices, DevicePath path)
 	return false;
 }
 
+static void AddReporterErrors(ReporterErrors& total, const ReporterErrors& errors)
+{
+	total.reads += errors.reads;
+	total.gets += errors.gets;
+	total.sends += errors.sends;
+	total.writes += errors.writes;
+}
+
 class ConnectionManager
 {
 public:
@@ -674,7 +1337,18 @@ public:
 	{
 		if(emulator) {
 			auto reporter = make_unique<Reporter>();
-			return ConnectToDeviceStage2(reporter, NULL);
+			return ConnectToDeviceStage2(reporter, NULL, "Dummy");
+		}
+
+		// In daemon mode the pad is only used through the daemon, which owns it.
+		if (!myDaemonPath.empty())
+		{
+			auto connection = DaemonConnection::Connect(myDaemonPath);
+			if (!connection)
+				return false;
+
+			auto reporter = make_unique<Reporter>(move(connection));
+			return ConnectToDeviceStage2(reporter, NULL, ("daemon:" + myDaemonPath).c_str());
 		}
 
 		auto foundDevices = hid_enumerate(0x0, 0x0);
@@ -751,6 +1425,7 @@ public:
 		auto reporter = make_unique<Reporter>(hid);
 		bool result = ConnectToDeviceStage2(reporter, deviceInfo);
 		if(!result) {
+			AddErrors(reporter->Errors());
 			AddIncompatibleDevice(deviceInfo);
 			// hid_close already happend becuase Reporter gets destructed
 			return false;
@@ -759,7 +1434,27 @@ public:
 		return result;
 	}
 
-	bool ConnectToDeviceStage2(unique_ptr<Reporter>& reporter, hid_device_info* deviceInfo)
+	bool ConnectToEmulator(const EmulatorSettings& settings)
+	{
+		Disconnect();
+
+		auto reporter = make_unique<Reporter>(make_unique<Emulator>(settings));
+		return ConnectToDeviceStage2(reporter, NULL, "Emulator");
+	}
+
+	bool ConnectToReplay(const char* path, bool realtime)
+	{
+		auto replay = make_unique<Replay>(realtime);
+		if (!replay->Open(path))
+			return false;
+
+		Disconnect();
+
+		auto reporter = make_unique<Reporter>(move(replay));
+		return ConnectToDeviceStage2(reporter, NULL, path);
+	}
+
+	bool ConnectToDeviceStage2(unique_ptr<Reporter>& reporter, hid_device_info* deviceInfo, const char* virtualPath = "")
 	{
 		NameReport name;
 		IdentificationReport padIdentification;
@@ -840,13 +1535,10 @@ public:
 			}
 		}
 
-		string devicePath = "";
+		string devicePath = virtualPath;
 		if(deviceInfo != NULL) {
 			devicePath = deviceInfo->path;
 		}
-		else if(emulator) {
-			devicePath = "Dummy";
-		}
 
 		SensorReport sensorReport;
 		if (padVersion.IsNewer({ 1, 2 })) {
@@ -883,6 +1575,20 @@ public:
 			}
 		}
 
+		vector<ButtonReport> buttons;
+		if (ReadU16LE(padIdentificationV2.features) & IdentificationV2Report::FEATURE_BUTTON_MODES) {
+			SetPropertyReport selectReport;
+			selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_BUTTON_INDEX);
+
+			ButtonReport buttonReport;
+			for (int i = 0; i < padIdentificationV2.buttonCount; ++i)
+			{
+				selectReport.propertyValue = WriteU32LE(i);
+				if (reporter->Send(selectReport) && reporter->Get(buttonReport))
+					buttons.push_back(buttonReport);
+			}
+		}
+
 		auto device = new PadDevice(
 			reporter,
 			devicePath.c_str(),
@@ -890,7 +1596,8 @@ public:
 			padIdentificationV2,
 			lightRules,
 			ledMappings,
-			sensors);
+			sensors,
+			buttons);
 
 		Log::Write(L"ConnectionManager :: new device connected [");
 		Log::Writef(L"  Name: %hs", device->State().name.c_str());
@@ -904,32 +1611,72 @@ public:
 		}
 		else {
 			Log::Writef(L"  Product: Dummy");
+			Log::Writef(L"  Path: %hs", devicePath.c_str());
 		}
 		Log::Write(L"]");
 
 		myConnectedDevice.reset(device);
+		++myStats.connects;
 		return true;
 	}
 
+	void Disconnect()
+	{
+		if (myConnectedDevice)
+		{
+			myConnectedDevice->SaveChanges();
+			AddErrors(myConnectedDevice->GetReporter().Errors());
+			myConnectedDevice.reset();
+		}
+	}
+
 	void DisconnectFailedDevice()
 	{
 		auto device = myConnectedDevice.get();
 		if (device)
 		{
 			myFailedDevices[device->Path()] = device->State().name;
+			++myStats.failures;
+			AddErrors(device->GetReporter().Errors());
 			myConnectedDevice.reset();
 		}
 	}
 
+	// The errors of the connected pad count as well, they are only added to the totals once it is gone.
+	ConnectionStats Stats() const
+	{
+		auto stats = myStats;
+		stats.failedDevices = (int)myFailedDevices.size();
+		if (myConnectedDevice)
+			AddReporterErrors(stats.errors, myConnectedDevice->GetReporter().Errors());
+		return stats;
+	}
+
+	void AddErrors(const ReporterErrors& errors)
+	{
+		AddReporterErrors(myStats.errors, errors);
+	}
+
+	void UseDaemon(const char* path)
+	{
+		Disconnect();
+		myDaemonPath = path ? path : "";
+	}
+
 	void AddIncompatibleDevice(hid_device_info* device)
 	{
 		if (device->product_string) // Can be null on failure, apparently.
+		{
 			myFailedDevices[device->path] = narrow(device->product_string, wcslen(device->product_string));
+			++myStats.failures;
+		}
 	}
 
 private:
 	unique_ptr<PadDevice> myConnectedDevice;
+	ConnectionStats myStats;
 	map<DevicePath, DeviceName> myFailedDevices;
+	string myDaemonPath;
 	bool emulator = false;
 };
 
@@ -945,12 +1692,20 @@ void Device::Init()
 	hid_init();
 
 	connectionManager = new ConnectionManager();
+	recorder = new Recorder();
+	sharedState = new SharedStateWriter();
 
 	searching = true;
 }
 
 void Device::Shutdown()
 {
+	delete sharedState;
+	sharedState = nullptr;
+
+	delete recorder;
+	recorder = nullptr;
+
 	delete connectionManager;
 	connectionManager = nullptr;
 
@@ -982,6 +1737,9 @@ DeviceChanges Device::Update()
 		}
 	}
 
+	if (!connectionManager->ConnectedDevice())
+		sharedState->Disconnect();
+
 	return changes;
 }
 
@@ -991,6 +1749,167 @@ int Device::PollingRate()
 	return device ? device->PollingRate() : 0;
 }
 
+const ReportStats* Device::Reports()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? &device->Reports() : nullptr;
+}
+
+PollingSummary Device::PollingStats()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->PollingStats() : PollingSummary();
+}
+
+void Device::ResetPollingStats()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device)
+		device->ResetPollingStats();
+}
+
+void Device::ResetSensorStatistics()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device)
+		device->ResetSensorStatistics();
+}
+
+ConnectionStats Device::Connections()
+{
+	return connectionManager->Stats();
+}
+
+bool Device::ReadProfile(FirmwareProfile& profile)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->ReadProfile(profile) : false;
+}
+
+bool Device::ReadBaselines(FirmwareBaselines& baselines)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->ReadBaselines(baselines) : false;
+}
+
+const FirmwareProfile* Device::Profile()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->Profile() : nullptr;
+}
+
+const FirmwareBaselines* Device::Baselines()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->Baselines() : nullptr;
+}
+
+bool Device::StartRawAdc(int sensor)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->StartRawAdc(sensor) : false;
+}
+
+void Device::StopRawAdc()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device)
+		device->StopRawAdc();
+}
+
+bool Device::IsStreamingRawAdc()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->IsStreamingRawAdc() : false;
+}
+
+void Device::ReadRawAdc(vector<RawAdcSample>& samples)
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device)
+		device->ReadRawAdc(samples);
+	else
+		samples.clear();
+}
+
+bool Device::StartRecording(const char* path)
+{
+	auto device = connectionManager->ConnectedDevice();
+	int sensorCount = device ? device->State().numSensors : MAX_SENSOR_COUNT;
+	uint8_t flags = (device && device->State().featureExtendedInput) ? RECORDING_FLAG_EXTENDED_INPUT : 0;
+	return recorder->Start(path, sensorCount, flags);
+}
+
+void Device::StopRecording()
+{
+	recorder->Stop();
+}
+
+bool Device::IsRecording()
+{
+	return recorder->IsRecording();
+}
+
+bool Device::StartSharing(const char* name)
+{
+	return sharedState->Start(name);
+}
+
+void Device::StopSharing()
+{
+	sharedState->Stop();
+}
+
+bool Device::IsSharing()
+{
+	return sharedState->IsRunning();
+}
+
+void Device::UseDaemon(const char* path)
+{
+	connectionManager->UseDaemon(path);
+}
+
+bool Device::GetFeatureReport(uint8_t* report, size_t size)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->GetReporter().GetFeature(report, size) : false;
+}
+
+bool Device::SendFeatureReport(const uint8_t* report, size_t size)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->GetReporter().SendFeature(report, size) : false;
+}
+
+bool Device::SendOutputReport(uint8_t reportId)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->GetReporter().SendOutput(reportId) : false;
+}
+
+void Device::SetInputListener(function<void(const SensorValuesReport&)> listener)
+{
+	inputListener = move(listener);
+}
+
+bool Device::OpenReplay(const char* path, bool realtime)
+{
+	return connectionManager->ConnectToReplay(path, realtime);
+}
+
+bool Device::StartEmulator(const EmulatorSettings& settings)
+{
+	return connectionManager->ConnectToEmulator(settings);
+}
+
+void Device::CloseVirtualDevice()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device && device->IsVirtual())
+		connectionManager->Disconnect();
+}
+
 const PadState* Device::Pad()
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1009,6 +1928,12 @@ const SensorState* Device::Sensor(int sensorIndex)
 	return device ? device->Sensor(sensorIndex) : nullptr;
 }
 
+const ButtonState* Device::Button(int buttonIndex)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->Button(buttonIndex) : nullptr;
+}
+
 wstring Device::ReadDebug()
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1033,6 +1958,12 @@ bool Device::SetReleaseThreshold(double threshold)
 	return device ? device->SetReleaseThreshold(threshold) : false;
 }
 
+bool Device::SetBaselineTracking(bool enabled)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetBaselineTracking(enabled) : false;
+}
+
 bool Device::SetAdcConfig(int sensorIndex, int resistorValue)
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1045,6 +1976,30 @@ bool Device::SetButtonMapping(int sensorIndex, int button)
 	return device ? device->SetButtonMapping(sensorIndex, button) : false;
 }
 
+bool Device::SetJoystickAxis(int sensorIndex, int axis, JoystickCurve curve)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetJoystickAxis(sensorIndex, axis, curve) : false;
+}
+
+bool Device::SetButtonMode(int buttonIndex, ButtonMode mode, int count)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetButtonMode(buttonIndex, mode, count) : false;
+}
+
+bool Device::SetButtonThreshold(int buttonIndex, double threshold)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetButtonThreshold(buttonIndex, threshold) : false;
+}
+
+bool Device::SetSensorWeight(int sensorIndex, double weight)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetSensorWeight(sensorIndex, weight) : false;
+}
+
 bool Device::SetDeviceName(const char* name)
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1093,6 +2048,18 @@ void Device::SaveChanges()
 	if (device) device->SaveChanges();
 }
 
+void Device::BeginTransaction()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device) device->BeginTransaction();
+}
+
+void Device::CommitTransaction()
+{
+	auto device = connectionManager->ConnectedDevice();
+	if (device) device->CommitTransaction();
+}
+
 void Device::SetSearching(bool s)
 {
 	searching = s;
@@ -1100,6 +2067,8 @@ void Device::SetSearching(bool s)
 
 void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 {
+	DeviceTransaction transaction;
+
 	if((groups & DPG_LIGHTS) > 0 && Pad()->featureLights) {
 		if(j["ledMappings"].is_array()) {
 			for(int key = 0; key < j["ledMappings"].size(); key++) {
@@ -1154,6 +2123,33 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 			if (groups & DPG_MAPPING && sensor.contains("resistorValue") && Pad()->featureDigipot) {
 				SetAdcConfig(key, sensor["resistorValue"]);
 			}
+
+			if (groups & DPG_MAPPING && sensor.contains("joystickAxis") && Pad()->featureJoystickAxes) {
+				int curve = sensor.value("joystickCurve", 0);
+				SetJoystickAxis(key, sensor["joystickAxis"], (JoystickCurve)curve);
+			}
+
+			if (groups & DPG_MAPPING && sensor.contains("weight") && Pad()->featureButtonModes) {
+				SetSensorWeight(key, sensor["weight"]);
+			}
+		}
+	}
+
+	if (j["buttons"].is_array() && Pad()->featureButtonModes) {
+		for (int key = 0; key < j["buttons"].size(); key++) {
+			auto button = j["buttons"][key];
+
+			if (groups & DPG_MAPPING && button.contains("mode")) {
+				auto mode = button["mode"];
+				if (mode.is_number_integer() && mode >= BUTTON_MODE_ANY && mode <= BUTTON_MODE_K_OF_N)
+					SetButtonMode(key, (ButtonMode)(int)mode, button.value("count", 2));
+				else
+					Log::Writef(L"LoadProfile :: button %i has an invalid mode (%hs) and was skipped", key + 1, mode.dump().c_str());
+			}
+
+			if (groups & DPG_SENSITIVITY && button.contains("threshold")) {
+				SetButtonThreshold(key, button["threshold"]);
+			}
 		}
 	}
 
@@ -1161,17 +2157,19 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 		if(j["releaseThreshold"].is_number()) {
 			SetReleaseThreshold(j["releaseThreshold"]);
 		}
+		if(j["baselineTracking"].is_boolean() && Pad()->featureBaseline) {
+			SetBaselineTracking(j["baselineTracking"]);
+		}
 	}
 
-	if(groups & DPG_DEVICE) {
-		string name = j["name"];
+	if(groups & DPG_DEVICE && j["name"].is_string()) {
 		SetDeviceName( ((std::string)j["name"]).c_str() );
 	}
 }
 
 void Device::SaveProfile(json& j, DeviceProfileGroups groups)
 {
-	j["adpToolVersion"] = wxString::Format("v%i.%i", ADP_VERSION_MAJOR, ADP_VERSION_MINOR);
+	j["adpToolVersion"] = "v" + to_string(ADP_VERSION_MAJOR) + "." + to_string(ADP_VERSION_MINOR);
 
 	if((groups & DPG_LIGHTS) && Pad()->featureLights && Lights()) {
 		auto lights = Lights();
@@ -1208,10 +2206,37 @@ void Device::SaveProfile(json& j, DeviceProfileGroups groups)
 			if (groups & DPG_MAPPING) {
 				j["sensors"][i]["button"] = Device::Sensor(i)->button;
 				j["sensors"][i]["resistorValue"] = Device::Sensor(i)->resistorValue;
+
+				if (Device::Pad()->featureJoystickAxes) {
+					j["sensors"][i]["joystickAxis"] = Device::Sensor(i)->JoystickAxis();
+					j["sensors"][i]["joystickCurve"] = (int)Device::Sensor(i)->GetJoystickCurve();
+				}
+
+				if (Device::Pad()->featureButtonModes) {
+					j["sensors"][i]["weight"] = Device::Sensor(i)->weight;
+				}
 			}
 		}
 
 		j["releaseThreshold"] = Device::Pad()->releaseThreshold;
+
+		if (Device::Pad()->featureBaseline && Device::Pad()->numSensors > 0)
+			j["baselineTracking"] = (Device::Sensor(0)->flags & SensorReport::BASELINE_TRACKING) != 0;
+
+		if (Device::Pad()->featureButtonModes) {
+			j["buttons"] = json::array();
+			for (int i = 0; i < Device::Pad()->numButtons; ++i)
+			{
+				auto button = Device::Button(i);
+				if (groups & DPG_MAPPING) {
+					j["buttons"][i]["mode"] = (int)button->mode;
+					j["buttons"][i]["count"] = button->count;
+				}
+				if (groups & DPG_SENSITIVITY) {
+					j["buttons"][i]["threshold"] = button->threshold;
+				}
+			}
+		}
 	}
 
 	if(groups & DPG_DEVICE) {
@@ -1,17 +1,21 @@
 #pragma once
 
 #include "stdint.h"
+#include <functional>
 #include <string>
 #include <map>
-#include "wx/string.h"
-#include "wx/colour.h"
+#include <vector>
 
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
 #include "Model/Firmware.h"
 #include "Model/Reporter.h"
-#include "Model/Updater.h"
+#include "Model/Histogram.h"
+#include "Model/SensorStatistics.h"
+#include "Model/Emulator.h"
+#include "Model/Version.h"
+#include "Model/SharedState.h"
 
 namespace adp {
 
@@ -37,20 +41,34 @@ enum DeviceProfileGroupFlags
 
 typedef int32_t DeviceProfileGroups;
 
+// Response curves of the joystick axes, see Joystick.h of the firmware.
+enum JoystickCurve
+{
+	JOYSTICK_CURVE_LINEAR = 0,
+	JOYSTICK_CURVE_SOFT   = 1, // square root, most of the range goes to light presses
+	JOYSTICK_CURVE_HARD   = 2, // square, most of the range goes to hard presses
+	JOYSTICK_CURVE_S      = 3, // smoothstep, flat at both ends
+};
+
+constexpr int JOYSTICK_AXIS_COUNT = 8;
+
+// How the sensors of a button make it press, see ButtonReport.
+enum ButtonMode
+{
+	BUTTON_MODE_ANY          = 0, // any sensor above its own threshold
+	BUTTON_MODE_SUM          = 1, // sum of the sensor values above the button threshold
+	BUTTON_MODE_WEIGHTED_SUM = 2, // same with the weight of every sensor
+	BUTTON_MODE_K_OF_N       = 3, // at least count sensors above their own thresholds
+};
+
 struct RgbColor
 {
 	RgbColor(uint8_t r, uint8_t g, uint8_t b)
 		:red(r),green(g),blue(b)
 	{ ; }
 
-	RgbColor(std::string input)
-		:red(0), green(0), blue(0)
-	{
-		wxColour c(input);
-		red = c.Red();
-		green = c.Green();
-		blue = c.Blue();
-	}
+	// Parses "#RRGGBB", "#RGB" or "rgb(r, g, b)", anything else results in black.
+	RgbColor(const std::string& input);
 
 	RgbColor()
 		:red(0), green(0), blue(0)
@@ -62,9 +80,8 @@ struct RgbColor
 	uint8_t green;
 	uint8_t blue;
 
-	const std::string ToString() const {
-		return wxColour(red, green, blue).GetAsString(wxC2S_HTML_SYNTAX).ToStdString();
-	}
+	// Formats the color as "#RRGGBB".
+	const std::string ToString() const;
 };
 
 struct SensorState
@@ -74,9 +91,25 @@ struct SensorState
 	double value = 0.0;
 	int resistorValue = 0;
 	int button = 0; // zero means unmapped.
+	int flags = 0; // SensorReport flags, like BASELINE_TRACKING.
+	double weight = 1.0; // in BUTTON_MODE_WEIGHTED_SUM
 	bool pressed = false;
+	SensorStatistics statistics; // of the individual input reports, values above are averaged per update
 
 	SensorReport ToReport(int index);
+
+	// Joystick axis the sensor drives in firmware with FEATURE_JOYSTICK_AXES, -1 for none.
+	int JoystickAxis() const;
+	JoystickCurve GetJoystickCurve() const;
+};
+
+// Button of firmware with FEATURE_BUTTON_MODES. Thresholds are normalized like sensor values, but a sum can go above 1.
+struct ButtonState
+{
+	ButtonMode mode = BUTTON_MODE_ANY;
+	int count = 2; // sensors for BUTTON_MODE_K_OF_N
+	double threshold = 0.0; // of the sum modes
+	double releaseThreshold = 0.0;
 };
 
 struct PadState
@@ -88,11 +121,77 @@ struct PadState
 	double releaseThreshold = 1.0;
 	BoardType boardType = BOARD_UNKNOWN;
 	bool featureDebug;
+	bool featureDebugTrace;
+	bool featureExtendedInput;
 	bool featureDigipot;
 	bool featureLights;
+	bool featureProfiling;
+	bool featureBaseline;
+	bool featureJoystickAxes;
+	bool featureButtonModes;
+	bool featureTransactions;
+	bool featureSofSync;
+	bool featureRawAdc;
+	bool featurePackedInput;
 	VersionType firmwareVersion = versionTypeUnknown;
 };
 
+struct ReportStats
+{
+	bool extended = false; // true once the device sends sequence numbers and timestamps
+	uint64_t received = 0; // input reports read since connecting
+	uint64_t dropped = 0; // reports missing from the sequence
+	uint64_t gaps = 0; // number of times one or more reports went missing
+	int largestGap = 0; // most reports missing in a row
+	double latency = 0.0; // smoothed device to host latency in ms, relative to the fastest report seen
+	double maxLatency = 0.0; // highest latency in ms since connecting
+};
+
+struct PollingSummary
+{
+	HistogramSummary intervals; // us between input reports arriving on the host
+	HistogramSummary batchSizes; // input reports read per device update
+	HistogramSummary deviceIntervals; // us between input reports or packed scans by the device clock, extended input only
+	HistogramSummary latency; // us of device to host latency as in ReportStats, extended input only
+};
+
+struct ConnectionStats
+{
+	uint64_t connects = 0; // pads connected since the start
+	uint64_t failures = 0; // devices put on the failed device list
+	int failedDevices = 0; // devices on the failed device list now, they are retried once plugged in again
+	ReporterErrors errors; // failed transfers of all pads since the start
+};
+
+// Counters of firmware with FEATURE_PROFILING, see ProfilingReport. The counters of the firmware wrap around, these
+// do not as long as they are read at least once an hour.
+struct FirmwareProfile
+{
+	uint64_t frames = 0; // USB frames, one per ms while a host is connected
+	uint64_t scans = 0; // sensor scans
+	uint64_t scanTime = 0; // total time spent scanning in us
+	int maxScanTime = 0; // longest scan in us since the previous read
+	uint64_t configurations = 0; // times a host configured the pad
+	uint64_t reports = 0; // input reports the host took
+	uint64_t reportAge = 0; // total time in us from the start of their scan until the host took them
+	int maxReportAge = 0; // oldest input report in us since the previous read
+};
+
+// Baselines of firmware with FEATURE_BASELINE, see BaselineReport. Values are normalized 0 to 1.
+struct FirmwareBaselines
+{
+	double baselines[MAX_SENSOR_COUNT] = {}; // idle value, zero for sensors without tracking
+	double offsets[MAX_SENSOR_COUNT] = {}; // shift of the thresholds, the drift since they were set
+};
+
+// Unfiltered conversion of firmware with FEATURE_RAW_ADC, see RawAdcReport.
+struct RawAdcSample
+{
+	int sensor;
+	int value; // 0 to 1023, not limited to the maximum sensor value
+	int64_t time; // device time in us since streaming started
+};
+
 struct LedMapping
 {
 	int lightRuleIndex;
@@ -128,12 +227,81 @@ public:
 
 	static int PollingRate();
 
+	static const ReportStats* Reports();
+
+	static PollingSummary PollingStats();
+
+	static void ResetPollingStats();
+
+	// Starts the statistics of every sensor over, for example after a sensor was replaced.
+	static void ResetSensorStatistics();
+
+	static ConnectionStats Connections();
+
+	// Reads the profiling counters, returns false if the pad does not have them.
+	static bool ReadProfile(FirmwareProfile& profile);
+
+	// Reads the baselines, returns false if the pad does not track them.
+	static bool ReadBaselines(FirmwareBaselines& baselines);
+
+	// The profiling counters and baselines as of the last read, the device reads them every few seconds while it
+	// updates. Null if the pad does not have them.
+	static const FirmwareProfile* Profile();
+	static const FirmwareBaselines* Baselines();
+
+	// Streams raw conversions of one sensor, or of all of them if the sensor is -1, instead of the input reports.
+	// Sensor values and buttons keep the state they had until streaming stops.
+	static bool StartRawAdc(int sensor);
+
+	static void StopRawAdc();
+
+	static bool IsStreamingRawAdc();
+
+	// Moves the samples streamed since the previous call to samples, oldest first.
+	static void ReadRawAdc(std::vector<RawAdcSample>& samples);
+
+	static bool StartRecording(const char* path);
+
+	static void StopRecording();
+
+	static bool IsRecording();
+
+	// Publishes the input of the pad in shared memory, see SharedState.h.
+	static bool StartSharing(const char* name = SHARED_STATE_DEFAULT_NAME);
+
+	static void StopSharing();
+
+	static bool IsSharing();
+
+	// Uses the pad through the daemon at the given path instead of opening it, see Daemon.h. An empty path opens
+	// pads directly again.
+	static void UseDaemon(const char* path);
+
+	// Reports of the connected pad as bytes with the report id first, for the daemon.
+	static bool GetFeatureReport(uint8_t* report, size_t size);
+
+	static bool SendFeatureReport(const uint8_t* report, size_t size);
+
+	static bool SendOutputReport(uint8_t reportId);
+
+	// Called for every input report read from the pad.
+	static void SetInputListener(std::function<void(const SensorValuesReport&)> listener);
+
+	static bool OpenReplay(const char* path, bool realtime);
+
+	static bool StartEmulator(const EmulatorSettings& settings);
+
+	static void CloseVirtualDevice();
+
 	static const PadState* Pad();
 
 	static const LightsState* Lights();
 
 	static const SensorState* Sensor(int sensorIndex);
 
+	// Buttons of firmware with FEATURE_BUTTON_MODES, nullptr for other pads.
+	static const ButtonState* Button(int buttonIndex);
+
 	static wstring ReadDebug();
 
 	static const bool HasUnsavedChanges();
@@ -144,8 +312,23 @@ public:
 
 	static bool SetReleaseThreshold(double threshold);
 
+	// Lets the thresholds of every sensor follow the drift of its idle value, firmware with FEATURE_BASELINE.
+	static bool SetBaselineTracking(bool enabled);
+
 	static bool SetButtonMapping(int sensorIndex, int button);
 
+	// Lets the sensor drive a joystick axis, or none with -1. Firmware with FEATURE_JOYSTICK_AXES.
+	static bool SetJoystickAxis(int sensorIndex, int axis, JoystickCurve curve);
+
+	// Firmware with FEATURE_BUTTON_MODES. The count is only used by BUTTON_MODE_K_OF_N.
+	static bool SetButtonMode(int buttonIndex, ButtonMode mode, int count);
+
+	// Threshold of the sum modes, the release threshold follows the one of the pad.
+	static bool SetButtonThreshold(int buttonIndex, double threshold);
+
+	// Weight of the sensor in BUTTON_MODE_WEIGHTED_SUM, 0 to 4.
+	static bool SetSensorWeight(int sensorIndex, double weight);
+
 	static bool SetDeviceName(const char* name);
 
 	static bool SendLedMapping(int ledMappingIndex, LedMapping mapping);
@@ -162,6 +345,11 @@ public:
 
 	static void SaveChanges();
 
+	// Use DeviceTransaction rather than calling these directly.
+	static void BeginTransaction();
+
+	static void CommitTransaction();
+
 	static void LoadProfile(json& j, DeviceProfileGroups groups);
 
 	static void SaveProfile(json& j, DeviceProfileGroups groups);
@@ -169,4 +357,17 @@ public:
 	static void SetSearching(bool s);
 };
 
+// Groups configuration changes for its lifetime. Firmware with FEATURE_TRANSACTIONS applies them once when the
+// outermost transaction ends, instead of recomputing its tables after every report. Transactions nest, other pads
+// apply every change right away.
+class DeviceTransaction
+{
+public:
+	DeviceTransaction() { Device::BeginTransaction(); }
+	~DeviceTransaction() { Device::CommitTransaction(); }
+
+	DeviceTransaction(const DeviceTransaction&) = delete;
+	DeviceTransaction& operator=(const DeviceTransaction&) = delete;
+};
+
 }; // namespace adp.
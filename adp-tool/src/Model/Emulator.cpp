@@ -0,0 +1,660 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Model/Emulator.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// Default threshold and release threshold of the firmware, see DEFAULT_SENSOR_CONFIG in ConfigStore.c.
+constexpr int DEFAULT_THRESHOLD = 400;
+constexpr int DEFAULT_RELEASE_THRESHOLD = 380;
+constexpr int DEFAULT_RESISTOR_VALUE = 150;
+
+// Default button configuration of the firmware, see DEFAULT_BUTTON_CONFIG in ConfigStore.c.
+constexpr int DEFAULT_BUTTON_COUNT = 2;
+constexpr int DEFAULT_BUTTON_THRESHOLD = 800;
+constexpr int DEFAULT_BUTTON_RELEASE_THRESHOLD = 760;
+
+// Fraction bits of the sensor weights, ButtonReport::WEIGHT_ONE.
+constexpr int WEIGHT_SHIFT = 6;
+
+constexpr const char* DEFAULT_NAME = "ADP Emulator";
+
+// ====================================================================================================================
+// Emulator.
+// ====================================================================================================================
+
+Emulator::Emulator(const EmulatorSettings& settings)
+	: mySettings(settings)
+	, myRandom(settings.seed)
+	, myNoise(0.0, 1.0)
+{
+	mySettings.sensorCount = clamp(mySettings.sensorCount, 1, MAX_SENSOR_COUNT);
+	mySettings.panelCount = clamp(mySettings.panelCount, 1, min(mySettings.sensorCount, MAX_BUTTON_COUNT));
+	mySettings.reportRate = clamp(mySettings.reportRate, 1, EmulatorSettings::MAX_REPORT_RATE);
+	mySettings.queueSize = max(mySettings.queueSize, 1);
+
+	// Sensors are never exactly alike, give each one a fixed gain.
+	uniform_real_distribution<double> gain(0.8, 1.2);
+	for (auto& sensorGain : mySensorGains)
+		sensorGain = gain(myRandom);
+
+	FactoryReset();
+
+	Log::Writef(L"Emulator :: %i sensors on %i panels at %iHz", mySettings.sensorCount, mySettings.panelCount,
+		mySettings.reportRate);
+}
+
+void Emulator::FactoryReset()
+{
+	// Map the sensors of every panel to their own button, like a pad with one button per panel.
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		auto& sensor = mySensors[i];
+		sensor.threshold = DEFAULT_THRESHOLD;
+		sensor.releaseThreshold = DEFAULT_RELEASE_THRESHOLD;
+		sensor.buttonMapping = i < mySettings.sensorCount ? i * mySettings.panelCount / mySettings.sensorCount : -1;
+		sensor.resistorValue = DEFAULT_RESISTOR_VALUE;
+		sensor.flags = 0;
+		mySensorWeights[i] = ButtonReport::WEIGHT_ONE;
+	}
+
+	for (auto& button : myButtons)
+	{
+		button.mode = ButtonReport::MODE_ANY;
+		button.count = DEFAULT_BUTTON_COUNT;
+		button.threshold = DEFAULT_BUTTON_THRESHOLD;
+		button.releaseThreshold = DEFAULT_BUTTON_RELEASE_THRESHOLD;
+	}
+
+	myName = DEFAULT_NAME;
+
+	for (int i = 0; i < MAX_LIGHT_RULES; ++i)
+	{
+		myLightRules[i] = LightRuleReport();
+		myLightRules[i].lightRuleIndex = i;
+		myLightRules[i].flags = 0;
+		myLightRules[i].onColor = myLightRules[i].offColor = {0, 0, 0};
+		myLightRules[i].onFadeColor = myLightRules[i].offFadeColor = {0, 0, 0};
+	}
+
+	for (int i = 0; i < MAX_LED_MAPPINGS; ++i)
+	{
+		myLedMappings[i] = LedMappingReport();
+		myLedMappings[i].ledMappingIndex = i;
+		myLedMappings[i].flags = 0;
+		myLedMappings[i].lightRuleIndex = 0;
+		myLedMappings[i].sensorIndex = 0;
+		myLedMappings[i].ledIndexBegin = 0;
+		myLedMappings[i].ledIndexEnd = 0;
+	}
+}
+
+// ====================================================================================================================
+// Signal generation.
+// ====================================================================================================================
+
+uint32_t Emulator::PatternPanels(uint64_t stepIndex) const
+{
+	int panels = mySettings.panelCount;
+	switch (mySettings.pattern)
+	{
+	case EmulatorPattern::ALTERNATE:
+		return 1u << (stepIndex % panels);
+
+	case EmulatorPattern::RANDOM:
+	{
+		// Hash the step index instead of drawing from myRandom, the pattern must not depend on the report rate.
+		uint64_t x = (stepIndex + 1) * 0x9E3779B97F4A7C15ull ^ mySettings.seed;
+		x ^= x >> 31;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 29;
+		return 1u << (x % panels);
+	}
+
+	case EmulatorPattern::JUMPS:
+	{
+		int first = stepIndex % max(1, panels / 2);
+		return (1u << first) | (1u << min(panels - 1, first + panels / 2));
+	}
+
+	default:
+		return 0;
+	}
+}
+
+double Emulator::Pressure(int panel, double time) const
+{
+	if (mySettings.stepsPerSecond <= 0.0)
+		return 0.0;
+
+	double stepLength = 1.0 / mySettings.stepsPerSecond;
+	auto stepIndex = (uint64_t)(time / stepLength);
+	if ((PatternPanels(stepIndex) & (1u << panel)) == 0)
+		return 0.0;
+
+	double duration = min(mySettings.stepDuration, stepLength);
+	double phase = time - stepIndex * stepLength;
+	if (phase >= duration)
+		return 0.0;
+
+	double ramp = max(mySettings.rampDuration, 1e-6);
+	return min(1.0, min(phase, duration - phase) / ramp);
+}
+
+double Emulator::SensorValue(int sensor, double time)
+{
+	int panel = sensor * mySettings.panelCount / mySettings.sensorCount;
+	double value = mySettings.restValue + mySettings.drift * time / 60.0;
+	value += Pressure(panel, time) * mySettings.stepValue * mySensorGains[sensor];
+	return value + myNoise(myRandom) * mySettings.noise;
+}
+
+void Emulator::UpdateSensorValues(double time)
+{
+	for (int i = 0; i < mySettings.sensorCount; ++i)
+		mySensorValues[i] = (uint16_t)clamp((int)lround(SensorValue(i, time)), 0, MAX_SENSOR_VALUE);
+}
+
+// Same constants as Baseline.c of the firmware, counted in reports instead of scans.
+constexpr int BASELINE_FRACTION_BITS = 16;
+constexpr int BASELINE_SHIFT = 14;
+constexpr int BASELINE_SETTLE_SHIFT = 6;
+constexpr uint16_t BASELINE_SETTLE_REPORTS = 1024;
+constexpr uint16_t BASELINE_HOLD_REPORTS = 1000;
+
+// Thresholds shifted by the drift of the baseline, like Baseline_Apply.
+static uint16_t ApplyBaselineOffset(uint16_t threshold, int16_t offset)
+{
+	return (uint16_t)clamp((int)threshold + offset, 0, (int)UINT16_MAX);
+}
+
+void Emulator::UpdateBaselines()
+{
+	for (int i = 0; i < mySettings.sensorCount; ++i)
+	{
+		auto& sensor = mySensors[i];
+		auto& baseline = myBaselines[i];
+
+		if (!(sensor.flags & SensorReport::BASELINE_TRACKING))
+		{
+			baseline.isTracking = false;
+			baseline.offset = 0;
+			continue;
+		}
+
+		uint16_t value = mySensorValues[i];
+		int32_t target = (int32_t)value << BASELINE_FRACTION_BITS;
+
+		if (!baseline.isTracking)
+		{
+			baseline.isTracking = true;
+			baseline.value = target;
+			baseline.holdReports = 0;
+			baseline.settleReports = BASELINE_SETTLE_REPORTS;
+		}
+
+		int current = baseline.value >> BASELINE_FRACTION_BITS;
+		int releaseThreshold = ApplyBaselineOffset(sensor.releaseThreshold, baseline.offset);
+		bool pressed = sensor.buttonMapping >= 0 && sensor.buttonMapping < MAX_BUTTON_COUNT && myButtonsPressed[sensor.buttonMapping];
+
+		if (pressed || value * 2 > current + releaseThreshold)
+		{
+			baseline.holdReports = BASELINE_HOLD_REPORTS;
+			continue;
+		}
+
+		if (baseline.holdReports > 0)
+		{
+			--baseline.holdReports;
+			continue;
+		}
+
+		if (baseline.settleReports > 0)
+		{
+			baseline.value += (target - baseline.value) >> BASELINE_SETTLE_SHIFT;
+			if (--baseline.settleReports == 0)
+				baseline.reference = baseline.value >> BASELINE_FRACTION_BITS;
+			continue;
+		}
+
+		baseline.value += (target - baseline.value) >> BASELINE_SHIFT;
+		baseline.offset = (int16_t)((baseline.value >> BASELINE_FRACTION_BITS) - baseline.reference);
+	}
+}
+
+void Emulator::UpdateButtons()
+{
+	// Same decision as Pad_UpdateState in the firmware: with the default mode, a button is pressed while any of its
+	// sensors is above the threshold, and stays pressed until all of them dropped to the release threshold.
+	for (int b = 0; b < MAX_BUTTON_COUNT; ++b)
+	{
+		bool pressed = false;
+		switch (myButtons[b].mode)
+		{
+		case ButtonReport::MODE_SUM:
+		case ButtonReport::MODE_WEIGHTED_SUM:
+			pressed = IsSumPressed(b);
+			break;
+
+		case ButtonReport::MODE_K_OF_N:
+			pressed = IsKOfNPressed(b);
+			break;
+
+		default:
+			for (int s = 0; s < mySettings.sensorCount && !pressed; ++s)
+				pressed = mySensors[s].buttonMapping == b && IsSensorPressed(s, myButtonsPressed[b]);
+			break;
+		}
+		myButtonsPressed[b] = pressed;
+	}
+}
+
+bool Emulator::IsSensorPressed(int s, bool buttonPressed) const
+{
+	auto& sensor = mySensors[s];
+	uint16_t limit = buttonPressed ? sensor.releaseThreshold : sensor.threshold;
+	return mySensorValues[s] > ApplyBaselineOffset(limit, myBaselines[s].offset);
+}
+
+// Pad_IsSumPressed of the firmware.
+bool Emulator::IsSumPressed(int b) const
+{
+	auto& button = myButtons[b];
+	uint32_t sum = 0;
+	int32_t offset = 0;
+	for (int s = 0; s < mySettings.sensorCount; ++s)
+	{
+		if (mySensors[s].buttonMapping != b)
+			continue;
+
+		int weight = button.mode == ButtonReport::MODE_WEIGHTED_SUM ? mySensorWeights[s] : ButtonReport::WEIGHT_ONE;
+		sum += mySensorValues[s] * weight;
+		offset += myBaselines[s].offset * weight;
+	}
+
+	int value = min<uint32_t>(sum >> WEIGHT_SHIFT, UINT16_MAX);
+	uint16_t limit = myButtonsPressed[b] ? button.releaseThreshold : button.threshold;
+	return value > ApplyBaselineOffset(limit, (int16_t)clamp<int32_t>(offset >> WEIGHT_SHIFT, INT16_MIN, INT16_MAX));
+}
+
+bool Emulator::IsKOfNPressed(int b) const
+{
+	int needed = max<int>(1, myButtons[b].count);
+	int pressed = 0;
+	for (int s = 0; s < mySettings.sensorCount && pressed < needed; ++s)
+	{
+		if (mySensors[s].buttonMapping == b && IsSensorPressed(s, myButtonsPressed[b]))
+			++pressed;
+	}
+	return pressed >= needed;
+}
+
+bool Emulator::NextReport(uint64_t& reportIndex)
+{
+	auto now = steady_clock::now();
+	if (!myHasStarted)
+	{
+		myHasStarted = true;
+		myStartTime = now;
+		myNextReport = 0;
+	}
+
+	// Number of reports the pad would have sent by now.
+	auto elapsed = duration_cast<microseconds>(now - myStartTime).count();
+	auto sent = (uint64_t)elapsed * mySettings.reportRate / 1000000 + 1;
+	if (myNextReport >= sent)
+		return false;
+
+	// A host that falls too far behind loses the oldest reports, the sequence numbers show the gap.
+	if (sent - myNextReport > (uint64_t)mySettings.queueSize)
+		myNextReport = sent - mySettings.queueSize;
+
+	reportIndex = myNextReport++;
+	return true;
+}
+
+void Emulator::Scan(double time)
+{
+	UpdateSensorValues(time);
+	UpdateBaselines();
+	UpdateButtons();
+}
+
+static int ButtonBits(const bool* buttonsPressed)
+{
+	int buttonBits = 0;
+	for (int b = 0; b < MAX_BUTTON_COUNT; ++b)
+		buttonBits |= buttonsPressed[b] << b;
+	return buttonBits;
+}
+
+ReadDataResult Emulator::Get(SensorValuesReport& report)
+{
+	// The pad sends raw or packed reports instead.
+	uint64_t index;
+	if (myRawAdc || myPackedInput || !NextReport(index))
+		return ReadDataResult::NO_DATA;
+
+	Scan((double)index / mySettings.reportRate);
+
+	report.reportId = myExtendedInput ? REPORT_SENSOR_VALUES_EXTENDED : REPORT_SENSOR_VALUES;
+	report.buttonBits = WriteU16LE(ButtonBits(myButtonsPressed));
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		report.sensorValues[i] = WriteU16LE(i < mySettings.sensorCount ? mySensorValues[i] : 0);
+
+	if (myExtendedInput)
+	{
+		report.sequence = WriteU16LE((int)(index & 0xFFFF));
+		report.timestamp = WriteU32LE((uint32_t)(index * 1000000 / mySettings.reportRate));
+	}
+	else
+	{
+		report.sequence = {};
+		report.timestamp = {};
+	}
+
+	return ReadDataResult::SUCCESS;
+}
+
+// Microseconds between the scans of packed input reports, PACKED_INPUT_SCAN_INTERVAL_US of the firmware, which spreads
+// the scans of a report over a frame.
+constexpr int PACKED_INPUT_SCAN_INTERVAL_US = 1000 / PackedInputReport::MAX_SCANS;
+
+ReadDataResult Emulator::Get(PackedInputReport& report)
+{
+	uint64_t index;
+	if (!myPackedInput || !NextReport(index))
+		return ReadDataResult::NO_DATA;
+
+	// Scans every interval and keeps the newest scans before the report, like PackedInput_Task in the firmware.
+	int reportUs = 1000000 / mySettings.reportRate;
+	int scans = clamp(reportUs / PACKED_INPUT_SCAN_INTERVAL_US, 1, PackedInputReport::MAX_SCANS);
+	uint64_t reportStart = index * 1000000 / mySettings.reportRate;
+	uint32_t timestamp = (uint32_t)(reportStart + reportUs - scans * PACKED_INPUT_SCAN_INTERVAL_US);
+
+	report.reportId = REPORT_PACKED_INPUT;
+	report.sequence = WriteU16LE((int)(index & 0xFFFF));
+	report.timestamp = WriteU32LE(timestamp);
+	report.count = (uint8_t)scans;
+	memset(report.scans, 0, sizeof(report.scans));
+
+	for (int i = 0; i < scans; ++i)
+	{
+		auto& scan = report.scans[i];
+		int offset = i * PACKED_INPUT_SCAN_INTERVAL_US;
+		Scan((timestamp + offset) * 1e-6);
+
+		scan.buttonBits = WriteU16LE(ButtonBits(myButtonsPressed));
+		scan.time = (uint8_t)(offset / PackedInputReport::TIME_UNIT_US);
+		for (int s = 0; s < mySettings.sensorCount; ++s)
+		{
+			int bit = s * 10;
+			scan.sensorValues[bit / 8] |= (uint8_t)(mySensorValues[s] << (bit % 8));
+			scan.sensorValues[bit / 8 + 1] |= (uint8_t)(mySensorValues[s] >> (8 - bit % 8));
+		}
+	}
+
+	report.buttonBits = report.scans[scans - 1].buttonBits;
+	return ReadDataResult::SUCCESS;
+}
+
+// Microseconds per conversion of the ADC in the firmware, 13 cycles of its clock plus the switch of the channel.
+constexpr int RAW_ADC_CONVERSION_US = 52;
+constexpr int RAW_ADC_MAX_VALUE = (1 << RawAdcReport::SAMPLE_BITS) - 1;
+
+ReadDataResult Emulator::Get(RawAdcReport& report)
+{
+	uint64_t index;
+	if (!myRawAdc || !NextReport(index))
+		return ReadDataResult::NO_DATA;
+
+	// Converts back to back for the length of a report, like RawAdc_Task in the firmware.
+	int sensors = myRawAdcSensor == RawAdcReport::ALL_SENSORS ? mySettings.sensorCount : 1;
+	int reportUs = 1000000 / mySettings.reportRate;
+	int steps = clamp(reportUs / (RAW_ADC_CONVERSION_US * sensors), 1, RawAdcReport::MAX_SAMPLES / sensors);
+
+	report.reportId = REPORT_RAW_ADC;
+	report.sensor = (uint8_t)myRawAdcSensor;
+	report.count = (uint8_t)(steps * sensors);
+	report.timestamp = WriteU32LE((uint32_t)(index * 1000000 / mySettings.reportRate));
+	report.duration = WriteU16LE((steps - 1) * RAW_ADC_CONVERSION_US * sensors);
+	memset(report.samples, 0, sizeof(report.samples));
+
+	double start = (double)index / mySettings.reportRate;
+	for (int i = 0; i < report.count; ++i)
+	{
+		int sensor = sensors == 1 ? myRawAdcSensor : i % sensors;
+		double time = start + i * RAW_ADC_CONVERSION_US * 1e-6;
+		int value = clamp((int)lround(SensorValue(sensor, time)), 0, RAW_ADC_MAX_VALUE);
+
+		int bit = i * RawAdcReport::SAMPLE_BITS;
+		report.samples[bit / 8] |= (uint8_t)(value << (bit % 8));
+		report.samples[bit / 8 + 1] |= (uint8_t)(value >> (8 - bit % 8));
+	}
+
+	return ReadDataResult::SUCCESS;
+}
+
+// ====================================================================================================================
+// Feature reports.
+// ====================================================================================================================
+
+void Emulator::Get(PadConfigurationReport& report)
+{
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		report.sensorThresholds[i] = WriteU16LE(mySensors[i].threshold);
+		report.sensorToButtonMapping[i] = mySensors[i].buttonMapping;
+	}
+	report.releaseThreshold = WriteF32LE((float)mySensors[0].releaseThreshold / max<int>(1, mySensors[0].threshold));
+}
+
+void Emulator::Get(NameReport& report)
+{
+	report.size = (uint8_t)min(myName.size(), sizeof(report.name));
+	memset(report.name, 0, sizeof(report.name));
+	memcpy(report.name, myName.data(), report.size);
+}
+
+void Emulator::Get(IdentificationReport& report)
+{
+	report.firmwareMajor = WriteU16LE(1);
+	report.firmwareMinor = WriteU16LE(3);
+	report.buttonCount = MAX_BUTTON_COUNT;
+	report.sensorCount = mySettings.sensorCount;
+	report.ledCount = 0;
+	report.maxSensorValue = WriteU16LE(MAX_SENSOR_VALUE);
+	memset(report.boardType, 0, sizeof(report.boardType));
+	strcpy(report.boardType, "emulator");
+}
+
+void Emulator::Get(IdentificationV2Report& report)
+{
+	Get(static_cast<IdentificationReport&>(report));
+	report.reportId = REPORT_IDENTIFICATION_V2;
+	report.features = WriteU16LE(IdentificationV2Report::FEATURE_EXTENDED_INPUT | IdentificationV2Report::FEATURE_PROFILING
+		| IdentificationV2Report::FEATURE_BASELINE
+		| IdentificationV2Report::FEATURE_JOYSTICK_AXES
+		| IdentificationV2Report::FEATURE_BUTTON_MODES
+		| IdentificationV2Report::FEATURE_TRANSACTIONS
+		| IdentificationV2Report::FEATURE_RAW_ADC
+		| IdentificationV2Report::FEATURE_PACKED_INPUT);
+}
+
+void Emulator::Get(LightRuleReport& report)
+{
+	report = myLightRules[mySelectedLightRule];
+}
+
+void Emulator::Get(LedMappingReport& report)
+{
+	report = myLedMappings[mySelectedLedMapping];
+}
+
+void Emulator::Get(SensorReport& report)
+{
+	auto& sensor = mySensors[mySelectedSensor];
+	report.index = mySelectedSensor;
+	report.threshold = WriteU16LE(sensor.threshold);
+	report.releaseThreshold = WriteU16LE(sensor.releaseThreshold);
+	report.buttonMapping = sensor.buttonMapping;
+	report.resistorValue = sensor.resistorValue;
+	report.flags = WriteU16LE(sensor.flags);
+}
+
+void Emulator::Get(ButtonReport& report)
+{
+	auto& button = myButtons[mySelectedButton];
+	report.index = mySelectedButton;
+	report.mode = button.mode;
+	report.count = button.count;
+	report.threshold = WriteU16LE(button.threshold);
+	report.releaseThreshold = WriteU16LE(button.releaseThreshold);
+	memcpy(report.sensorWeights, mySensorWeights, sizeof(report.sensorWeights));
+}
+
+void Emulator::Get(DebugReport& report)
+{
+	report.messageSize = WriteU16LE(0);
+	memset(report.messagePacket, 0, sizeof(report.messagePacket));
+}
+
+void Emulator::Get(ProfilingReport& report)
+{
+	// Frames pass while the host is connected, the scans take no time and the reports go out right away.
+	auto elapsed = myHasStarted ? duration_cast<milliseconds>(steady_clock::now() - myStartTime).count() : 0;
+	report.frames = WriteU32LE((uint32_t)elapsed);
+	report.scans = WriteU32LE((uint32_t)myNextReport);
+	report.scanTime = WriteU32LE(0);
+	report.maxScanTime = WriteU16LE(0);
+	report.configurations = WriteU16LE(1);
+	report.reports = WriteU32LE((uint32_t)myNextReport);
+	report.reportAge = WriteU32LE(0);
+	report.maxReportAge = WriteU16LE(0);
+}
+
+void Emulator::Get(BaselineReport& report)
+{
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		auto& baseline = myBaselines[i];
+		report.baselines[i] = WriteU16LE(baseline.isTracking ? (uint16_t)(baseline.value >> BASELINE_FRACTION_BITS) : 0);
+		report.offsets[i] = WriteU16LE((uint16_t)baseline.offset);
+	}
+}
+
+void Emulator::Send(const PadConfigurationReport& report)
+{
+	float releaseMultiplier = ReadF32LE(report.releaseThreshold);
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		mySensors[i].threshold = ReadU16LE(report.sensorThresholds[i]);
+		mySensors[i].releaseThreshold = (uint16_t)(mySensors[i].threshold * releaseMultiplier);
+		mySensors[i].buttonMapping = report.sensorToButtonMapping[i];
+	}
+}
+
+void Emulator::Send(const NameReport& report)
+{
+	myName.assign((const char*)report.name, min<size_t>(report.size, sizeof(report.name)));
+}
+
+void Emulator::Send(const LightRuleReport& report)
+{
+	if (report.lightRuleIndex < MAX_LIGHT_RULES)
+		myLightRules[report.lightRuleIndex] = report;
+}
+
+void Emulator::Send(const LedMappingReport& report)
+{
+	if (report.ledMappingIndex < MAX_LED_MAPPINGS)
+		myLedMappings[report.ledMappingIndex] = report;
+}
+
+void Emulator::Send(const SensorReport& report)
+{
+	if (report.index >= MAX_SENSOR_COUNT)
+		return;
+
+	// New thresholds are set against the current baseline, as in Pad_UpdateConfiguration.
+	auto& sensor = mySensors[report.index];
+	auto& baseline = myBaselines[report.index];
+	bool changed = sensor.threshold != ReadU16LE(report.threshold) || sensor.releaseThreshold != ReadU16LE(report.releaseThreshold);
+	if (changed && baseline.isTracking && baseline.settleReports == 0)
+	{
+		baseline.reference = baseline.value >> BASELINE_FRACTION_BITS;
+		baseline.offset = 0;
+	}
+
+	sensor.threshold = ReadU16LE(report.threshold);
+	sensor.releaseThreshold = ReadU16LE(report.releaseThreshold);
+	sensor.buttonMapping = report.buttonMapping;
+	sensor.resistorValue = report.resistorValue;
+	sensor.flags = ReadU16LE(report.flags);
+}
+
+void Emulator::Send(const ButtonReport& report)
+{
+	if (report.index >= MAX_BUTTON_COUNT || report.mode > ButtonReport::MODE_K_OF_N)
+		return;
+
+	auto& button = myButtons[report.index];
+	button.mode = report.mode;
+	button.count = report.count;
+	button.threshold = ReadU16LE(report.threshold);
+	button.releaseThreshold = ReadU16LE(report.releaseThreshold);
+
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		if (mySensors[i].buttonMapping == report.index)
+			mySensorWeights[i] = report.sensorWeights[i];
+	}
+}
+
+void Emulator::Send(const TransactionReport&)
+{
+	// Nothing is precomputed from the configuration, every report takes effect right away.
+}
+
+void Emulator::Send(const SetPropertyReport& report)
+{
+	uint32_t value = ReadU32LE(report.propertyValue);
+	switch (ReadU32LE(report.propertyId))
+	{
+	case SetPropertyReport::SELECTED_LIGHT_RULE_INDEX:
+		mySelectedLightRule = min<uint32_t>(value, MAX_LIGHT_RULES - 1);
+		break;
+
+	case SetPropertyReport::SELECTED_LED_MAPPING_INDEX:
+		mySelectedLedMapping = min<uint32_t>(value, MAX_LED_MAPPINGS - 1);
+		break;
+
+	case SetPropertyReport::SELECTED_SENSOR_INDEX:
+		mySelectedSensor = min<uint32_t>(value, MAX_SENSOR_COUNT - 1);
+		break;
+
+	case SetPropertyReport::SELECTED_BUTTON_INDEX:
+		mySelectedButton = min<uint32_t>(value, MAX_BUTTON_COUNT - 1);
+		break;
+
+	case SetPropertyReport::RAW_ADC_SENSOR:
+		myRawAdcSensor = value < (uint32_t)mySettings.sensorCount ? (int)value : RawAdcReport::ALL_SENSORS;
+		break;
+
+	case SetPropertyReport::INPUT_REPORT_FORMAT:
+		myExtendedInput = value == SetPropertyReport::INPUT_FORMAT_EXTENDED;
+		myRawAdc = value == SetPropertyReport::INPUT_FORMAT_RAW_ADC;
+		myPackedInput = value == SetPropertyReport::INPUT_FORMAT_PACKED;
+		break;
+	}
+}
+
+}; // namespace adp.
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+enum class EmulatorPattern
+{
+	IDLE, // no steps, only noise and drift
+	ALTERNATE, // steps on every panel in turn
+	RANDOM, // steps on a random panel
+	JUMPS, // steps on two opposite panels at once
+};
+
+struct EmulatorSettings
+{
+	int sensorCount = 12;
+	int panelCount = 4; // sensors are spread evenly over the panels
+	int reportRate = 1000; // reports per second, at most MAX_REPORT_RATE
+	int queueSize = 1024; // reports the host can fall behind before older ones are lost, like the OS report queue
+
+	EmulatorPattern pattern = EmulatorPattern::ALTERNATE;
+	double stepsPerSecond = 4.0;
+	double stepDuration = 0.12; // seconds a panel stays pressed
+	double rampDuration = 0.005; // seconds for the pressure to build up and fall off
+
+	int restValue = 80; // sensor value without pressure
+	int stepValue = 600; // additional sensor value of a fully pressed panel
+	double noise = 4.0; // standard deviation of the sensor noise
+	double drift = 0.0; // change of the rest value per minute
+
+	uint32_t seed = 1;
+
+	static constexpr int MAX_REPORT_RATE = 8000;
+};
+
+// A virtual pad that answers every report like firmware v1.3 would. It keeps its own configuration, generates sensor
+// values from the settings and decides button presses with the same logic as Pad_UpdateState in the firmware.
+class Emulator
+{
+public:
+	Emulator(const EmulatorSettings& settings);
+
+	const EmulatorSettings& Settings() const { return mySettings; }
+
+	ReadDataResult Get(SensorValuesReport& report);
+	ReadDataResult Get(RawAdcReport& report);
+	ReadDataResult Get(PackedInputReport& report);
+	void Get(PadConfigurationReport& report);
+	void Get(NameReport& report);
+	void Get(IdentificationReport& report);
+	void Get(IdentificationV2Report& report);
+	void Get(LightRuleReport& report);
+	void Get(LedMappingReport& report);
+	void Get(SensorReport& report);
+	void Get(DebugReport& report);
+	void Get(ProfilingReport& report);
+	void Get(BaselineReport& report);
+	void Get(ButtonReport& report);
+
+	void Send(const PadConfigurationReport& report);
+	void Send(const NameReport& report);
+	void Send(const LightRuleReport& report);
+	void Send(const LedMappingReport& report);
+	void Send(const SensorReport& report);
+	void Send(const ButtonReport& report);
+	void Send(const TransactionReport& report);
+	void Send(const SetPropertyReport& report);
+
+	void FactoryReset();
+
+private:
+	struct SensorConfig
+	{
+		uint16_t threshold;
+		uint16_t releaseThreshold;
+		int8_t buttonMapping;
+		uint8_t resistorValue;
+		uint16_t flags;
+	};
+
+	struct ButtonConfig
+	{
+		uint8_t mode;
+		uint8_t count;
+		uint16_t threshold;
+		uint16_t releaseThreshold;
+	};
+
+	// Baseline tracking of a sensor with BASELINE_TRACKING, as in Baseline.c of the firmware.
+	struct SensorBaseline
+	{
+		int32_t value = 0; // baseline with 16 fraction bits
+		uint16_t reference = 0;
+		uint16_t holdReports = 0;
+		uint16_t settleReports = 0;
+		bool isTracking = false;
+		int16_t offset = 0;
+	};
+
+	bool NextReport(uint64_t& reportIndex);
+	double SensorValue(int sensor, double time);
+	void UpdateSensorValues(double time);
+	void Scan(double time);
+	void UpdateBaselines();
+	void UpdateButtons();
+	bool IsSensorPressed(int sensor, bool buttonPressed) const;
+	bool IsSumPressed(int button) const;
+	bool IsKOfNPressed(int button) const;
+	double Pressure(int panel, double time) const;
+	uint32_t PatternPanels(uint64_t stepIndex) const;
+
+	EmulatorSettings mySettings;
+
+	SensorConfig mySensors[MAX_SENSOR_COUNT];
+	SensorBaseline myBaselines[MAX_SENSOR_COUNT];
+	ButtonConfig myButtons[MAX_BUTTON_COUNT];
+	uint8_t mySensorWeights[MAX_SENSOR_COUNT];
+	std::string myName;
+	LightRuleReport myLightRules[MAX_LIGHT_RULES];
+	LedMappingReport myLedMappings[MAX_LED_MAPPINGS];
+	int mySelectedSensor = 0;
+	int mySelectedButton = 0;
+	int mySelectedLightRule = 0;
+	int mySelectedLedMapping = 0;
+	bool myExtendedInput = false;
+	bool myRawAdc = false;
+	bool myPackedInput = false;
+	int myRawAdcSensor = RawAdcReport::ALL_SENSORS;
+
+	uint16_t mySensorValues[MAX_SENSOR_COUNT] = {};
+	double mySensorGains[MAX_SENSOR_COUNT] = {};
+	bool myButtonsPressed[MAX_BUTTON_COUNT] = {};
+
+	std::mt19937 myRandom;
+	std::normal_distribution<double> myNoise;
+	bool myHasStarted = false;
+	uint64_t myNextReport = 0;
+	std::chrono::steady_clock::time_point myStartTime;
+};
+
+}; // namespace adp.
@@ -4,9 +4,7 @@
 #include <thread>
 #include <algorithm>
 #include <fstream>
-
-#include "wx/string.h"
-#include "wx/event.h"
+#include <cstring>
 
 #include "Model/Firmware.h"
 #include "Model/Device.h"
@@ -17,7 +15,11 @@ using namespace chrono;
 
 namespace adp {
 
-wxDEFINE_EVENT(EVT_AVRDUDE, wxCommandEvent);
+static void NotifyAvrdude(const AvrdudeCallback& callback, AvrdudeEvent type, int value = 0, wstring text = L"")
+{
+	if (callback)
+		callback({ type, value, move(text) });
+}
 
 BoardType ParseBoardType(const std::string& str)
 {
@@ -104,7 +106,7 @@ FlashResult FirmwareUploader::UpdateFirmware(wstring fileName)
 
 	if (boardType == BoardType::BOARD_UNKNOWN || pad->boardType != boardType) {
 		if (!ignoreBoardType) {
-			errorMessage = wxString::Format(L"Selected: %ls, connected: %ls", BoardTypeToString(boardType), BoardTypeToString(pad->boardType));
+			errorMessage = wstring(L"Selected: ") + BoardTypeToString(boardType) + L", connected: " + BoardTypeToString(pad->boardType);
 			flashResult = FLASHRESULT_FAILURE_BOARDTYPE;
 			return flashResult;
 		}
@@ -161,11 +163,11 @@ FlashResult FirmwareUploader::WriteFirmware()
 	AvrDude avrdude;
 
 	auto comPort = this->comPort.port;
-	auto firmwareFile = this->firmwareFile;
-	auto eventHandler = this->eventHandler;
+	auto firmwareFile = narrow(this->firmwareFile.c_str(), this->firmwareFile.size());
+	auto eventCallback = this->eventCallback;
 
 	avrdude
-		.on_run([eventHandler, comPort, firmwareFile, this](AvrDude::Ptr avrdude) {
+		.on_run([eventCallback, comPort, firmwareFile, this](AvrDude::Ptr avrdude) {
 			this->myAvrdude = std::move(avrdude);
 
 			std::vector<std::string> args{ {
@@ -175,51 +177,29 @@ FlashResult FirmwareUploader::WriteFirmware()
 				"-P", comPort,
 				"-b", "115200",
 				"-D",
-				"-U", wxString::Format("flash:w:1:%s:i", firmwareFile).ToStdString(),
+				"-U", "flash:w:1:" + firmwareFile + ":i",
 			} };
 
 			this->myAvrdude->push_args(std::move(args));
 
-			if (eventHandler) {
-				auto evt = new wxCommandEvent(EVT_AVRDUDE);
-				evt->SetExtraLong(AE_START);
-				wxQueueEvent(eventHandler, evt);
-			}
+			NotifyAvrdude(eventCallback, AE_START);
 		})
-		.on_message([eventHandler](const char* msg, unsigned size) {
-			auto wxmsg = wxString::FromUTF8(msg);
-			Log::Write(L"avrdude: " + wxmsg);
-
-			if (eventHandler) {
-				auto evt = new wxCommandEvent(EVT_AVRDUDE);
-				evt->SetExtraLong(AE_MESSAGE);
-				evt->SetString(std::move(wxmsg));
-				wxQueueEvent(eventHandler, evt);
-			}
+		.on_message([eventCallback](const char* msg, unsigned size) {
+			auto message = widen(msg, size);
+			Log::Write((L"avrdude: " + message).c_str());
+
+			NotifyAvrdude(eventCallback, AE_MESSAGE, 0, move(message));
 		})
-		.on_progress([eventHandler](const char* task, unsigned progress) {
-			auto wxmsg = wxString::FromUTF8(task);
-
-			if (eventHandler) {
-				auto evt = new wxCommandEvent(EVT_AVRDUDE);
-				evt->SetExtraLong(AE_PROGRESS);
-				evt->SetInt(progress);
-				evt->SetString(wxmsg);
-				wxQueueEvent(eventHandler, evt);
-			}
+		.on_progress([eventCallback](const char* task, unsigned progress) {
+			NotifyAvrdude(eventCallback, AE_PROGRESS, progress, widen(task, strlen(task)));
 		})
-		.on_complete([eventHandler, this]() {
+		.on_complete([eventCallback, this]() {
 			Log::Write(L"avrdude done");
 
 			int exitCode = this->myAvrdude->exit_code();
 			this->WritingDone(exitCode);
 
-			if (eventHandler) {
-				auto evt = new wxCommandEvent(EVT_AVRDUDE);
-				evt->SetExtraLong(AE_EXIT);
-				evt->SetInt(exitCode);
-				wxQueueEvent(eventHandler, evt);
-			}
+			NotifyAvrdude(eventCallback, AE_EXIT, exitCode);
 		});
 
 
@@ -241,13 +221,7 @@ void FirmwareUploader::WritingDone(int exitCode)
 	do {
 		auto timeSpent = duration_cast<std::chrono::seconds>(system_clock::now() - startTime);
 
-		if (eventHandler) {
-			auto evt = new wxCommandEvent(EVT_AVRDUDE);
-			evt->SetExtraLong(AE_PROGRESS);
-			evt->SetInt(timeSpent.count() * 20);
-			evt->SetString("Restarting");
-			wxQueueEvent(eventHandler, evt);
-		}
+		NotifyAvrdude(eventCallback, AE_PROGRESS, (int)timeSpent.count() * 20, L"Restarting");
 
 		if (timeSpent.count() > 5) {
 			errorMessage = L"Device failed to come back online";
@@ -288,9 +262,9 @@ void FirmwareUploader::SetIgnoreBoardType(bool ignoreBoardType)
 	this->ignoreBoardType = ignoreBoardType;
 }
 
-void FirmwareUploader::SetEventHandler(wxEvtHandler* handler)
+void FirmwareUploader::SetEventCallback(AvrdudeCallback callback)
 {
-	this->eventHandler = handler;
+	this->eventCallback = move(callback);
 }
 
 wstring FirmwareUploader::GetErrorMessage()
@@ -1,11 +1,11 @@
 #pragma once
 
 #include "stdint.h"
+#include <functional>
 #include <string>
 
 #include "avrdude-slic3r.hpp"
 #include "serial/serial.h"
-#include "wx/event.h"
 
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
@@ -44,13 +44,21 @@ enum AvrdudeEvent
 	AE_EXIT,
 };
 
-wxDECLARE_EVENT(EVT_AVRDUDE, wxCommandEvent);
+struct AvrdudeMessage
+{
+	AvrdudeEvent type;
+	int value = 0; // percentage for AE_PROGRESS, exit code for AE_EXIT
+	wstring text; // message for AE_MESSAGE, task for AE_PROGRESS
+};
+
+// Called on the avrdude thread, the receiver has to pass messages on to its own thread if needed.
+typedef function<void(const AvrdudeMessage&)> AvrdudeCallback;
 
 class FirmwareUploader
 {
 public:
 	FlashResult UpdateFirmware(wstring fileName);
-	void SetEventHandler(wxEvtHandler* handler);
+	void SetEventCallback(AvrdudeCallback callback);
 	void SetIgnoreBoardType(bool ignoreBoardType);
 	void WritingDone(int exitCode);
 	wstring GetErrorMessage();
@@ -63,7 +71,7 @@ private:
 
 	PortInfo comPort;
 	wstring firmwareFile;
-	wxEvtHandler* eventHandler;
+	AvrdudeCallback eventCallback;
 	wstring errorMessage;
 	FlashResult flashResult = FLASHRESULT_NOTHING;
 	json* configBackup = NULL;
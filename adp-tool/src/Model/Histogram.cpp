@@ -0,0 +1,108 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Model/Histogram.h"
+
+using namespace std;
+
+namespace adp {
+
+Histogram::Histogram()
+{
+	Reset();
+}
+
+int Histogram::BucketIndex(uint32_t value)
+{
+	if (value < SUB_BUCKET_COUNT)
+		return value;
+
+	// Position of the highest set bit picks the power of two, the bits below it pick the linear sub bucket.
+	int exponent = 31;
+	while ((value & (1u << exponent)) == 0)
+		--exponent;
+
+	int shift = exponent - SUB_BUCKET_BITS;
+	int subBucket = (value >> shift) & (SUB_BUCKET_COUNT - 1);
+	return (shift + 1) * SUB_BUCKET_COUNT + subBucket;
+}
+
+uint32_t Histogram::BucketUpperBound(int index)
+{
+	if (index < SUB_BUCKET_COUNT)
+		return index;
+
+	int shift = index / SUB_BUCKET_COUNT - 1;
+	uint64_t lower = (uint64_t)(SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+	uint64_t upper = lower + ((uint64_t)1 << shift) - 1;
+	return (uint32_t)min<uint64_t>(upper, UINT32_MAX);
+}
+
+void Histogram::Record(uint32_t value)
+{
+	myCounts[BucketIndex(value)].fetch_add(1, memory_order_relaxed);
+	myTotal.fetch_add(1, memory_order_relaxed);
+
+	uint32_t previous = myMax.load(memory_order_relaxed);
+	while (value > previous && !myMax.compare_exchange_weak(previous, value, memory_order_relaxed));
+}
+
+void Histogram::Reset()
+{
+	for (auto& count : myCounts)
+		count.store(0, memory_order_relaxed);
+
+	myTotal.store(0, memory_order_relaxed);
+	myMax.store(0, memory_order_relaxed);
+}
+
+uint64_t Histogram::Count() const
+{
+	return myTotal.load(memory_order_relaxed);
+}
+
+uint32_t Histogram::Max() const
+{
+	return myMax.load(memory_order_relaxed);
+}
+
+uint32_t Histogram::Percentile(double percentile) const
+{
+	// Sum the buckets instead of using myTotal, a concurrent Record might have updated one but not the other.
+	uint64_t counts[BUCKET_COUNT];
+	uint64_t total = 0;
+	for (int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		counts[i] = myCounts[i].load(memory_order_relaxed);
+		total += counts[i];
+	}
+
+	if (total == 0)
+		return 0;
+
+	uint64_t target = max<uint64_t>(1, (uint64_t)ceil(total * clamp(percentile, 0.0, 100.0) / 100.0));
+	uint64_t seen = 0;
+	for (int i = 0; i < BUCKET_COUNT; ++i)
+	{
+		seen += counts[i];
+		if (seen >= target)
+			return min(BucketUpperBound(i), Max());
+	}
+
+	return Max();
+}
+
+HistogramSummary Histogram::Summary() const
+{
+	HistogramSummary summary;
+	summary.count = Count();
+	summary.p50 = Percentile(50.0);
+	summary.p99 = Percentile(99.0);
+	summary.p999 = Percentile(99.9);
+	summary.max = Max();
+	return summary;
+}
+
+}; // namespace adp.
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace adp {
+
+struct HistogramSummary
+{
+	uint64_t count = 0;
+	uint32_t p50 = 0;
+	uint32_t p99 = 0;
+	uint32_t p999 = 0;
+	uint32_t max = 0;
+};
+
+// Log-linear histogram in the style of HdrHistogram. Every power of two is split into 16 linear sub buckets, which
+// keeps the error of a reported percentile within about 6% over the full 32-bit range at a fixed memory cost.
+// Recording and reading are lock-free, one thread can record while another reads.
+class Histogram
+{
+public:
+	Histogram();
+
+	void Record(uint32_t value);
+
+	void Reset();
+
+	uint64_t Count() const;
+
+	uint32_t Max() const;
+
+	// Returns an upper bound of the bucket that holds the given percentile (0-100).
+	uint32_t Percentile(double percentile) const;
+
+	HistogramSummary Summary() const;
+
+private:
+	static constexpr int SUB_BUCKET_BITS = 4;
+	static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	static constexpr int BUCKET_COUNT = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+	static int BucketIndex(uint32_t value);
+	static uint32_t BucketUpperBound(int index);
+
+	std::atomic<uint64_t> myCounts[BUCKET_COUNT];
+	std::atomic<uint64_t> myTotal;
+	std::atomic<uint32_t> myMax;
+};
+
+}; // namespace adp.
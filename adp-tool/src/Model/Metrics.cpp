@@ -0,0 +1,252 @@
+#include "Adp.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <cwchar>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "Model/Metrics.h"
+#include "Model/Device.h"
+#include "Model/Server.h"
+#include "Model/Daemon.h"
+#include "Model/Firmware.h"
+#include "Model/Utils.h"
+
+using namespace std;
+
+namespace adp {
+
+// ====================================================================================================================
+// Helper functions.
+// ====================================================================================================================
+
+static string EscapeLabel(const string& value)
+{
+	string result;
+	for (char c : value)
+	{
+		if (c == '\\' || c == '"')
+			result += '\\';
+		if (c == '\n')
+			result += "\\n";
+		else
+			result += c;
+	}
+	return result;
+}
+
+// Unlike rename on Windows, replaces an existing file.
+static bool RenameOver(const char* from, const char* to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(from, to) == 0;
+#endif
+}
+
+class MetricsWriter
+{
+public:
+	void Describe(const char* name, const char* type, const char* help)
+	{
+		Appendf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+	}
+
+	void Value(const char* name, double value)
+	{
+		Appendf("%s %.9g\n", name, value);
+	}
+
+	void Value(const char* name, const char* labels, double value)
+	{
+		Appendf("%s{%s} %.9g\n", name, labels, value);
+	}
+
+	// Quantiles and count of a histogram in us as seconds, for a metric of type summary. The histogram keeps no
+	// total, so the summary has no _sum.
+	void Quantiles(const char* name, const HistogramSummary& summary)
+	{
+		Value(name, "quantile=\"0.5\"", summary.p50 * 1e-6);
+		Value(name, "quantile=\"0.99\"", summary.p99 * 1e-6);
+		Value(name, "quantile=\"0.999\"", summary.p999 * 1e-6);
+		Value(name, "quantile=\"1\"", summary.max * 1e-6);
+		Appendf("%s_count %llu\n", name, (unsigned long long)summary.count);
+	}
+
+	void Appendf(const char* format, ...)
+	{
+		char buffer[512];
+		va_list args;
+		va_start(args, format);
+		int size = vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		if (size > 0)
+			myText.append(buffer, min<size_t>(size, sizeof(buffer) - 1));
+	}
+
+	const string& Text() const { return myText; }
+
+private:
+	string myText;
+};
+
+// ====================================================================================================================
+// Metrics.
+// ====================================================================================================================
+
+string Metrics::Format()
+{
+	MetricsWriter m;
+	auto pad = Device::Pad();
+
+	m.Describe("adp_pad_connected", "gauge", "Whether a pad is connected.");
+	m.Value("adp_pad_connected", pad ? 1 : 0);
+
+	if (pad)
+	{
+		auto boardType = BoardTypeToString(pad->boardType);
+		auto board = narrow(boardType, wcslen(boardType));
+		m.Describe("adp_pad_info", "gauge", "Name, board and firmware version of the connected pad.");
+		m.Appendf("adp_pad_info{name=\"%s\",board=\"%s\",firmware=\"%u.%u\"} 1\n",
+			EscapeLabel(pad->name).c_str(), EscapeLabel(board).c_str(),
+			pad->firmwareVersion.major, pad->firmwareVersion.minor);
+	}
+
+	auto connections = Device::Connections();
+	m.Describe("adp_connects_total", "counter", "Pads connected since the start.");
+	m.Value("adp_connects_total", (double)connections.connects);
+	m.Describe("adp_connection_failures_total", "counter", "Devices put on the failed device list.");
+	m.Value("adp_connection_failures_total", (double)connections.failures);
+	m.Describe("adp_failed_devices", "gauge", "Devices on the failed device list, not retried until plugged in again.");
+	m.Value("adp_failed_devices", connections.failedDevices);
+	m.Describe("adp_hid_errors_total", "counter", "Failed HID transfers.");
+	m.Value("adp_hid_errors_total", "transfer=\"input\"", (double)connections.errors.reads);
+	m.Value("adp_hid_errors_total", "transfer=\"get_feature\"", (double)connections.errors.gets);
+	m.Value("adp_hid_errors_total", "transfer=\"send_feature\"", (double)connections.errors.sends);
+	m.Value("adp_hid_errors_total", "transfer=\"output\"", (double)connections.errors.writes);
+
+	m.Describe("adp_server_clients", "gauge", "Web clients connected to the WebSocket server.");
+	m.Value("adp_server_clients", Server::NumClients());
+	m.Describe("adp_daemon_clients", "gauge", "Processes connected to the daemon.");
+	m.Value("adp_daemon_clients", Daemon::NumClients());
+
+	if (!pad)
+		return m.Text();
+
+	auto reports = Device::Reports();
+	auto polling = Device::PollingStats();
+
+	m.Describe("adp_input_reports_total", "counter", "Input reports received since the pad connected.");
+	m.Value("adp_input_reports_total", (double)reports->received);
+	m.Describe("adp_polling_rate_hertz", "gauge", "Input reports received per second.");
+	m.Value("adp_polling_rate_hertz", Device::PollingRate());
+	m.Describe("adp_report_interval_seconds", "summary", "Time between input reports arriving on the host.");
+	m.Quantiles("adp_report_interval_seconds", polling.intervals);
+
+	if (reports->extended)
+	{
+		m.Describe("adp_input_reports_dropped_total", "counter", "Input reports missing from the sequence.");
+		m.Value("adp_input_reports_dropped_total", (double)reports->dropped);
+		m.Describe("adp_input_report_gaps_total", "counter", "Times one or more input reports went missing.");
+		m.Value("adp_input_report_gaps_total", (double)reports->gaps);
+		m.Describe("adp_input_report_largest_gap", "gauge", "Most input reports missing in a row.");
+		m.Value("adp_input_report_largest_gap", reports->largestGap);
+		m.Describe("adp_latency_seconds", "summary", "Device to host latency relative to the fastest report seen.");
+		m.Quantiles("adp_latency_seconds", polling.latency);
+	}
+
+	auto sensorGauge = [&](const char* name, const char* help, double SensorStatistics::*field)
+	{
+		char labels[32];
+		m.Describe(name, "gauge", help);
+		for (int i = 0; i < pad->numSensors; ++i)
+		{
+			snprintf(labels, sizeof(labels), "sensor=\"%i\"", i + 1);
+			m.Value(name, labels, Device::Sensor(i)->statistics.*field);
+		}
+	};
+	sensorGauge("adp_sensor_rest_value", "Smoothed value of the sensor at rest, 0 to 1.",
+		&SensorStatistics::restValue);
+	sensorGauge("adp_sensor_noise", "Standard deviation of the sensor value at rest, 0 to 1.",
+		&SensorStatistics::noise);
+	sensorGauge("adp_sensor_drift", "Change of the rest value since it settled after the pad connected, 0 to 1.",
+		&SensorStatistics::drift);
+	sensorGauge("adp_sensor_drift_per_minute", "Change of the rest value per minute over the last minutes, 0 to 1.",
+		&SensorStatistics::driftPerMinute);
+	sensorGauge("adp_sensor_peak_median", "Median of the highest value of each press, 0 to 1.",
+		&SensorStatistics::peakMedian);
+	sensorGauge("adp_sensor_suggested_threshold", "Threshold suggested by the sensor statistics, 0 if not known yet.",
+		&SensorStatistics::suggestedThreshold);
+
+	char labels[32];
+	m.Describe("adp_sensor_threshold", "gauge", "Press threshold of the sensor, 0 to 1.");
+	for (int i = 0; i < pad->numSensors; ++i)
+	{
+		snprintf(labels, sizeof(labels), "sensor=\"%i\"", i + 1);
+		m.Value("adp_sensor_threshold", labels, Device::Sensor(i)->threshold);
+	}
+
+	if (auto baselines = Device::Baselines())
+	{
+		m.Describe("adp_firmware_baseline", "gauge", "Idle value tracked by the firmware, 0 to 1.");
+		for (int i = 0; i < pad->numSensors; ++i)
+		{
+			snprintf(labels, sizeof(labels), "sensor=\"%i\"", i + 1);
+			m.Value("adp_firmware_baseline", labels, baselines->baselines[i]);
+		}
+		m.Describe("adp_firmware_baseline_offset", "gauge", "Shift of the thresholds by the firmware to follow drift.");
+		for (int i = 0; i < pad->numSensors; ++i)
+		{
+			snprintf(labels, sizeof(labels), "sensor=\"%i\"", i + 1);
+			m.Value("adp_firmware_baseline_offset", labels, baselines->offsets[i]);
+		}
+	}
+
+	if (auto profile = Device::Profile())
+	{
+		m.Describe("adp_firmware_usb_frames_total", "counter", "USB frames seen by the firmware.");
+		m.Value("adp_firmware_usb_frames_total", (double)profile->frames);
+		m.Describe("adp_firmware_usb_configurations_total", "counter", "Times a host configured the pad.");
+		m.Value("adp_firmware_usb_configurations_total", (double)profile->configurations);
+		m.Describe("adp_firmware_scans_total", "counter", "Sensor scans of the firmware.");
+		m.Value("adp_firmware_scans_total", (double)profile->scans);
+		m.Describe("adp_firmware_scan_seconds_total", "counter", "Time the firmware spent scanning sensors.");
+		m.Value("adp_firmware_scan_seconds_total", profile->scanTime * 1e-6);
+		m.Describe("adp_firmware_scan_max_seconds", "gauge", "Longest scan between the last two reads of the counters.");
+		m.Value("adp_firmware_scan_max_seconds", profile->maxScanTime * 1e-6);
+		m.Describe("adp_firmware_input_reports_total", "counter", "Input reports the host took from the firmware.");
+		m.Value("adp_firmware_input_reports_total", (double)profile->reports);
+		m.Describe("adp_firmware_report_age_seconds_total", "counter", "Time from the start of the scans until the host took their reports.");
+		m.Value("adp_firmware_report_age_seconds_total", profile->reportAge * 1e-6);
+		m.Describe("adp_firmware_report_age_max_seconds", "gauge", "Oldest input report between the last two reads of the counters.");
+		m.Value("adp_firmware_report_age_max_seconds", profile->maxReportAge * 1e-6);
+	}
+
+	return m.Text();
+}
+
+bool Metrics::WriteFile(const char* path)
+{
+	auto text = Format();
+	auto temporaryPath = string(path) + ".tmp";
+
+	auto file = fopen(temporaryPath.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+	written = (fclose(file) == 0) && written;
+
+	if (!written || !RenameOver(temporaryPath.c_str(), path))
+	{
+		remove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+}; // namespace adp.
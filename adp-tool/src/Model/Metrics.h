@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+namespace adp {
+
+// Health of the pad and its connection in the Prometheus text format, to spot failing sensors and USB trouble across
+// many cabinets. The values come from statistics the model keeps for every input report anyway, the only extra work
+// is formatting them when the metrics are requested. The counters of firmware with FEATURE_PROFILING and the baselines
+// of firmware with FEATURE_BASELINE are the ones the device reads every few seconds, a request makes no transfers.
+//
+//   adp_pad_connected, adp_pad_info            whether a pad is connected, its name, board and firmware version
+//   adp_connects_total                         pads connected, more than one means the pad reconnected
+//   adp_connection_failures_total              devices put on the failed device list
+//   adp_failed_devices                         devices on the failed device list now
+//   adp_hid_errors_total{transfer}             failed input, get feature, send feature and output transfers
+//   adp_input_reports_*                        input reports received and dropped, polling rate
+//   adp_report_interval_seconds{quantile}      summary of the time between input reports, quantile 1 is the maximum
+//   adp_latency_seconds{quantile}              summary of the device to host latency, extended input only
+//   adp_sensor_*{sensor}                       rest value, noise floor, drift, press peaks and threshold of every
+//                                              sensor, see SensorStatistics.h
+//   adp_firmware_baseline*{sensor}             idle value tracked by the firmware and the threshold offset
+//   adp_firmware_*                             profiling counters of the firmware
+//
+// adp-cli writes the metrics to a file with --metrics and the WebSocket server serves them at /metrics.
+
+class Metrics
+{
+public:
+	// Call on the thread that updates the device.
+	static std::string Format();
+
+	// Writes a temporary file next to the path and renames it, so readers never see a partial file.
+	static bool WriteFile(const char* path);
+};
+
+}; // namespace adp.
@@ -0,0 +1,251 @@
+#include "Adp.h"
+
+#include <cstring>
+
+#include "Model/Recorder.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// ====================================================================================================================
+// Encoding helpers.
+// ====================================================================================================================
+
+static void PutU16(vector<uint8_t>& out, uint16_t value)
+{
+	auto u16 = WriteU16LE(value);
+	out.insert(out.end(), u16.bytes, u16.bytes + sizeof(u16.bytes));
+}
+
+static void PutU32(vector<uint8_t>& out, uint32_t value)
+{
+	auto u32 = WriteU32LE(value);
+	out.insert(out.end(), u32.bytes, u32.bytes + sizeof(u32.bytes));
+}
+
+static void PutU64(vector<uint8_t>& out, uint64_t value)
+{
+	PutU32(out, (uint32_t)value);
+	PutU32(out, (uint32_t)(value >> 32));
+}
+
+static void PutVarint(vector<uint8_t>& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static void PutZigzag(vector<uint8_t>& out, int64_t value)
+{
+	PutVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+// ====================================================================================================================
+// Recorder.
+// ====================================================================================================================
+
+Recorder::Recorder()
+	: myRing(new RecordedSample[RING_SIZE])
+	, myRingHead(0)
+	, myRingTail(0)
+	, myNumDropped(0)
+	, myIsRunning(false)
+{
+}
+
+Recorder::~Recorder()
+{
+	Stop();
+}
+
+bool Recorder::Start(const string& path, int sensorCount, uint8_t flags)
+{
+	Stop();
+
+	myFile = fopen(path.c_str(), "wb");
+	if (!myFile)
+	{
+		Log::Writef(L"Recorder :: could not open %hs", path.c_str());
+		return false;
+	}
+
+	mySensorCount = min(sensorCount, MAX_SENSOR_COUNT);
+	myStartTime = steady_clock::now();
+	myRingHead = 0;
+	myRingTail = 0;
+	myNumDropped = 0;
+	myNumRecorded = 0;
+	myChunk.clear();
+	myChunkSamples = 0;
+	myIndex.clear();
+	myLastIndexOffset = 0;
+	myFileOffset = 0;
+
+	vector<uint8_t> header;
+	PutU32(header, RECORDING_MAGIC);
+	PutU16(header, RECORDING_VERSION);
+	header.push_back((uint8_t)mySensorCount);
+	header.push_back(flags);
+	PutU64(header, duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+	fwrite(header.data(), 1, header.size(), myFile);
+	myFileOffset += header.size();
+
+	myIsRunning = true;
+	myWriter = thread(&Recorder::WriterLoop, this);
+
+	Log::Writef(L"Recorder :: recording to %hs", path.c_str());
+	return true;
+}
+
+void Recorder::Stop()
+{
+	if (!myFile)
+		return;
+
+	myIsRunning = false;
+	myWriter.join();
+
+	Drain();
+	FlushChunk();
+	WriteIndex();
+
+	vector<uint8_t> end;
+	PutU64(end, myLastIndexOffset);
+	WriteBlock(RECORDING_BLOCK_END, end);
+
+	fclose(myFile);
+	myFile = nullptr;
+
+	Log::Writef(L"Recorder :: stopped, %llu samples recorded, %llu dropped",
+		(unsigned long long)myNumRecorded, (unsigned long long)NumDropped());
+}
+
+void Recorder::Push(const SensorValuesReport& report, steady_clock::time_point arrival)
+{
+	if (!myIsRunning.load(memory_order_relaxed))
+		return;
+
+	size_t head = myRingHead.load(memory_order_relaxed);
+	if (head - myRingTail.load(memory_order_acquire) >= RING_SIZE)
+	{
+		myNumDropped.fetch_add(1, memory_order_relaxed);
+		return;
+	}
+
+	auto& sample = myRing[head & (RING_SIZE - 1)];
+	sample.time = duration_cast<microseconds>(arrival - myStartTime).count();
+	sample.deviceTime = ReadU32LE(report.timestamp);
+	sample.sequence = ReadU16LE(report.sequence);
+	sample.buttons = ReadU16LE(report.buttonBits);
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		sample.sensors[i] = ReadU16LE(report.sensorValues[i]);
+
+	myRingHead.store(head + 1, memory_order_release);
+}
+
+void Recorder::WriterLoop()
+{
+	while (myIsRunning)
+	{
+		Drain();
+		this_thread::sleep_for(20ms);
+	}
+}
+
+void Recorder::Drain()
+{
+	size_t tail = myRingTail.load(memory_order_relaxed);
+	size_t head = myRingHead.load(memory_order_acquire);
+
+	for (; tail != head; ++tail)
+	{
+		Encode(myRing[tail & (RING_SIZE - 1)]);
+		myRingTail.store(tail + 1, memory_order_release);
+	}
+}
+
+void Recorder::Encode(const RecordedSample& sample)
+{
+	if (myChunkSamples == 0)
+	{
+		myPrevious = RecordedSample();
+		myPrevious.time = sample.time;
+		myChunkTime = sample.time;
+		myChunk.clear();
+	}
+
+	PutVarint(myChunk, (uint64_t)max<int64_t>(0, sample.time - myPrevious.time));
+	PutVarint(myChunk, (uint32_t)(sample.deviceTime - myPrevious.deviceTime));
+	PutVarint(myChunk, (uint16_t)(sample.sequence - myPrevious.sequence));
+	PutVarint(myChunk, sample.buttons ^ myPrevious.buttons);
+	for (int i = 0; i < mySensorCount; ++i)
+		PutZigzag(myChunk, (int)sample.sensors[i] - (int)myPrevious.sensors[i]);
+
+	myPrevious = sample;
+	++myNumRecorded;
+
+	if (++myChunkSamples == RECORDING_CHUNK_SAMPLES)
+		FlushChunk();
+}
+
+void Recorder::FlushChunk()
+{
+	if (myChunkSamples == 0)
+		return;
+
+	vector<uint8_t> block;
+	block.reserve(12 + myChunk.size());
+	PutU32(block, myChunkSamples);
+	PutU64(block, myChunkTime);
+	block.insert(block.end(), myChunk.begin(), myChunk.end());
+
+	myIndex.push_back({ myFileOffset, myChunkTime, (uint32_t)myChunkSamples });
+	WriteBlock(RECORDING_BLOCK_CHUNK, block);
+	myChunkSamples = 0;
+
+	// Flush every chunk so a crash or power loss only loses the last second of data.
+	fflush(myFile);
+
+	if (myIndex.size() >= RECORDING_INDEX_INTERVAL)
+		WriteIndex();
+}
+
+void Recorder::WriteIndex()
+{
+	if (myIndex.empty())
+		return;
+
+	vector<uint8_t> block;
+	PutU64(block, myLastIndexOffset);
+	PutU32(block, (uint32_t)myIndex.size());
+	for (auto& entry : myIndex)
+	{
+		PutU64(block, entry.offset);
+		PutU64(block, entry.time);
+		PutU32(block, entry.numSamples);
+	}
+
+	myLastIndexOffset = myFileOffset;
+	WriteBlock(RECORDING_BLOCK_INDEX, block);
+	myIndex.clear();
+}
+
+void Recorder::WriteBlock(uint32_t type, const vector<uint8_t>& data)
+{
+	vector<uint8_t> header;
+	PutU32(header, type);
+	PutU32(header, (uint32_t)data.size());
+
+	fwrite(header.data(), 1, header.size(), myFile);
+	fwrite(data.data(), 1, data.size(), myFile);
+	myFileOffset += header.size() + data.size();
+}
+
+}; // namespace adp.
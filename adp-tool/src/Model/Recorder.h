@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Layout of a recording file, all values little endian:
+//
+//   header  "ADPR", u16 version, u8 sensor count, u8 flags, i64 start time in us since the unix epoch
+//   blocks  u32 type, u32 size, followed by size bytes of block data
+//
+// Chunk blocks hold up to RECORDING_CHUNK_SAMPLES samples: u32 sample count, i64 time of the first sample, then per
+// sample a varint time delta, varint device time delta, varint sequence delta, varint of the buttons xor the previous
+// buttons and a zigzag varint delta for every sensor. Deltas start from zero in every chunk, so a chunk can be
+// decoded on its own.
+//
+// Index blocks are written every RECORDING_INDEX_INTERVAL chunks and when recording stops: u64 offset of the
+// previous index block (zero for the first), u32 entry count, then for every chunk since the previous index block its
+// u64 file offset, i64 time of the first sample and u32 sample count.
+//
+// The end block is only present when recording stopped cleanly and holds the u64 offset of the last index block.
+// Readers of an unfinished file can still walk the blocks from the start.
+
+constexpr uint32_t RecordingFourCC(char a, char b, char c, char d)
+{
+	return (uint32_t)(uint8_t)a | (uint32_t)(uint8_t)b << 8 | (uint32_t)(uint8_t)c << 16 | (uint32_t)(uint8_t)d << 24;
+}
+
+constexpr uint32_t RECORDING_MAGIC = RecordingFourCC('A', 'D', 'P', 'R');
+constexpr uint16_t RECORDING_VERSION = 1;
+constexpr size_t RECORDING_HEADER_SIZE = 16;
+constexpr size_t RECORDING_BLOCK_HEADER_SIZE = 8;
+
+constexpr uint32_t RECORDING_BLOCK_CHUNK = RecordingFourCC('C', 'H', 'N', 'K');
+constexpr uint32_t RECORDING_BLOCK_INDEX = RecordingFourCC('I', 'N', 'D', 'X');
+constexpr uint32_t RECORDING_BLOCK_END = RecordingFourCC('A', 'D', 'P', 'E');
+
+enum RecordingFlags
+{
+	RECORDING_FLAG_EXTENDED_INPUT = 1 << 0, // samples carry a device timestamp and sequence number
+};
+
+constexpr int RECORDING_CHUNK_SAMPLES = 1024;
+constexpr int RECORDING_INDEX_INTERVAL = 64;
+
+// One input report as stored in a recording.
+struct RecordedSample
+{
+	int64_t time = 0; // us since the start of the recording, host clock
+	uint32_t deviceTime = 0; // timestamp of the extended input report, zero otherwise
+	uint16_t sequence = 0; // sequence number of the extended input report, zero otherwise
+	uint16_t buttons = 0;
+	uint16_t sensors[MAX_SENSOR_COUNT] = {};
+};
+
+// Writes input reports to a recording file. Push is called by the thread that reads the device and only copies the
+// report into a ring buffer, a background thread encodes and writes it. When the writer falls behind far enough to
+// fill the ring, samples are dropped and counted instead of blocking the reader.
+class Recorder
+{
+public:
+	Recorder();
+	~Recorder();
+
+	bool Start(const std::string& path, int sensorCount, uint8_t flags);
+
+	void Stop();
+
+	bool IsRecording() const { return myFile != nullptr; }
+
+	void Push(const SensorValuesReport& report, std::chrono::steady_clock::time_point arrival);
+
+	uint64_t NumRecorded() const { return myNumRecorded; }
+
+	uint64_t NumDropped() const { return myNumDropped.load(std::memory_order_relaxed); }
+
+private:
+	struct IndexEntry
+	{
+		uint64_t offset;
+		int64_t time;
+		uint32_t numSamples;
+	};
+
+	static constexpr size_t RING_SIZE = 1 << 16;
+
+	void WriterLoop();
+	void Drain();
+	void Encode(const RecordedSample& sample);
+	void FlushChunk();
+	void WriteIndex();
+	void WriteBlock(uint32_t type, const std::vector<uint8_t>& data);
+
+	std::unique_ptr<RecordedSample[]> myRing;
+	std::atomic<size_t> myRingHead; // next slot written by Push
+	std::atomic<size_t> myRingTail; // next slot read by the writer
+	std::atomic<uint64_t> myNumDropped;
+	std::atomic<bool> myIsRunning;
+	std::thread myWriter;
+
+	FILE* myFile = nullptr;
+	uint64_t myFileOffset = 0;
+	int mySensorCount = 0;
+	std::chrono::steady_clock::time_point myStartTime;
+
+	std::vector<uint8_t> myChunk;
+	RecordedSample myPrevious;
+	int myChunkSamples = 0;
+	int64_t myChunkTime = 0;
+	uint64_t myNumRecorded = 0;
+
+	std::vector<IndexEntry> myIndex;
+	uint64_t myLastIndexOffset = 0;
+};
+
+}; // namespace adp.
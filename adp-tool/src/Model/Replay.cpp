@@ -0,0 +1,287 @@
+#include "Adp.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Model/Replay.h"
+#include "Model/Log.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// ====================================================================================================================
+// Decoding helpers.
+// ====================================================================================================================
+
+static bool GetVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; data < end && shift < 64; shift += 7)
+	{
+		uint8_t byte = *data++;
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool GetZigzag(const uint8_t*& data, const uint8_t* end, int64_t& value)
+{
+	uint64_t raw;
+	if (!GetVarint(data, end, raw))
+		return false;
+
+	value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+	return true;
+}
+
+// ====================================================================================================================
+// Recording reader.
+// ====================================================================================================================
+
+RecordingReader::~RecordingReader()
+{
+	Close();
+}
+
+bool RecordingReader::Open(const string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		Log::Writef(L"RecordingReader :: could not open %hs", path.c_str());
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!mapping)
+	{
+		Log::Writef(L"RecordingReader :: could not map %hs", path.c_str());
+		CloseHandle(file);
+		return false;
+	}
+
+	myFileHandle = file;
+	myMappingHandle = mapping;
+	myData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	mySize = (size_t)size.QuadPart;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		Log::Writef(L"RecordingReader :: could not open %hs", path.c_str());
+		return false;
+	}
+
+	struct stat info;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+		data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping keeps the file referenced, the descriptor is no longer needed.
+	close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		Log::Writef(L"RecordingReader :: could not map %hs", path.c_str());
+		return false;
+	}
+
+	myData = (const uint8_t*)data;
+	mySize = (size_t)info.st_size;
+	madvise(data, mySize, MADV_SEQUENTIAL);
+#endif
+
+	if (!myData || mySize < RECORDING_HEADER_SIZE || ReadU32LE(myData) != RECORDING_MAGIC)
+	{
+		Log::Writef(L"RecordingReader :: %hs is not a recording", path.c_str());
+		Close();
+		return false;
+	}
+
+	int version = ReadU16LE(myData + 4);
+	if (version != RECORDING_VERSION)
+	{
+		Log::Writef(L"RecordingReader :: unsupported recording version %i", version);
+		Close();
+		return false;
+	}
+
+	mySensorCount = min((int)myData[6], MAX_SENSOR_COUNT);
+	myFlags = myData[7];
+	myStartTime = (int64_t)ReadU64LE(myData + 8);
+	myOffset = RECORDING_HEADER_SIZE;
+	return true;
+}
+
+void RecordingReader::Close()
+{
+#ifdef _WIN32
+	if (myData)
+		UnmapViewOfFile(myData);
+	if (myMappingHandle)
+		CloseHandle(myMappingHandle);
+	if (myFileHandle)
+		CloseHandle(myFileHandle);
+	myMappingHandle = nullptr;
+	myFileHandle = nullptr;
+#else
+	if (myData)
+		munmap((void*)myData, mySize);
+#endif
+
+	myData = nullptr;
+	mySize = 0;
+	myOffset = 0;
+}
+
+bool RecordingReader::ReadChunk(vector<RecordedSample>& samples)
+{
+	samples.clear();
+
+	// Skip index blocks, stop at the end block or a block that was cut off by an unclean stop.
+	while (myData && myOffset + RECORDING_BLOCK_HEADER_SIZE <= mySize)
+	{
+		uint32_t type = ReadU32LE(myData + myOffset);
+		size_t size = ReadU32LE(myData + myOffset + 4);
+		size_t begin = myOffset + RECORDING_BLOCK_HEADER_SIZE;
+
+		if (type == RECORDING_BLOCK_END || size > mySize - begin)
+			break;
+
+		myOffset = begin + size;
+
+		if (type == RECORDING_BLOCK_CHUNK)
+			return DecodeChunk(myData + begin, size, samples);
+	}
+
+	return false;
+}
+
+bool RecordingReader::DecodeChunk(const uint8_t* data, size_t size, vector<RecordedSample>& samples) const
+{
+	if (size < 12)
+		return false;
+
+	const uint8_t* end = data + size;
+	uint32_t numSamples = ReadU32LE(data);
+	RecordedSample sample;
+	sample.time = (int64_t)ReadU64LE(data + 4);
+	data += 12;
+
+	samples.reserve(numSamples);
+	for (uint32_t i = 0; i < numSamples; ++i)
+	{
+		uint64_t timeDelta, deviceTimeDelta, sequenceDelta, buttons;
+		if (!GetVarint(data, end, timeDelta) || !GetVarint(data, end, deviceTimeDelta) ||
+			!GetVarint(data, end, sequenceDelta) || !GetVarint(data, end, buttons))
+			return false;
+
+		// The first sample of a chunk holds absolute values, its time delta is zero.
+		sample.time += (int64_t)timeDelta;
+		sample.deviceTime += (uint32_t)deviceTimeDelta;
+		sample.sequence += (uint16_t)sequenceDelta;
+		sample.buttons ^= (uint16_t)buttons;
+
+		for (int s = 0; s < mySensorCount; ++s)
+		{
+			int64_t delta;
+			if (!GetZigzag(data, end, delta))
+				return false;
+			sample.sensors[s] = (uint16_t)(sample.sensors[s] + delta);
+		}
+
+		samples.push_back(sample);
+	}
+
+	return true;
+}
+
+// ====================================================================================================================
+// Replay.
+// ====================================================================================================================
+
+Replay::Replay(bool realtime)
+	: myRealtime(realtime)
+{
+}
+
+bool Replay::Open(const string& path)
+{
+	if (!myReader.Open(path))
+		return false;
+
+	mySamples.clear();
+	myPosition = 0;
+	myIsFinished = false;
+	myHasStarted = false;
+
+	Log::Writef(L"Replay :: replaying %hs (%ls)", path.c_str(), myRealtime ? L"realtime" : L"as fast as possible");
+	return true;
+}
+
+ReadDataResult Replay::Get(SensorValuesReport& report)
+{
+	if (myIsFinished)
+		return ReadDataResult::NO_DATA;
+
+	if (myPosition == mySamples.size())
+	{
+		myPosition = 0;
+		if (!myReader.ReadChunk(mySamples) || mySamples.empty())
+		{
+			Log::Write(L"Replay :: end of recording");
+			myIsFinished = true;
+			return ReadDataResult::NO_DATA;
+		}
+	}
+
+	auto& sample = mySamples[myPosition];
+
+	if (!myHasStarted)
+	{
+		myHasStarted = true;
+		myFirstSampleTime = sample.time;
+		myStartTime = steady_clock::now();
+	}
+
+	if (myRealtime)
+	{
+		auto due = myStartTime + microseconds(sample.time - myFirstSampleTime);
+		if (steady_clock::now() < due)
+			return ReadDataResult::NO_DATA;
+	}
+
+	bool extended = (myReader.Flags() & RECORDING_FLAG_EXTENDED_INPUT) != 0;
+	report.reportId = extended ? REPORT_SENSOR_VALUES_EXTENDED : REPORT_SENSOR_VALUES;
+	report.buttonBits = WriteU16LE(sample.buttons);
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		report.sensorValues[i] = WriteU16LE(sample.sensors[i]);
+	report.sequence = WriteU16LE(sample.sequence);
+	for (int i = 0; i < 4; ++i)
+		report.timestamp.bytes[i] = (sample.deviceTime >> (i * 8)) & 0xFF;
+
+	++myPosition;
+	return ReadDataResult::SUCCESS;
+}
+
+}; // namespace adp.
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Model/Recorder.h"
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Reads the chunks of a recording made by Recorder through a read-only memory mapping of the file.
+class RecordingReader
+{
+public:
+	RecordingReader() {}
+	~RecordingReader();
+
+	bool Open(const std::string& path);
+
+	void Close();
+
+	int SensorCount() const { return mySensorCount; }
+
+	uint8_t Flags() const { return myFlags; }
+
+	int64_t StartTime() const { return myStartTime; }
+
+	// Decodes the next chunk of the recording, returns false when there are no more complete chunks.
+	bool ReadChunk(std::vector<RecordedSample>& samples);
+
+	void Rewind() { myOffset = RECORDING_HEADER_SIZE; }
+
+private:
+	bool DecodeChunk(const uint8_t* data, size_t size, std::vector<RecordedSample>& samples) const;
+
+	const uint8_t* myData = nullptr;
+	size_t mySize = 0;
+	size_t myOffset = 0;
+	int mySensorCount = 0;
+	uint8_t myFlags = 0;
+	int64_t myStartTime = 0;
+
+#ifdef _WIN32
+	void* myFileHandle = nullptr;
+	void* myMappingHandle = nullptr;
+#endif
+};
+
+// Plays a recording back as input reports, either at the original timing or as fast as they can be read.
+class Replay
+{
+public:
+	Replay(bool realtime);
+
+	bool Open(const std::string& path);
+
+	int SensorCount() const { return myReader.SensorCount(); }
+
+	bool IsFinished() const { return myIsFinished; }
+
+	ReadDataResult Get(SensorValuesReport& report);
+
+private:
+	RecordingReader myReader;
+	std::vector<RecordedSample> mySamples;
+	size_t myPosition = 0;
+	bool myRealtime;
+	bool myIsFinished = false;
+	bool myHasStarted = false;
+	int64_t myFirstSampleTime = 0;
+	std::chrono::steady_clock::time_point myStartTime;
+};
+
+}; // namespace adp.
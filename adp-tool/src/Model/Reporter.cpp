@@ -1,10 +1,14 @@
 #include "Adp.h"
 
+#include <algorithm>
 #include <cstring>
 #include <chrono>
 #include <thread>
 
 #include "Model/Reporter.h"
+#include "Model/Replay.h"
+#include "Model/Emulator.h"
+#include "Model/Daemon.h"
 #include "Model/Log.h"
 #include "Model/Utils.h"
 
@@ -17,7 +21,7 @@ namespace adp {
 // ====================================================================================================================
 
 template <typename T>
-static bool GetFeatureReport(hid_device* hid, T& report, const wchar_t* name)
+static bool GetFeatureReport(hid_device* hid, T& report, const wchar_t* name, uint64_t& errors)
 {
 	uint8_t buffer[MAX_REPORT_SIZE];
 	buffer[0] = report.reportId;
@@ -37,11 +41,12 @@ static bool GetFeatureReport(hid_device* hid, T& report, const wchar_t* name)
 		Log::Writef(L"%ls :: hid_get_feature_report failed (%ls)", name, hid_error(hid));
 	else
 		Log::Writef(L"%ls :: unexpected number of bytes read (%i) expected (%i)", name, bytesRead, expectedSize);
+	++errors;
 	return false;
 }
 
 template <typename T>
-static bool SendFeatureReport(hid_device* hid, const T& report, const wchar_t* name)
+static bool SendFeatureReport(hid_device* hid, const T& report, const wchar_t* name, uint64_t& errors)
 {
 	using namespace std::chrono_literals;
 
@@ -59,18 +64,83 @@ static bool SendFeatureReport(hid_device* hid, const T& report, const wchar_t* n
 		Log::Writef(L"%ls :: hid_send_feature_report failed (%ls)", name, hid_error(hid));
 	else
 		Log::Writef(L"%ls :: unexpected number of bytes written (%i)", name, bytesWritten);
+	++errors;
 	return false;
 }
 
-template <typename T>
-static ReadDataResult ReadData(hid_device* hid, T& report, const wchar_t* name)
+// Splits a packed input report into extended input reports, one per scan.
+static void UnpackScans(const PackedInputReport& input, deque<SensorValuesReport>& scans)
+{
+	uint32_t timestamp = ReadU32LE(input.timestamp);
+
+	int count = min<int>(input.count, PackedInputReport::MAX_SCANS);
+	for (int i = 0; i < count; ++i)
+	{
+		auto& scan = input.scans[i];
+
+		SensorValuesReport report;
+		report.reportId = REPORT_SENSOR_VALUES_EXTENDED;
+		report.buttonBits = scan.buttonBits;
+		report.sequence = input.sequence;
+
+		uint32_t time = timestamp + scan.time * PackedInputReport::TIME_UNIT_US;
+		report.timestamp = WriteU32LE(time);
+
+		for (int s = 0; s < MAX_SENSOR_COUNT; ++s)
+		{
+			int bit = s * 10;
+			int packed = scan.sensorValues[bit / 8] | (scan.sensorValues[bit / 8 + 1] << 8);
+			int value = (packed >> (bit % 8)) & 0x3FF;
+			report.sensorValues[s] = WriteU16LE(value);
+		}
+
+		scans.push_back(report);
+	}
+}
+
+static ReadDataResult NextScan(deque<SensorValuesReport>& scans, SensorValuesReport& report)
+{
+	if (scans.empty())
+		return ReadDataResult::NO_DATA;
+
+	report = scans.front();
+	scans.pop_front();
+	return ReadDataResult::SUCCESS;
+}
+
+static ReadDataResult ReadData(hid_device* hid, SensorValuesReport& report, deque<SensorValuesReport>& scans,
+	const wchar_t* name)
 {
 	uint8_t buffer[MAX_REPORT_SIZE];
 	buffer[0] = report.reportId;
 
 	int bytesRead = hid_read(hid, buffer, sizeof(buffer));
-	if (bytesRead == sizeof(SensorValuesReport))
+
+	// Joystick reports of firmware with FEATURE_JOYSTICK_AXES are for games, the sensor values carry the same. Raw
+	// reports still in flight after switching back from INPUT_FORMAT_RAW_ADC are dropped.
+	while (bytesRead > 0 && (buffer[0] == REPORT_JOYSTICK || buffer[0] == REPORT_RAW_ADC))
+		bytesRead = hid_read(hid, buffer, sizeof(buffer));
+
+	// Some platforms pad every input report to the size of the largest one, so reports are told apart by their id.
+	if (bytesRead >= (int)sizeof(SensorValuesReport) && buffer[0] == REPORT_SENSOR_VALUES_EXTENDED)
+	{
+		memcpy(&report, buffer, sizeof(SensorValuesReport));
+		return ReadDataResult::SUCCESS;
+	}
+
+	if (bytesRead >= (int)sizeof(PackedInputReport) && buffer[0] == REPORT_PACKED_INPUT)
+	{
+		PackedInputReport packed;
+		memcpy(&packed, buffer, sizeof(PackedInputReport));
+		UnpackScans(packed, scans);
+		return NextScan(scans, report);
+	}
+
+	if (bytesRead >= (int)SENSOR_VALUES_REPORT_SIZE && buffer[0] == REPORT_SENSOR_VALUES)
 	{
+		// The regular report lacks the sequence number and timestamp, they read as zero.
+		static_assert(sizeof(SensorValuesReport) <= MAX_REPORT_SIZE, "the buffer holds an extended report");
+		memset(buffer + SENSOR_VALUES_REPORT_SIZE, 0, sizeof(SensorValuesReport) - SENSOR_VALUES_REPORT_SIZE);
 		memcpy(&report, buffer, sizeof(SensorValuesReport));
 		return ReadDataResult::SUCCESS;
 	}
@@ -86,6 +156,32 @@ static ReadDataResult ReadData(hid_device* hid, T& report, const wchar_t* name)
 	return ReadDataResult::FAILURE;
 }
 
+static ReadDataResult ReadData(hid_device* hid, RawAdcReport& report, const wchar_t* name)
+{
+	uint8_t buffer[MAX_REPORT_SIZE];
+
+	// Input reports still in flight after switching to INPUT_FORMAT_RAW_ADC are dropped.
+	int bytesRead = hid_read(hid, buffer, sizeof(buffer));
+	while (bytesRead > 0 && buffer[0] != REPORT_RAW_ADC)
+		bytesRead = hid_read(hid, buffer, sizeof(buffer));
+
+	if (bytesRead >= (int)sizeof(RawAdcReport))
+	{
+		memcpy(&report, buffer, sizeof(RawAdcReport));
+		return ReadDataResult::SUCCESS;
+	}
+
+	if (bytesRead == 0)
+		return ReadDataResult::NO_DATA;
+
+	if (bytesRead < 0)
+		Log::Writef(L"%ls :: hid_read failed (%ls)", name, hid_error(hid));
+	else
+		Log::Writef(L"%ls :: unexpected number of bytes read (%i)", name, bytesRead);
+
+	return ReadDataResult::FAILURE;
+}
+
 static bool WriteData(hid_device* hid, uint8_t reportId, const wchar_t* name, bool performErrorCheck)
 {
 	// Linux wants reports of at leats 2 bytes
@@ -110,179 +206,477 @@ Reporter::Reporter(hid_device* device)
 {
 }
 
+Reporter::Reporter(unique_ptr<Emulator> emulator)
+	: myHid(nullptr)
+	, myEmulator(move(emulator))
+{
+}
+
+Reporter::Reporter(unique_ptr<Replay> replay)
+	: myHid(nullptr)
+	, myReplay(move(replay))
+{
+	// The emulator answers the feature reports, so changes made while replaying behave like on a real pad.
+	EmulatorSettings settings;
+	settings.sensorCount = myReplay->SensorCount();
+	settings.pattern = EmulatorPattern::IDLE;
+	myEmulator = make_unique<Emulator>(settings);
+}
+
+Reporter::Reporter(unique_ptr<DaemonConnection> daemon)
+	: myHid(nullptr)
+	, myDaemon(move(daemon))
+{
+}
+
 Reporter::Reporter()
+	: Reporter(make_unique<Emulator>(EmulatorSettings()))
 {
-	emulator = true;
 }
 
 Reporter::~Reporter()
 {
-	if(!emulator) {
+	if (myHid) {
 		hid_close(myHid);
 	}
 }
 
 ReadDataResult Reporter::Get(SensorValuesReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myReplay) {
+		return myReplay->Get(report);
+	}
+
+	if (!myScans.empty()) {
+		return NextScan(myScans, report);
+	}
+
+	if (myEmulator) {
+		PackedInputReport packed;
+		if (myEmulator->Get(packed) == ReadDataResult::SUCCESS) {
+			UnpackScans(packed, myScans);
+			return NextScan(myScans, report);
+		}
+		return myEmulator->Get(report);
+	}
+
+	auto result = ReadData(myHid, report, myScans, L"GetSensorValuesReport");
+	if (result == ReadDataResult::FAILURE)
+		++myErrors.reads;
+	return result;
+}
+
+ReadDataResult Reporter::Get(RawAdcReport& report)
+{
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myReplay) {
 		return ReadDataResult::NO_DATA;
 	}
-	
-	return ReadData(myHid, report, L"GetSensorValuesReport");
+
+	if (myEmulator) {
+		return myEmulator->Get(report);
+	}
+
+	auto result = ReadData(myHid, report, L"GetRawAdcReport");
+	if (result == ReadDataResult::FAILURE)
+		++myErrors.reads;
+	return result;
 }
 
 bool Reporter::Get(PadConfigurationReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetPadConfigurationReport");
+	return GetFeatureReport(myHid, report, L"GetPadConfigurationReport", myErrors.gets);
 }
 
 bool Reporter::Get(NameReport& report)
 {
-	if(emulator) {
-		const char* name = "ADP Emulator";
-		memcpy(&report.name, name, sizeof(name));
-		report.size = sizeof(name);
-		
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetNameReport");
+	return GetFeatureReport(myHid, report, L"GetNameReport", myErrors.gets);
 }
 
 bool Reporter::Get(IdentificationReport& report)
 {
-	if(emulator) {
-		report.buttonCount = 12;
-		report.sensorCount = 12;
-		report.ledCount = 0;
-		
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetIdentificationReport");
+	return GetFeatureReport(myHid, report, L"GetIdentificationReport", myErrors.gets);
 }
 
 bool Reporter::Get(IdentificationV2Report& report)
 {
-	if (emulator) {
-		report.buttonCount = 12;
-		report.sensorCount = 12;
-		report.ledCount = 0;
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
 
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetIdentificationV2Report");
+	return GetFeatureReport(myHid, report, L"GetIdentificationV2Report", myErrors.gets);
 }
 
 bool Reporter::Get(LightRuleReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetLightRuleReport");
+	return GetFeatureReport(myHid, report, L"GetLightRuleReport", myErrors.gets);
 }
 
 bool Reporter::Get(LedMappingReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetLedMappingReport");
+	return GetFeatureReport(myHid, report, L"GetLedMappingReport", myErrors.gets);
 }
 
 bool Reporter::Get(SensorReport& report)
 {
-	if (emulator) {
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetSensorReport");
+	return GetFeatureReport(myHid, report, L"GetSensorReport", myErrors.gets);
 }
 
 
 bool Reporter::Get(DebugReport& report)
 {
-	if (emulator) {
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
+		return true;
+	}
+
+	return GetFeatureReport(myHid, report, L"GetDebugReport", myErrors.gets);
+}
+
+bool Reporter::Get(ProfilingReport& report)
+{
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
+		return true;
+	}
+
+	return GetFeatureReport(myHid, report, L"GetProfilingReport", myErrors.gets);
+}
+
+bool Reporter::Get(BaselineReport& report)
+{
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
+		return true;
+	}
+
+	return GetFeatureReport(myHid, report, L"GetBaselineReport", myErrors.gets);
+}
+
+bool Reporter::Get(ButtonReport& report)
+{
+	if (myDaemon) {
+		return myDaemon->Get(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Get(report);
 		return true;
 	}
 
-	return GetFeatureReport(myHid, report, L"GetDebugReport");
+	return GetFeatureReport(myHid, report, L"GetButtonReport", myErrors.gets);
 }
 
 void Reporter::SendReset()
 {
+	if (myDaemon) {
+		myDaemon->SendOutput(REPORT_RESET);
+		return;
+	}
+
+	if (myEmulator) {
+		return;
+	}
+
 	WriteData(myHid, REPORT_RESET, L"SendResetReport", false);
 }
 
 void Reporter::SendFactoryReset()
 {
+	if (myDaemon) {
+		myDaemon->SendOutput(REPORT_FACTORY_RESET);
+		return;
+	}
+
+	if (myEmulator) {
+		myEmulator->FactoryReset();
+		return;
+	}
+
 	WriteData(myHid, REPORT_FACTORY_RESET, L"SendFactoryResetReport", false);
 }
 
 bool Reporter::SendSaveConfiguration()
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->SendOutput(REPORT_SAVE_CONFIGURATION);
+	}
+
+	if (myEmulator) {
 		return true;
 	}
 
-	return WriteData(myHid, REPORT_SAVE_CONFIGURATION, L"SendSaveConfigurationReport", true);
+	if (WriteData(myHid, REPORT_SAVE_CONFIGURATION, L"SendSaveConfigurationReport", true))
+		return true;
+
+	++myErrors.writes;
+	return false;
 }
 
 bool Reporter::Send(const PadConfigurationReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
 		return true;
 	}
 
-	return SendFeatureReport(myHid, report, L"SendPadConfigurationReport");
+	return SendFeatureReport(myHid, report, L"SendPadConfigurationReport", myErrors.sends);
 }
 
 bool Reporter::Send(const NameReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
 		return true;
 	}
 
-	return SendFeatureReport(myHid, report, L"SendNameReport");
+	return SendFeatureReport(myHid, report, L"SendNameReport", myErrors.sends);
 }
 
 bool Reporter::Send(const LightRuleReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
 		return true;
 	}
 
-	return SendFeatureReport(myHid, report, L"SendLightRuleReport");
+	return SendFeatureReport(myHid, report, L"SendLightRuleReport", myErrors.sends);
 }
 
 bool Reporter::Send(const LedMappingReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
 		return true;
 	}
 	
-	return SendFeatureReport(myHid, report, L"SendLedMappingReport");
+	return SendFeatureReport(myHid, report, L"SendLedMappingReport", myErrors.sends);
 }
 
 bool Reporter::Send(const SensorReport& report)
 {
-	return SendFeatureReport(myHid, report, L"SendSensorReport");
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
+		return true;
+	}
+
+	return SendFeatureReport(myHid, report, L"SendSensorReport", myErrors.sends);
+}
+
+bool Reporter::Send(const ButtonReport& report)
+{
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
+		return true;
+	}
+
+	return SendFeatureReport(myHid, report, L"SendButtonReport", myErrors.sends);
+}
+
+bool Reporter::Send(const TransactionReport& report)
+{
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
+		return true;
+	}
+
+	return SendFeatureReport(myHid, report, L"SendTransactionReport", myErrors.sends);
 }
 
 bool Reporter::Send(const SetPropertyReport& report)
 {
-	if(emulator) {
+	if (myDaemon) {
+		return myDaemon->Send(report);
+	}
+
+	if (myEmulator) {
+		myEmulator->Send(report);
 		return true;
 	}
 	
-	return SendFeatureReport(myHid, report, L"SendSetPropertyReport");
+	return SendFeatureReport(myHid, report, L"SendSetPropertyReport", myErrors.sends);
+}
+
+// Raw access by report id, used by the daemon to pass on the requests of its clients.
+
+template <typename T>
+static bool GetRaw(Reporter& reporter, uint8_t* data, size_t size)
+{
+	T report;
+	if (size != sizeof(T) || !reporter.Get(report))
+		return false;
+
+	memcpy(data, &report, sizeof(T));
+	return true;
+}
+
+template <typename T>
+static bool SendRaw(Reporter& reporter, const uint8_t* data, size_t size)
+{
+	T report;
+	if (size != sizeof(T))
+		return false;
+
+	memcpy(&report, data, sizeof(T));
+	return reporter.Send(report);
+}
+
+bool Reporter::GetFeature(uint8_t* report, size_t size)
+{
+	switch (report[0])
+	{
+	case REPORT_PAD_CONFIGURATION: return GetRaw<PadConfigurationReport>(*this, report, size);
+	case REPORT_NAME: return GetRaw<NameReport>(*this, report, size);
+	case REPORT_IDENTIFICATION: return GetRaw<IdentificationReport>(*this, report, size);
+	case REPORT_IDENTIFICATION_V2: return GetRaw<IdentificationV2Report>(*this, report, size);
+	case REPORT_LIGHT_RULE: return GetRaw<LightRuleReport>(*this, report, size);
+	case REPORT_LED_MAPPING: return GetRaw<LedMappingReport>(*this, report, size);
+	case REPORT_SENSOR: return GetRaw<SensorReport>(*this, report, size);
+	case REPORT_DEBUG: return GetRaw<DebugReport>(*this, report, size);
+	case REPORT_PROFILING: return GetRaw<ProfilingReport>(*this, report, size);
+	case REPORT_BASELINE: return GetRaw<BaselineReport>(*this, report, size);
+	case REPORT_BUTTON: return GetRaw<ButtonReport>(*this, report, size);
+	}
+
+	Log::Writef(L"Reporter :: no feature report %i to get", report[0]);
+	return false;
+}
+
+bool Reporter::SendFeature(const uint8_t* report, size_t size)
+{
+	switch (report[0])
+	{
+	case REPORT_PAD_CONFIGURATION: return SendRaw<PadConfigurationReport>(*this, report, size);
+	case REPORT_NAME: return SendRaw<NameReport>(*this, report, size);
+	case REPORT_LIGHT_RULE: return SendRaw<LightRuleReport>(*this, report, size);
+	case REPORT_LED_MAPPING: return SendRaw<LedMappingReport>(*this, report, size);
+	case REPORT_SENSOR: return SendRaw<SensorReport>(*this, report, size);
+	case REPORT_BUTTON: return SendRaw<ButtonReport>(*this, report, size);
+	case REPORT_TRANSACTION: return SendRaw<TransactionReport>(*this, report, size);
+	case REPORT_SET_PROPERTY: return SendRaw<SetPropertyReport>(*this, report, size);
+	}
+
+	Log::Writef(L"Reporter :: no feature report %i to send", report[0]);
+	return false;
+}
+
+bool Reporter::SendOutput(uint8_t reportId)
+{
+	switch (reportId)
+	{
+	case REPORT_RESET: SendReset(); return true;
+	case REPORT_FACTORY_RESET: SendFactoryReset(); return true;
+	case REPORT_SAVE_CONFIGURATION: return SendSaveConfiguration();
+	}
+
+	Log::Writef(L"Reporter :: no output report %i to send", reportId);
+	return false;
 }
 
 bool Reporter::SendAndGet(NameReport& report)
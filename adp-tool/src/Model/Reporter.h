@@ -1,7 +1,11 @@
 #pragma once
 
 #include "stdint.h"
+#include <cstddef>
+#include <cstring>
 #include "hidapi.h"
+#include <memory>
+#include <deque>
 
 // Potentially defined by WinSock2.h
 #ifdef NO_DATA
@@ -29,7 +33,7 @@ enum ReportId
 	REPORT_RESET              = 0x3,
 	REPORT_SAVE_CONFIGURATION = 0x4,
 	REPORT_NAME               = 0x5,
-	REPORT_UNUSED_JOYSTICK    = 0x6,
+	REPORT_JOYSTICK           = 0x6,
 	REPORT_LIGHT_RULE         = 0x7,
 	REPORT_FACTORY_RESET	  = 0x8,
 	REPORT_IDENTIFICATION	  = 0x9,
@@ -38,6 +42,13 @@ enum ReportId
 	REPORT_SENSOR			  = 0xC,
 	REPORT_DEBUG			  = 0xD,
 	REPORT_IDENTIFICATION_V2  = 0xE,
+	REPORT_SENSOR_VALUES_EXTENDED = 0xF,
+	REPORT_PROFILING          = 0x10,
+	REPORT_BASELINE           = 0x11,
+	REPORT_BUTTON             = 0x12,
+	REPORT_TRANSACTION        = 0x13,
+	REPORT_RAW_ADC            = 0x14,
+	REPORT_PACKED_INPUT       = 0x15,
 };
 
 enum class ReadDataResult
@@ -53,11 +64,118 @@ struct color24 { uint8_t red, green, blue; };
 
 struct float32_le { uint32_le bits; };
 
+// Little-endian fields of the reports, and of the recordings and daemon messages that carry them.
+inline int ReadU16LE(const uint8_t* bytes)
+{
+	return bytes[0] | bytes[1] << 8;
+}
+
+inline uint32_t ReadU32LE(const uint8_t* bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+inline uint64_t ReadU64LE(const uint8_t* bytes)
+{
+	return ReadU32LE(bytes) | ((uint64_t)ReadU32LE(bytes + 4) << 32);
+}
+
+inline int ReadU16LE(uint16_le u16)
+{
+	return ReadU16LE(u16.bytes);
+}
+
+inline uint32_t ReadU32LE(uint32_le u32)
+{
+	return ReadU32LE(u32.bytes);
+}
+
+inline float ReadF32LE(float32_le f32)
+{
+	uint32_t u32 = ReadU32LE(f32.bits);
+	float result;
+	memcpy(&result, &u32, sizeof(result));
+	return result;
+}
+
+inline uint16_le WriteU16LE(int value)
+{
+	uint16_le u16;
+	u16.bytes[0] = value & 0xFF;
+	u16.bytes[1] = (value >> 8) & 0xFF;
+	return u16;
+}
+
+inline uint32_le WriteU32LE(uint32_t value)
+{
+	uint32_le u32;
+	u32.bytes[0] = value & 0xFF;
+	u32.bytes[1] = (value >> 8) & 0xFF;
+	u32.bytes[2] = (value >> 16) & 0xFF;
+	u32.bytes[3] = (value >> 24) & 0xFF;
+	return u32;
+}
+
+inline float32_le WriteF32LE(float value)
+{
+	uint32_t u32;
+	memcpy(&u32, &value, sizeof(u32));
+	return { WriteU32LE(u32) };
+}
+
 struct SensorValuesReport
 {
 	uint8_t reportId = REPORT_SENSOR_VALUES;
 	uint16_le buttonBits;
 	uint16_le sensorValues[MAX_SENSOR_COUNT];
+
+	// Only filled in by the extended input report (REPORT_SENSOR_VALUES_EXTENDED), zero otherwise.
+	uint16_le sequence;
+	uint32_le timestamp;
+};
+
+// Size of the regular input report, which lacks the sequence number and timestamp.
+constexpr size_t SENSOR_VALUES_REPORT_SIZE = offsetof(SensorValuesReport, sequence);
+
+// Unfiltered conversions of firmware with FEATURE_RAW_ADC, sent instead of the input reports while the input report
+// format is INPUT_FORMAT_RAW_ADC. Either whole scans of all sensors or samples of the one sensor selected with
+// RAW_ADC_SENSOR.
+struct RawAdcReport
+{
+	static constexpr uint8_t ALL_SENSORS = 0xFF;
+	static constexpr int MAX_SAMPLES = 40;
+	static constexpr int SAMPLE_BITS = 10;
+
+	uint8_t reportId = REPORT_RAW_ADC;
+	uint8_t sensor; // ALL_SENSORS or the sensor converted
+	uint8_t count; // samples, whole scans when all sensors are converted
+	uint32_le timestamp; // device time of the first sample (us)
+	uint16_le duration; // from the first sample, or scan, to the last (us)
+	uint8_t samples[MAX_SAMPLES * SAMPLE_BITS / 8]; // least significant bit first
+};
+
+struct PackedScan
+{
+	uint16_le buttonBits;
+	uint8_t time; // since the first scan of the report, in PackedInputReport::TIME_UNIT_US
+	uint8_t sensorValues[(MAX_SENSOR_COUNT * 10 + 7) / 8]; // 10 bits each, least significant bit first
+};
+
+// Scans of firmware with FEATURE_PACKED_INPUT, sent instead of the input reports while the input report format is
+// INPUT_FORMAT_PACKED. The pad scans several times per report, the reporter passes every scan on as an extended input
+// report with the sequence number of its report and the time of the scan as timestamp. The buttons of the newest scan
+// come first, for the games.
+struct PackedInputReport
+{
+	static constexpr int MAX_SCANS = 3;
+	static constexpr int TIME_UNIT_US = 4;
+
+	uint8_t reportId = REPORT_PACKED_INPUT;
+	uint16_le buttonBits; // of the newest scan
+	uint16_le sequence;
+	uint32_le timestamp; // device time of the first scan (us)
+	uint8_t count; // scans used
+	PackedScan scans[MAX_SCANS];
 };
 
 struct PadConfigurationReport
@@ -99,6 +217,16 @@ struct IdentificationV2Report : public IdentificationReport
 		FEATURE_DEBUG = 1 << 0,
 		FEATURE_DIGIPOT = 1 << 1,
 		FEATURE_LIGHTS = 1 << 2,
+		FEATURE_DEBUG_TRACE = 1 << 3,
+		FEATURE_EXTENDED_INPUT = 1 << 4,
+		FEATURE_PROFILING = 1 << 5,
+		FEATURE_BASELINE = 1 << 6,
+		FEATURE_JOYSTICK_AXES = 1 << 7,
+		FEATURE_BUTTON_MODES = 1 << 8,
+		FEATURE_TRANSACTIONS = 1 << 9,
+		FEATURE_SOF_SYNC = 1 << 10,
+		FEATURE_RAW_ADC = 1 << 11,
+		FEATURE_PACKED_INPUT = 1 << 12,
 	};
 
 	uint16_le features;
@@ -131,8 +259,16 @@ struct SensorReport
 	enum Ids
 	{
 		ADC_DISABLED		= 1 << 0,
+		BASELINE_TRACKING	= 1 << 1, // thresholds follow the idle value, firmware with FEATURE_BASELINE
+		JOYSTICK_AXIS		= 1 << 2, // drives a joystick axis, firmware with FEATURE_JOYSTICK_AXES
 	};
 
+	// Axis and response curve of a sensor with JOYSTICK_AXIS, in the upper bits of the flags.
+	static constexpr int JOYSTICK_AXIS_SHIFT = 8;
+	static constexpr int JOYSTICK_AXIS_MASK = 0x7 << JOYSTICK_AXIS_SHIFT;
+	static constexpr int JOYSTICK_CURVE_SHIFT = 12;
+	static constexpr int JOYSTICK_CURVE_MASK = 0x3 << JOYSTICK_CURVE_SHIFT;
+
 	uint8_t reportId = REPORT_SENSOR;
 	uint8_t index;
 	uint16_le threshold;
@@ -142,36 +278,140 @@ struct SensorReport
 	uint16_le flags;
 };
 
+// How the sensors of a button are combined, firmware with FEATURE_BUTTON_MODES.
+struct ButtonReport
+{
+	enum Modes
+	{
+		MODE_ANY			= 0, // any sensor above its own threshold
+		MODE_SUM			= 1, // sum of the sensor values above the threshold of the button
+		MODE_WEIGHTED_SUM	= 2, // same, every sensor value multiplied by its weight
+		MODE_K_OF_N			= 3, // count sensors above their own thresholds
+	};
+
+	// Weights are fixed point, 64 is one.
+	static constexpr int WEIGHT_ONE = 64;
+
+	uint8_t reportId = REPORT_BUTTON;
+	uint8_t index;
+	uint8_t mode;
+	uint8_t count;
+	uint16_le threshold; // of the sum modes, in sensor units
+	uint16_le releaseThreshold;
+	uint8_t sensorWeights[MAX_SENSOR_COUNT]; // the pad only takes those of the sensors mapped to the button
+};
+
 struct SetPropertyReport
 {
 	enum Ids
 	{
 		SELECTED_LIGHT_RULE_INDEX = 0,
 		SELECTED_LED_MAPPING_INDEX = 1,
-		SELECTED_SENSOR_INDEX = 2
+		SELECTED_SENSOR_INDEX = 2,
+		INPUT_REPORT_FORMAT = 3,
+		SELECTED_BUTTON_INDEX = 4,
+		RAW_ADC_SENSOR = 5,
+	};
+	enum InputReportFormat
+	{
+		INPUT_FORMAT_DEFAULT = 0,
+		INPUT_FORMAT_EXTENDED = 1,
+		INPUT_FORMAT_RAW_ADC = 2, // firmware with FEATURE_RAW_ADC, see RawAdcReport
+		INPUT_FORMAT_PACKED = 3, // firmware with FEATURE_PACKED_INPUT, see PackedInputReport
 	};
 	uint8_t reportId = REPORT_SET_PROPERTY;
 	uint32_le propertyId;
 	uint32_le propertyValue;
 };
 
+enum DebugEvent
+{
+	DEBUG_EVENT_PRESS     = 0x01,
+	DEBUG_EVENT_RELEASE   = 0x02,
+	DEBUG_EVENT_SCAN_TIME = 0x03,
+	DEBUG_EVENT_MESSAGE   = 0xFF,
+};
+
+// Binary record in the debug packet of firmware with FEATURE_DEBUG_TRACE. Message records
+// (DEBUG_EVENT_MESSAGE) are instead followed by a length byte and the message text.
+struct DebugTraceRecord
+{
+	uint8_t event;
+	uint16_le timestamp;
+	uint16_le args[2];
+};
+
+// Counters of firmware with FEATURE_PROFILING, they all wrap around.
+struct ProfilingReport
+{
+	uint8_t reportId = REPORT_PROFILING;
+	uint32_le frames; // USB start of frame events, one per ms while a host is connected
+	uint32_le scans; // sensor scans, one for every input report
+	uint32_le scanTime; // total time spent scanning in us
+	uint16_le maxScanTime; // longest scan in us since the previous profiling report
+	uint16_le configurations; // times a host configured the device since power on
+	uint32_le reports; // input reports the host took
+	uint32_le reportAge; // total time in us from the start of their scan until the host took them
+	uint16_le maxReportAge; // oldest input report in us since the previous profiling report
+};
+
+// Baselines of firmware with FEATURE_BASELINE. Sensors with BASELINE_TRACKING follow their idle value, their
+// thresholds are shifted by the offset, which is how far the baseline moved since the threshold was set.
+struct BaselineReport
+{
+	uint8_t reportId = REPORT_BASELINE;
+	uint16_le baselines[MAX_SENSOR_COUNT]; // zero for sensors without tracking
+	uint16_le offsets[MAX_SENSOR_COUNT]; // signed
+};
+
+// Firmware with FEATURE_TRANSACTIONS applies the configuration reports sent between BEGIN and COMMIT once, at the
+// commit. Feature reports read in between show the configuration in use.
+struct TransactionReport
+{
+	enum Actions
+	{
+		COMMIT = 0,
+		BEGIN  = 1,
+	};
+
+	uint8_t reportId = REPORT_TRANSACTION;
+	uint8_t action;
+};
+
 struct DebugReport
 {
 	uint8_t reportId = REPORT_DEBUG;
 	uint16_le messageSize;
-	char messagePacket[32];
+	uint8_t messagePacket[32];
 };
 
 #pragma pack()
 
+class Replay;
+class Emulator;
+class DaemonConnection;
+
+// Failed transfers of a reporter, for monitoring the connection.
+struct ReporterErrors
+{
+	uint64_t reads = 0; // input reports
+	uint64_t gets = 0; // feature reports read
+	uint64_t sends = 0; // feature reports written
+	uint64_t writes = 0; // output reports
+};
+
 class Reporter
 {
 public:
 	Reporter(hid_device* device);
+	Reporter(std::unique_ptr<Emulator> emulator);
+	Reporter(std::unique_ptr<Replay> replay);
+	Reporter(std::unique_ptr<DaemonConnection> daemon);
 	Reporter();
 	~Reporter();
 
 	ReadDataResult Get(SensorValuesReport& report);
+	ReadDataResult Get(RawAdcReport& report);
 	bool Get(PadConfigurationReport& report);
 	bool Get(NameReport& report);
 	bool Get(IdentificationReport& report);
@@ -180,6 +420,9 @@ public:
 	bool Get(LedMappingReport& report);
 	bool Get(SensorReport& report);
 	bool Get(DebugReport& report);
+	bool Get(ProfilingReport& report);
+	bool Get(BaselineReport& report);
+	bool Get(ButtonReport& report);
 
 	void SendReset();
 	void SendFactoryReset();
@@ -189,15 +432,30 @@ public:
 	bool Send(const LightRuleReport& report);
 	bool Send(const LedMappingReport& report);
 	bool Send(const SensorReport& report);
+	bool Send(const ButtonReport& report);
+	bool Send(const TransactionReport& report);
 	bool Send(const SetPropertyReport& report);
 
 
 	bool SendAndGet(NameReport& report);
 	bool SendAndGet(PadConfigurationReport& report);
 
+	// Reports as bytes with the report id first, for passing them on without knowing their type.
+	bool GetFeature(uint8_t* report, size_t size);
+	bool SendFeature(const uint8_t* report, size_t size);
+	bool SendOutput(uint8_t reportId);
+
+	bool IsVirtual() const { return myHid == nullptr && myDaemon == nullptr; }
+
+	const ReporterErrors& Errors() const { return myErrors; }
+
 private:
 	hid_device* myHid;
-	bool emulator = false;
+	ReporterErrors myErrors;
+	std::unique_ptr<Emulator> myEmulator;
+	std::unique_ptr<Replay> myReplay;
+	std::unique_ptr<DaemonConnection> myDaemon;
+	std::deque<SensorValuesReport> myScans; // of the last packed input report, not passed on yet
 };
 
 }; // namespace adp.
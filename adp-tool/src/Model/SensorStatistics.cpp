@@ -0,0 +1,157 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Model/SensorStatistics.h"
+#include "Model/Reporter.h"
+
+using namespace std;
+
+namespace adp {
+
+// The rest statistics are smoothed over about a second of reports at 1000 Hz.
+constexpr double REST_SMOOTHING = 1.0 / 1024.0;
+
+// A suggested threshold stays this many standard deviations of noise above the rest value, and at least this far.
+constexpr double NOISE_MARGIN = 6.0;
+constexpr double MIN_MARGIN = 0.02;
+
+// Fraction of the way from the noise margin up to the low press peaks, low enough that light steps still count.
+constexpr double PEAK_FRACTION = 1.0 / 3.0;
+
+constexpr double SCALAR = 1.0 / (double)MAX_SENSOR_VALUE;
+
+SensorStatisticsTracker::SensorStatisticsTracker()
+{
+	Reset();
+}
+
+void SensorStatisticsTracker::Reset()
+{
+	myCount = 0;
+	myMean = 0.0;
+	mySquaredDeviations = 0.0;
+
+	myQuietReports = 0;
+	myRestCount = 0;
+	myRestMean = 0.0;
+	myRestVariance = 0.0;
+	mySettledRestMean = 0.0;
+	for (auto& restMean : myMinuteRestMeans)
+		restMean = 0.0;
+	myMinutes = 0;
+
+	myIsPressed = false;
+	myPeak = 0;
+	myPresses = 0;
+	for (auto& count : myPeakCounts)
+		count = 0;
+}
+
+void SensorStatisticsTracker::Add(int value, bool pressed)
+{
+	++myCount;
+	double delta = value - myMean;
+	myMean += delta / (double)myCount;
+	mySquaredDeviations += delta * (value - myMean);
+
+	if (pressed)
+	{
+		myPeak = myIsPressed ? max(myPeak, value) : value;
+		myIsPressed = true;
+		myQuietReports = 0;
+		return;
+	}
+
+	if (myIsPressed)
+	{
+		int bin = min(PEAK_BINS - 1, max(0, myPeak) * PEAK_BINS / (MAX_SENSOR_VALUE + 1));
+		++myPeakCounts[bin];
+		++myPresses;
+		myIsPressed = false;
+	}
+
+	if (++myQuietReports <= QUIET_REPORTS)
+		return;
+
+	// Exponentially weighted mean and variance, updated in the same incremental way as Welford's algorithm.
+	if (myRestCount == 0)
+	{
+		myRestMean = value;
+		myRestVariance = 0.0;
+	}
+	else
+	{
+		double restDelta = value - myRestMean;
+		myRestMean += restDelta * REST_SMOOTHING;
+		myRestVariance = (1.0 - REST_SMOOTHING) * (myRestVariance + REST_SMOOTHING * restDelta * restDelta);
+	}
+
+	if (++myRestCount == SETTLE_SAMPLES)
+		mySettledRestMean = myRestMean;
+}
+
+void SensorStatisticsTracker::NextMinute()
+{
+	if (myRestCount < SETTLE_SAMPLES)
+		return;
+
+	myMinuteRestMeans[myMinutes % DRIFT_MINUTES] = myRestMean;
+	++myMinutes;
+}
+
+double SensorStatisticsTracker::PeakPercentile(double percentile) const
+{
+	uint64_t target = max<uint64_t>(1, (uint64_t)ceil(myPresses * percentile / 100.0));
+	uint64_t seen = 0;
+	int bin = 0;
+	for (; bin < PEAK_BINS - 1; ++bin)
+	{
+		seen += myPeakCounts[bin];
+		if (seen >= target)
+			break;
+	}
+	double center = (bin + 0.5) * (MAX_SENSOR_VALUE + 1) / PEAK_BINS;
+	return min(1.0, center * SCALAR);
+}
+
+void SensorStatisticsTracker::Summarize(SensorStatistics& statistics) const
+{
+	statistics.samples = myCount;
+	statistics.mean = myMean * SCALAR;
+	statistics.deviation = myCount > 1 ? sqrt(mySquaredDeviations / (double)(myCount - 1)) * SCALAR : 0.0;
+
+	bool settled = (myRestCount >= SETTLE_SAMPLES);
+	statistics.restSamples = myRestCount;
+	statistics.restValue = myRestMean * SCALAR;
+	statistics.noise = sqrt(myRestVariance) * SCALAR;
+	statistics.drift = settled ? (myRestMean - mySettledRestMean) * SCALAR : 0.0;
+
+	int snapshots = min(myMinutes, DRIFT_MINUTES);
+	if (snapshots >= 2)
+	{
+		double newest = myMinuteRestMeans[(myMinutes - 1) % DRIFT_MINUTES];
+		double oldest = myMinuteRestMeans[(myMinutes - snapshots) % DRIFT_MINUTES];
+		statistics.driftPerMinute = (newest - oldest) / (snapshots - 1) * SCALAR;
+	}
+	else
+	{
+		statistics.driftPerMinute = 0.0;
+	}
+
+	statistics.presses = myPresses;
+	statistics.peakLow = myPresses > 0 ? PeakPercentile(10.0) : 0.0;
+	statistics.peakMedian = myPresses > 0 ? PeakPercentile(50.0) : 0.0;
+	statistics.peakHigh = myPresses > 0 ? PeakPercentile(90.0) : 0.0;
+
+	statistics.suggestedThreshold = 0.0;
+	if (settled && myPresses >= MIN_PRESSES)
+	{
+		double lowest = statistics.restValue + max(MIN_MARGIN, statistics.noise * NOISE_MARGIN);
+		if (statistics.peakLow > lowest)
+			statistics.suggestedThreshold = lowest + (statistics.peakLow - lowest) * PEAK_FRACTION;
+	}
+}
+
+}; // namespace adp.
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+namespace adp {
+
+// Summary of the statistics of one sensor. Values are normalized 0 to 1 like SensorState::value.
+struct SensorStatistics
+{
+	uint64_t samples = 0; // input reports since the pad connected
+	double mean = 0.0; // of every value, pressed or not
+	double deviation = 0.0; // standard deviation of every value
+
+	uint64_t restSamples = 0; // input reports the sensor was at rest in
+	double restValue = 0.0; // smoothed value at rest
+	double noise = 0.0; // standard deviation of the value at rest, the noise floor
+	double drift = 0.0; // change of the rest value since it settled after connecting
+	double driftPerMinute = 0.0; // change of the rest value per minute, over the last minutes
+
+	int presses = 0; // presses with a recorded peak
+	double peakLow = 0.0; // 10th percentile of the highest value of each press
+	double peakMedian = 0.0;
+	double peakHigh = 0.0; // 90th percentile
+
+	// Threshold that clears the noise floor and is reached by nearly every press, zero until enough is known.
+	double suggestedThreshold = 0.0;
+};
+
+// Online statistics of one sensor, fed with every value of every input report. Memory is fixed and nothing is
+// allocated, so the tracker keeps up with the full report rate:
+//
+//   Welford's algorithm gives the running mean and variance of all values.
+//   Values at rest, taken a while after the sensor was released, go into an exponentially weighted mean and variance
+//   over about a second of reports at 1000 Hz. The rest value once settled and a ring of per minute snapshots give
+//   the drift of the baseline.
+//   The highest value of each press goes into a linear histogram, which gives the spread of press peaks.
+class SensorStatisticsTracker
+{
+public:
+	SensorStatisticsTracker();
+
+	void Reset();
+
+	// Adds a value in device units, pressed is the state of the button the sensor is mapped to.
+	void Add(int value, bool pressed);
+
+	// Takes the snapshot of the rest value for the drift per minute, call once a minute.
+	void NextMinute();
+
+	// Fills in the summary, call once per device update rather than per value.
+	void Summarize(SensorStatistics& statistics) const;
+
+	static constexpr int QUIET_REPORTS = 200;
+	static constexpr int SETTLE_SAMPLES = 2048;
+	static constexpr int DRIFT_MINUTES = 10;
+	static constexpr int PEAK_BINS = 128;
+	static constexpr int MIN_PRESSES = 5;
+
+private:
+	double PeakPercentile(double percentile) const;
+
+	// All values.
+	uint64_t myCount;
+	double myMean;
+	double mySquaredDeviations;
+
+	// Values at rest.
+	int myQuietReports;
+	uint64_t myRestCount;
+	double myRestMean;
+	double myRestVariance;
+	double mySettledRestMean;
+	double myMinuteRestMeans[DRIFT_MINUTES];
+	int myMinutes;
+
+	// Press peaks.
+	bool myIsPressed;
+	int myPeak;
+	int myPresses;
+	uint32_t myPeakCounts[PEAK_BINS];
+};
+
+}; // namespace adp.
@@ -0,0 +1,1210 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "Model/Server.h"
+#include "Model/Metrics.h"
+#include "Model/Log.h"
+#include "Model/Utils.h"
+
+using namespace std;
+using namespace chrono;
+
+namespace adp {
+
+// An encoded message, or the handshake response, shared by every client it is sent to.
+typedef shared_ptr<const vector<uint8_t>> Frame;
+
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+constexpr size_t MAX_MESSAGE_SIZE = 65536;
+constexpr int MAX_POLL_MS = 100;
+constexpr auto CALIBRATION_TIME = seconds(1);
+
+enum WebSocketOpcode
+{
+	WS_CONTINUATION = 0x0,
+	WS_TEXT = 0x1,
+	WS_BINARY = 0x2,
+	WS_CLOSE = 0x8,
+	WS_PING = 0x9,
+	WS_PONG = 0xA,
+};
+
+// ====================================================================================================================
+// Sockets.
+// ====================================================================================================================
+
+#ifdef _WIN32
+
+typedef SOCKET SocketHandle;
+typedef WSAPOLLFD PollEntry;
+
+static const SocketHandle INVALID_HANDLE = INVALID_SOCKET;
+static const int SEND_FLAGS = 0;
+
+static void CloseSocket(SocketHandle s)
+{
+	closesocket(s);
+}
+
+static int PollSockets(PollEntry* entries, size_t count, int timeoutMs)
+{
+	return WSAPoll(entries, (ULONG)count, timeoutMs);
+}
+
+static bool WouldBlock()
+{
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+static void SetNonBlocking(SocketHandle s)
+{
+	u_long enabled = 1;
+	ioctlsocket(s, FIONBIO, &enabled);
+}
+
+#else
+
+typedef int SocketHandle;
+typedef pollfd PollEntry;
+
+static const SocketHandle INVALID_HANDLE = -1;
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+
+static void CloseSocket(SocketHandle s)
+{
+	close(s);
+}
+
+static int PollSockets(PollEntry* entries, size_t count, int timeoutMs)
+{
+	return poll(entries, count, timeoutMs);
+}
+
+static bool WouldBlock()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+static void SetNonBlocking(SocketHandle s)
+{
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+}
+
+#endif
+
+// ====================================================================================================================
+// Encoding helpers.
+// ====================================================================================================================
+
+static uint32_t RotateLeft(uint32_t value, int bits)
+{
+	return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1 as required by the WebSocket handshake, not used for anything else.
+static void Sha1(const string& input, uint8_t out[20])
+{
+	uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+	vector<uint8_t> message(input.begin(), input.end());
+	uint64_t numBits = (uint64_t)input.size() * 8;
+	message.push_back(0x80);
+	while (message.size() % 64 != 56)
+		message.push_back(0);
+	for (int i = 7; i >= 0; --i)
+		message.push_back((uint8_t)(numBits >> (i * 8)));
+
+	for (size_t block = 0; block < message.size(); block += 64)
+	{
+		uint32_t w[80];
+		for (int i = 0; i < 16; ++i)
+		{
+			auto p = &message[block + i * 4];
+			w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+		}
+		for (int i = 16; i < 80; ++i)
+			w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+		uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+		for (int i = 0; i < 80; ++i)
+		{
+			uint32_t f, k;
+			if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+			else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+			else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+			else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+			uint32_t t = RotateLeft(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = RotateLeft(b, 30);
+			b = a;
+			a = t;
+		}
+
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
+	}
+
+	for (int i = 0; i < 20; ++i)
+		out[i] = (uint8_t)(h[i / 4] >> ((3 - i % 4) * 8));
+}
+
+static string Base64(const uint8_t* data, size_t size)
+{
+	static const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	string out;
+	for (size_t i = 0; i < size; i += 3)
+	{
+		uint32_t n = (uint32_t)data[i] << 16;
+		if (i + 1 < size) n |= (uint32_t)data[i + 1] << 8;
+		if (i + 2 < size) n |= data[i + 2];
+
+		out.push_back(digits[(n >> 18) & 63]);
+		out.push_back(digits[(n >> 12) & 63]);
+		out.push_back(i + 1 < size ? digits[(n >> 6) & 63] : '=');
+		out.push_back(i + 2 < size ? digits[n & 63] : '=');
+	}
+	return out;
+}
+
+static Frame EncodeFrame(uint8_t opcode, const void* data, size_t size)
+{
+	auto frame = make_shared<vector<uint8_t>>();
+	frame->reserve(size + 10);
+	frame->push_back(0x80 | opcode);
+
+	if (size < 126)
+	{
+		frame->push_back((uint8_t)size);
+	}
+	else if (size <= 0xFFFF)
+	{
+		frame->push_back(126);
+		frame->push_back((uint8_t)(size >> 8));
+		frame->push_back((uint8_t)size);
+	}
+	else
+	{
+		frame->push_back(127);
+		for (int i = 7; i >= 0; --i)
+			frame->push_back((uint8_t)((uint64_t)size >> (i * 8)));
+	}
+
+	auto bytes = static_cast<const uint8_t*>(data);
+	frame->insert(frame->end(), bytes, bytes + size);
+	return frame;
+}
+
+static Frame EncodeEvent(const char* name, const json& data)
+{
+	auto text = json({ {"event", name}, {"data", data} }).dump();
+	return EncodeFrame(WS_TEXT, text.data(), text.size());
+}
+
+static void PutU16(uint8_t*& out, uint16_t value)
+{
+	auto u16 = WriteU16LE(value);
+	out = copy(u16.bytes, u16.bytes + sizeof(u16.bytes), out);
+}
+
+static void PutU32(uint8_t*& out, uint32_t value)
+{
+	auto u32 = WriteU32LE(value);
+	out = copy(u32.bytes, u32.bytes + sizeof(u32.bytes), out);
+}
+
+static string ToLower(string s)
+{
+	transform(s.begin(), s.end(), s.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+	return s;
+}
+
+// Returns the value of the given header of an HTTP request, or an empty string. The name must be lowercase.
+static string FindHeader(const string& request, const char* name)
+{
+	size_t lineStart = request.find("\r\n");
+	while (lineStart != string::npos)
+	{
+		lineStart += 2;
+		size_t lineEnd = request.find("\r\n", lineStart);
+		if (lineEnd == string::npos)
+			break;
+
+		auto line = request.substr(lineStart, lineEnd - lineStart);
+		auto colon = line.find(':');
+		if (colon != string::npos && ToLower(line.substr(0, colon)) == name)
+		{
+			auto begin = line.find_first_not_of(" \t", colon + 1);
+			auto end = line.find_last_not_of(" \t");
+			return begin == string::npos ? string() : line.substr(begin, end - begin + 1);
+		}
+		lineStart = lineEnd;
+	}
+	return string();
+}
+
+// ====================================================================================================================
+// Server.
+// ====================================================================================================================
+
+// Pages of any site can open a WebSocket to a local port, only pages served from this machine and the allowed
+// origins get to control the pad. Origins are "scheme://host[:port]".
+static bool IsLocalOrigin(const string& origin)
+{
+	auto schemeEnd = origin.find("://");
+	if (schemeEnd == string::npos)
+		return false;
+
+	auto scheme = ToLower(origin.substr(0, schemeEnd));
+	if (scheme != "http" && scheme != "https")
+		return false;
+
+	auto host = ToLower(origin.substr(schemeEnd + 3));
+	auto hostEnd = host[0] == '[' ? host.find(']') : host.find(':');
+	if (hostEnd != string::npos && host[0] == '[')
+		++hostEnd;
+
+	auto port = hostEnd == string::npos ? string() : host.substr(hostEnd);
+	host = host.substr(0, hostEnd);
+	if (!port.empty() && (port.size() < 2 || port[0] != ':' || port.find_first_not_of("0123456789", 1) != string::npos))
+		return false;
+
+	return host == "localhost" || host == "127.0.0.1" || host == "[::1]";
+}
+
+static bool IsAllowedOrigin(const string& origin, const vector<string>& allowedOrigins)
+{
+	if (origin.empty() || IsLocalOrigin(origin))
+		return true;
+
+	auto lower = ToLower(origin);
+	for (auto& allowed : allowedOrigins)
+	{
+		auto entry = ToLower(allowed);
+		while (!entry.empty() && entry.back() == '/')
+			entry.pop_back();
+		if (lower == entry)
+			return true;
+	}
+	return false;
+}
+
+static bool IsArrayOf(const json& value, bool (json::*isType)() const)
+{
+	if (!value.is_array())
+		return false;
+
+	for (auto& element : value)
+	{
+		if (!(element.*isType)())
+			return false;
+	}
+	return true;
+}
+
+// Why a command of a client cannot be applied, or null if it can. Unknown events are left to ApplyCommand.
+static const char* CommandError(const string& event, const json& data)
+{
+	if (!data.is_object())
+		return "data must be an object";
+
+	if (data.contains("deviceId") && !data["deviceId"].is_string())
+		return "deviceId must be a string";
+
+	if (data.contains("store") && !data["store"].is_boolean())
+		return "store must be a boolean";
+
+	if (event == "updateConfiguration")
+	{
+		if (!data.contains("configuration") || !data["configuration"].is_object())
+			return "configuration must be an object";
+
+		auto& configuration = data["configuration"];
+		if (configuration.contains("name") && !configuration["name"].is_string())
+			return "name must be a string";
+		if (configuration.contains("releaseThreshold") && !configuration["releaseThreshold"].is_number())
+			return "releaseThreshold must be a number";
+		if (configuration.contains("sensorThresholds") &&
+			!IsArrayOf(configuration["sensorThresholds"], &json::is_number))
+			return "sensorThresholds must be an array of numbers";
+		if (configuration.contains("sensorToButtonMapping") &&
+			!IsArrayOf(configuration["sensorToButtonMapping"], &json::is_number_integer))
+			return "sensorToButtonMapping must be an array of integers";
+	}
+	else if (event == "updateSensorThreshold")
+	{
+		if (!data.contains("sensorIndex") || !data["sensorIndex"].is_number_integer())
+			return "sensorIndex must be an integer";
+		if (!data.contains("newThreshold") || !data["newThreshold"].is_number())
+			return "newThreshold must be a number";
+	}
+	else if (event == "calibrate")
+	{
+		if (!data.contains("calibrationBuffer") || !data["calibrationBuffer"].is_number())
+			return "calibrationBuffer must be a number";
+	}
+	return nullptr;
+}
+
+struct ServerClient
+{
+	SocketHandle socket = INVALID_HANDLE;
+	wstring address;
+
+	string request; // handshake bytes received so far
+	vector<uint8_t> received; // bytes of incomplete messages
+	bool upgraded = false;
+	bool wantsMetrics = false; // plain HTTP request for the metrics, answered by the next update
+	bool closing = false; // disconnect once the queue is sent
+	bool closed = false;
+
+	deque<Frame> queue;
+	size_t queuedBytes = 0;
+	Frame sending;
+	size_t sendOffset = 0;
+
+	bool subscribed = false;
+	Frame input; // newest input frame that was not sent yet
+	steady_clock::duration inputInterval = {};
+	steady_clock::time_point nextInput;
+};
+
+struct CalibrationState
+{
+	bool active = false;
+	double buffer = 0.0;
+	int numSamples = 0;
+	double average[MAX_SENSOR_COUNT] = {};
+	steady_clock::time_point end;
+};
+
+class WebSocketServer
+{
+public:
+	WebSocketServer(SocketHandle listener, SocketHandle wakeSocket, sockaddr_in wakeAddress, uint16_t port,
+		vector<string> allowedOrigins)
+		: myListener(listener)
+		, myWakeSocket(wakeSocket)
+		, myWakeAddress(wakeAddress)
+		, myPort(port)
+		, myAllowedOrigins(move(allowedOrigins))
+		, myIsRunning(true)
+	{
+		myThread = thread(&WebSocketServer::Loop, this);
+	}
+
+	~WebSocketServer()
+	{
+		myIsRunning = false;
+		Wake();
+		myThread.join();
+
+		for (auto& client : myClients)
+			CloseSocket(client->socket);
+
+		CloseSocket(myListener);
+		CloseSocket(myWakeSocket);
+	}
+
+	uint16_t Port() const { return myPort; }
+
+	int NumClients()
+	{
+		lock_guard<mutex> lock(myMutex);
+		return (int)myClients.size();
+	}
+
+	void Update(DeviceChanges changes)
+	{
+		vector<json> commands;
+		bool metricsRequested;
+		{
+			lock_guard<mutex> lock(myMutex);
+			swap(commands, myCommands);
+			metricsRequested = myMetricsRequested;
+			myMetricsRequested = false;
+		}
+
+		for (auto& command : commands)
+			ApplyCommand(command);
+
+		// Calibration belongs to the pad it was started on.
+		if (changes & DCF_DEVICE)
+			myCalibration.active = false;
+
+		UpdateCalibration();
+
+		// Thresholds can change without a change flag, compare the published state instead.
+		auto devices = DevicesUpdatedEvent();
+		auto text = devices.dump();
+		bool devicesChanged = (text != myDevicesText);
+		if (devicesChanged)
+			myDevicesText = text;
+
+		auto now = steady_clock::now();
+		bool sendEventRate = (now >= myNextEventRate);
+		if (sendEventRate)
+			myNextEventRate = now + seconds(1);
+
+		// Only formatted when requested, it reads the profiling counters from the pad.
+		Frame metrics;
+		if (metricsRequested)
+		{
+			auto text = Metrics::Format();
+			auto response =
+				"HTTP/1.1 200 OK\r\n"
+				"Content-Type: text/plain; version=0.0.4\r\n"
+				"Content-Length: " + to_string(text.size()) + "\r\n"
+				"Connection: close\r\n\r\n" + text;
+			metrics = make_shared<vector<uint8_t>>(response.begin(), response.end());
+		}
+
+		lock_guard<mutex> lock(myMutex);
+
+		if (metrics)
+		{
+			for (auto& client : myClients)
+			{
+				if (client->wantsMetrics)
+				{
+					Queue(*client, metrics);
+					client->wantsMetrics = false;
+					client->closing = true;
+				}
+			}
+		}
+
+		if (devicesChanged)
+		{
+			myDevicesFrame = EncodeEvent("devicesUpdated", devices);
+			for (auto& client : myClients)
+			{
+				if (client->upgraded)
+					Queue(*client, myDevicesFrame);
+			}
+		}
+
+		Frame input, eventRate;
+		for (auto& client : myClients)
+		{
+			if (!client->subscribed || !Device::Pad())
+				continue;
+
+			if (!input)
+				input = EncodeInput();
+
+			// Replaces an input frame the client did not get to yet, input is never queued.
+			client->input = input;
+
+			if (sendEventRate)
+			{
+				if (!eventRate)
+					eventRate = EncodeEvent("eventRate", { {"deviceId", SERVER_DEVICE_ID}, {"eventRate", Device::PollingRate()} });
+				Queue(*client, eventRate);
+			}
+		}
+
+		if (devicesChanged || input || eventRate || metrics)
+			Wake();
+	}
+
+private:
+	void Wake()
+	{
+		char byte = 0;
+		sendto(myWakeSocket, &byte, 1, 0, (const sockaddr*)&myWakeAddress, sizeof(myWakeAddress));
+	}
+
+	// Must be called with the mutex locked.
+	void Queue(ServerClient& client, const Frame& frame)
+	{
+		if (client.closed)
+			return;
+
+		if (client.queuedBytes + frame->size() > SERVER_MAX_QUEUED_BYTES)
+		{
+			Log::Writef(L"Server :: disconnecting %ls, it does not keep up", client.address.c_str());
+			client.closed = true;
+			return;
+		}
+
+		client.queue.push_back(frame);
+		client.queuedBytes += frame->size();
+	}
+
+	Frame EncodeInput()
+	{
+		auto pad = Device::Pad();
+
+		uint32_t buttons = 0;
+		uint8_t message[12 + MAX_SENSOR_COUNT * 2];
+		uint8_t* out = message + 12;
+
+		for (int i = 0; i < pad->numSensors; ++i)
+		{
+			auto sensor = Device::Sensor(i);
+			if (sensor->pressed && sensor->button > 0 && sensor->button <= 32)
+				buttons |= 1u << (sensor->button - 1);
+			PutU16(out, (uint16_t)lround(clamp(sensor->value, 0.0, 1.0) * 65535.0));
+		}
+
+		uint8_t* header = message;
+		*header++ = SERVER_FRAME_INPUT;
+		*header++ = (uint8_t)pad->numSensors;
+		PutU16(header, 0);
+		PutU32(header, myFrameNumber++);
+		PutU32(header, buttons);
+
+		return EncodeFrame(WS_BINARY, message, out - message);
+	}
+
+	json DevicesUpdatedEvent()
+	{
+		json devices = json::object();
+
+		auto pad = Device::Pad();
+		if (pad)
+		{
+			json thresholds = json::array();
+			json mapping = json::array();
+			for (int i = 0; i < pad->numSensors; ++i)
+			{
+				auto sensor = Device::Sensor(i);
+				thresholds.push_back(sensor->threshold);
+				mapping.push_back(sensor->button - 1);
+			}
+
+			devices[SERVER_DEVICE_ID] = {
+				{"id", SERVER_DEVICE_ID},
+				{"configuration", {
+					{"name", pad->name},
+					{"sensorThresholds", thresholds},
+					{"releaseThreshold", pad->releaseThreshold},
+					{"sensorToButtonMapping", mapping},
+				}},
+				{"properties", {
+					{"buttonCount", pad->numButtons},
+					{"sensorCount", pad->numSensors},
+				}},
+				{"calibration", myCalibration.active ? json({ {"calibrationBuffer", myCalibration.buffer} }) : json()},
+			};
+		}
+
+		return { {"devices", devices} };
+	}
+
+	void ApplyConfiguration(const json& configuration)
+	{
+		auto pad = Device::Pad();
+
+		if (configuration.contains("name"))
+			Device::SetDeviceName(configuration["name"].get<string>().c_str());
+
+		if (configuration.contains("releaseThreshold"))
+			Device::SetReleaseThreshold(configuration["releaseThreshold"].get<double>());
+
+		if (configuration.contains("sensorThresholds"))
+		{
+			auto& thresholds = configuration["sensorThresholds"];
+			for (int i = 0; i < pad->numSensors && i < (int)thresholds.size(); ++i)
+				Device::SetThreshold(i, clamp(thresholds[i].get<double>(), 0.0, 1.0));
+		}
+
+		if (configuration.contains("sensorToButtonMapping"))
+		{
+			auto& mapping = configuration["sensorToButtonMapping"];
+			for (int i = 0; i < pad->numSensors && i < (int)mapping.size(); ++i)
+			{
+				int button = mapping[i].get<int>() + 1;
+				Device::SetButtonMapping(i, (button > 0 && button <= pad->numButtons) ? button : 0);
+			}
+		}
+	}
+
+	void ApplyCommand(const json& command)
+	{
+		try
+		{
+			auto event = command.at("event").get<string>();
+			auto& data = command.at("data");
+
+			auto pad = Device::Pad();
+			if (!pad || data.value("deviceId", "") != SERVER_DEVICE_ID)
+				return;
+
+			if (event == "updateConfiguration")
+			{
+				ApplyConfiguration(data.at("configuration"));
+				if (data.value("store", false))
+					Device::SaveChanges();
+			}
+			else if (event == "saveConfiguration")
+			{
+				Device::SaveChanges();
+			}
+			else if (event == "updateSensorThreshold")
+			{
+				int sensorIndex = data.at("sensorIndex").get<int>();
+				if (sensorIndex >= 0 && sensorIndex < pad->numSensors)
+					Device::SetThreshold(sensorIndex, clamp(data.at("newThreshold").get<double>(), 0.0, 1.0));
+				if (data.value("store", false))
+					Device::SaveChanges();
+			}
+			else if (event == "calibrate")
+			{
+				myCalibration = CalibrationState();
+				myCalibration.active = true;
+				myCalibration.buffer = data.at("calibrationBuffer").get<double>();
+				myCalibration.end = steady_clock::now() + CALIBRATION_TIME;
+			}
+			else
+			{
+				Log::Writef(L"Server :: unknown event %ls", widen(event.data(), event.size()).c_str());
+			}
+		}
+		catch (exception& e)
+		{
+			Log::Writef(L"Server :: invalid command: %hs", e.what());
+		}
+	}
+
+	// Averages the sensor values for a while, then puts the thresholds the calibration buffer above the average.
+	void UpdateCalibration()
+	{
+		auto pad = Device::Pad();
+		if (!myCalibration.active)
+			return;
+
+		if (!pad)
+		{
+			myCalibration.active = false;
+			return;
+		}
+
+		myCalibration.numSamples++;
+		for (int i = 0; i < pad->numSensors; ++i)
+		{
+			auto& average = myCalibration.average[i];
+			average += (Device::Sensor(i)->value - average) / myCalibration.numSamples;
+		}
+
+		if (steady_clock::now() < myCalibration.end)
+			return;
+
+		for (int i = 0; i < pad->numSensors; ++i)
+			Device::SetThreshold(i, clamp(myCalibration.average[i] + myCalibration.buffer, 0.0, 1.0));
+
+		Device::SaveChanges();
+		myCalibration.active = false;
+	}
+
+	// The functions below run on the server thread.
+
+	void Loop()
+	{
+		vector<PollEntry> entries;
+		while (myIsRunning)
+		{
+			auto now = steady_clock::now();
+			int timeout = MAX_POLL_MS;
+
+			entries.clear();
+			entries.push_back({ myListener, POLLIN, 0 });
+			entries.push_back({ myWakeSocket, POLLIN, 0 });
+			{
+				lock_guard<mutex> lock(myMutex);
+				for (auto& client : myClients)
+				{
+					short events = POLLIN;
+					if (HasDataToSend(*client, now, timeout))
+						events |= POLLOUT;
+					entries.push_back({ client->socket, events, 0 });
+				}
+			}
+
+			if (PollSockets(entries.data(), entries.size(), timeout) < 0 && !WouldBlock())
+			{
+				Log::Write(L"Server :: poll failed, stopping");
+				break;
+			}
+
+			if (entries[1].revents & POLLIN)
+			{
+				char buffer[64];
+				while (recv(myWakeSocket, buffer, sizeof(buffer), 0) > 0);
+			}
+
+			now = steady_clock::now();
+			lock_guard<mutex> lock(myMutex);
+
+			// Only this thread adds and removes clients, so the entries still line up with the clients.
+			for (size_t i = 2; i < entries.size(); ++i)
+			{
+				auto& client = *myClients[i - 2];
+				if (entries[i].revents & (POLLIN | POLLHUP | POLLERR))
+					Receive(client);
+				Send(client, now);
+			}
+
+			for (auto it = myClients.begin(); it != myClients.end();)
+			{
+				if ((*it)->closed)
+				{
+					Log::Writef(L"Server :: %ls disconnected", (*it)->address.c_str());
+					CloseSocket((*it)->socket);
+					it = myClients.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+
+			if (entries[0].revents & POLLIN)
+				Accept();
+		}
+	}
+
+	// Must be called with the mutex locked.
+	void Accept()
+	{
+		sockaddr_in address = {};
+		socklen_t addressSize = sizeof(address);
+		SocketHandle s = accept(myListener, (sockaddr*)&address, &addressSize);
+		if (s == INVALID_HANDLE)
+			return;
+
+		SetNonBlocking(s);
+		int noDelay = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+		char host[INET_ADDRSTRLEN] = {};
+		inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+		auto name = string(host) + ":" + to_string(ntohs(address.sin_port));
+
+		auto client = make_unique<ServerClient>();
+		client->socket = s;
+		client->address = widen(name.data(), name.size());
+		myClients.push_back(move(client));
+	}
+
+	// Must be called with the mutex locked. Lowers the timeout to when a rate limited input frame is due.
+	bool HasDataToSend(const ServerClient& client, steady_clock::time_point now, int& timeout)
+	{
+		if (client.sending || !client.queue.empty())
+			return true;
+
+		if (!client.input)
+			return false;
+
+		if (now >= client.nextInput)
+			return true;
+
+		auto wait = (int)duration_cast<milliseconds>(client.nextInput - now).count() + 1;
+		timeout = min(timeout, wait);
+		return false;
+	}
+
+	// Must be called with the mutex locked.
+	void Receive(ServerClient& client)
+	{
+		uint8_t buffer[4096];
+		while (!client.closed)
+		{
+			auto size = recv(client.socket, (char*)buffer, sizeof(buffer), 0);
+			if (size == 0 || (size < 0 && !WouldBlock()))
+			{
+				client.closed = true;
+				return;
+			}
+			if (size < 0)
+				return;
+
+			if (client.upgraded)
+			{
+				client.received.insert(client.received.end(), buffer, buffer + size);
+				ParseMessages(client);
+			}
+			else
+			{
+				client.request.append((const char*)buffer, size);
+				Handshake(client);
+			}
+		}
+	}
+
+	// Must be called with the mutex locked.
+	void Handshake(ServerClient& client)
+	{
+		auto end = client.request.find("\r\n\r\n");
+		if (end == string::npos)
+		{
+			if (client.request.size() > MAX_REQUEST_SIZE)
+				client.closed = true;
+			return;
+		}
+
+		// Metrics for monitoring, the response is queued by the next update.
+		if (client.request.compare(0, 13, "GET /metrics ") == 0)
+		{
+			client.wantsMetrics = true;
+			client.request.clear();
+			myMetricsRequested = true;
+			return;
+		}
+
+		auto key = FindHeader(client.request, "sec-websocket-key");
+		if (client.request.compare(0, 4, "GET ") != 0 || key.empty())
+		{
+			static const string response = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+			Queue(client, make_shared<vector<uint8_t>>(response.begin(), response.end()));
+			client.closing = true;
+			client.request.clear();
+			return;
+		}
+
+		// Browsers always send the origin of the page, other clients usually send none.
+		auto origin = FindHeader(client.request, "origin");
+		if (!IsAllowedOrigin(origin, myAllowedOrigins))
+		{
+			Log::Writef(L"Server :: refused %ls from origin %hs", client.address.c_str(), origin.c_str());
+			static const string response = "HTTP/1.1 403 Forbidden\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+			Queue(client, make_shared<vector<uint8_t>>(response.begin(), response.end()));
+			client.closing = true;
+			client.request.clear();
+			return;
+		}
+
+		uint8_t hash[20];
+		Sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", hash);
+
+		auto response =
+			"HTTP/1.1 101 Switching Protocols\r\n"
+			"Upgrade: websocket\r\n"
+			"Connection: Upgrade\r\n"
+			"Sec-WebSocket-Accept: " + Base64(hash, sizeof(hash)) + "\r\n\r\n";
+		Queue(client, make_shared<vector<uint8_t>>(response.begin(), response.end()));
+
+		// Like a Socket.IO connection, a new client gets the device list right away.
+		if (myDevicesFrame)
+			Queue(client, myDevicesFrame);
+
+		Log::Writef(L"Server :: %ls connected", client.address.c_str());
+
+		client.upgraded = true;
+		client.received.assign(client.request.begin() + end + 4, client.request.end());
+		client.request.clear();
+		ParseMessages(client);
+	}
+
+	// Must be called with the mutex locked. Fragmented messages are not supported, clients do not fragment messages
+	// as small as the commands.
+	void ParseMessages(ServerClient& client)
+	{
+		auto& in = client.received;
+		size_t pos = 0;
+
+		while (!client.closed && !client.closing && in.size() - pos >= 2)
+		{
+			uint8_t opcode = in[pos] & 0x0F;
+			bool final = (in[pos] & 0x80) != 0;
+			bool masked = (in[pos + 1] & 0x80) != 0;
+			uint64_t size = in[pos + 1] & 0x7F;
+			size_t header = 2;
+
+			if (size == 126)
+			{
+				if (in.size() - pos < 4)
+					break;
+				size = (uint64_t)in[pos + 2] << 8 | in[pos + 3];
+				header = 4;
+			}
+			else if (size == 127)
+			{
+				if (in.size() - pos < 10)
+					break;
+				size = 0;
+				for (int i = 0; i < 8; ++i)
+					size = size << 8 | in[pos + 2 + i];
+				header = 10;
+			}
+
+			if (!masked || !final || opcode == WS_CONTINUATION || size > MAX_MESSAGE_SIZE)
+			{
+				Log::Writef(L"Server :: unsupported message from %ls", client.address.c_str());
+				client.closed = true;
+				break;
+			}
+
+			if (in.size() - pos < header + 4 + size)
+				break;
+
+			const uint8_t* mask = &in[pos + header];
+			string payload(size, '\0');
+			for (size_t i = 0; i < size; ++i)
+				payload[i] = (char)(in[pos + header + 4 + i] ^ mask[i % 4]);
+			pos += header + 4 + size;
+
+			switch (opcode)
+			{
+			case WS_TEXT:
+				HandleMessage(client, payload);
+				break;
+			case WS_PING:
+				Queue(client, EncodeFrame(WS_PONG, payload.data(), payload.size()));
+				break;
+			case WS_CLOSE:
+				Queue(client, EncodeFrame(WS_CLOSE, payload.data(), min<size_t>(payload.size(), 2)));
+				client.closing = true;
+				client.subscribed = false;
+				client.input.reset();
+				break;
+			default:
+				break;
+			}
+		}
+
+		in.erase(in.begin(), in.begin() + min(pos, in.size()));
+	}
+
+	// Must be called with the mutex locked. Events that only concern the client are handled here, the others are
+	// applied on the next update.
+	void HandleMessage(ServerClient& client, const string& text)
+	{
+		auto message = json::parse(text, nullptr, false);
+		if (message.is_discarded() || !message.is_object() || !message.contains("event") || !message["event"].is_string())
+		{
+			Log::Writef(L"Server :: invalid message from %ls", client.address.c_str());
+			return;
+		}
+
+		auto event = message["event"].get<string>();
+		auto& data = message["data"];
+
+		if (event == "subscribeToDevice")
+		{
+			client.subscribed = data.is_object() && data.value("deviceId", "") == SERVER_DEVICE_ID;
+		}
+		else if (event == "unsubscribeFromDevice")
+		{
+			client.subscribed = false;
+			client.input.reset();
+		}
+		else if (event == "setInputRate")
+		{
+			double maxRate = data.is_object() ? data.value("maxRate", 0.0) : 0.0;
+			client.inputInterval = maxRate > 0.0
+				? duration_cast<steady_clock::duration>(duration<double>(1.0 / maxRate))
+				: steady_clock::duration::zero();
+		}
+		else if (auto error = CommandError(event, data))
+		{
+			// Rejected here, where the client is known, so a malformed command never reaches the pad.
+			Log::Writef(L"Server :: invalid %hs command from %ls: %hs", event.c_str(), client.address.c_str(), error);
+			Queue(client, EncodeEvent("error", { {"event", event}, {"message", error} }));
+		}
+		else
+		{
+			myCommands.push_back(move(message));
+		}
+	}
+
+	// Must be called with the mutex locked.
+	void Send(ServerClient& client, steady_clock::time_point now)
+	{
+		while (!client.closed)
+		{
+			if (!client.sending)
+			{
+				if (!client.queue.empty())
+				{
+					client.sending = move(client.queue.front());
+					client.queue.pop_front();
+					client.queuedBytes -= client.sending->size();
+				}
+				else if (client.input && now >= client.nextInput)
+				{
+					client.sending = move(client.input);
+					client.input.reset();
+					client.nextInput = now + client.inputInterval;
+				}
+				else
+				{
+					break;
+				}
+				client.sendOffset = 0;
+			}
+
+			auto& frame = *client.sending;
+			auto sent = send(client.socket, (const char*)frame.data() + client.sendOffset,
+				(int)(frame.size() - client.sendOffset), SEND_FLAGS);
+
+			if (sent < 0)
+			{
+				if (!WouldBlock())
+					client.closed = true;
+				break;
+			}
+
+			client.sendOffset += sent;
+			if (client.sendOffset == frame.size())
+				client.sending.reset();
+		}
+
+		if (client.closing && !client.sending && client.queue.empty())
+			client.closed = true;
+	}
+
+	SocketHandle myListener;
+	SocketHandle myWakeSocket;
+	sockaddr_in myWakeAddress;
+	uint16_t myPort;
+	const vector<string> myAllowedOrigins;
+	atomic<bool> myIsRunning;
+	thread myThread;
+
+	mutex myMutex;
+	vector<unique_ptr<ServerClient>> myClients;
+	vector<json> myCommands;
+	Frame myDevicesFrame;
+	bool myMetricsRequested = false;
+
+	// Only used by the thread that calls Update.
+	string myDevicesText;
+	uint32_t myFrameNumber = 0;
+	steady_clock::time_point myNextEventRate;
+	CalibrationState myCalibration;
+};
+
+// ====================================================================================================================
+// Server API.
+// ====================================================================================================================
+
+static WebSocketServer* server = nullptr;
+
+static SocketHandle OpenSocket(int type, const char* address, uint16_t port, sockaddr_in& boundAddress)
+{
+	SocketHandle s = socket(AF_INET, type, 0);
+	if (s == INVALID_HANDLE)
+		return INVALID_HANDLE;
+
+	int reuse = 1;
+	if (type == SOCK_STREAM)
+		setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in bindAddress = {};
+	bindAddress.sin_family = AF_INET;
+	bindAddress.sin_port = htons(port);
+	socklen_t boundSize = sizeof(boundAddress);
+
+	if (inet_pton(AF_INET, address, &bindAddress.sin_addr) != 1 ||
+		::bind(s, (const sockaddr*)&bindAddress, sizeof(bindAddress)) != 0 ||
+		(type == SOCK_STREAM && listen(s, 16) != 0) ||
+		getsockname(s, (sockaddr*)&boundAddress, &boundSize) != 0)
+	{
+		CloseSocket(s);
+		return INVALID_HANDLE;
+	}
+
+	SetNonBlocking(s);
+	return s;
+}
+
+bool Server::Start(uint16_t port, const char* address, const vector<string>& allowedOrigins)
+{
+	Stop();
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		return false;
+#endif
+
+	sockaddr_in listenAddress, wakeAddress;
+	auto listener = OpenSocket(SOCK_STREAM, address, port, listenAddress);
+	auto wakeSocket = OpenSocket(SOCK_DGRAM, "127.0.0.1", 0, wakeAddress);
+
+	if (listener == INVALID_HANDLE || wakeSocket == INVALID_HANDLE)
+	{
+		Log::Writef(L"Server :: could not listen on %hs:%i", address, port);
+		if (listener != INVALID_HANDLE) CloseSocket(listener);
+		if (wakeSocket != INVALID_HANDLE) CloseSocket(wakeSocket);
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	server = new WebSocketServer(listener, wakeSocket, wakeAddress, ntohs(listenAddress.sin_port),
+		allowedOrigins);
+	Log::Writef(L"Server :: listening on %hs:%i", address, server->Port());
+	return true;
+}
+
+void Server::Stop()
+{
+	if (!server)
+		return;
+
+	delete server;
+	server = nullptr;
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+
+	Log::Write(L"Server :: stopped");
+}
+
+bool Server::IsRunning()
+{
+	return server != nullptr;
+}
+
+uint16_t Server::Port()
+{
+	return server ? server->Port() : 0;
+}
+
+int Server::NumClients()
+{
+	return server ? server->NumClients() : 0;
+}
+
+void Server::Update(DeviceChanges changes)
+{
+	if (server)
+		server->Update(changes);
+}
+
+}; // namespace adp.
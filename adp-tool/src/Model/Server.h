@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Model/Device.h"
+
+namespace adp {
+
+// Embedded WebSocket server that replaces the legacy Socket.IO server for web clients. It speaks the events of
+// common-types/events.ts over plain WebSocket messages:
+//
+//   text messages    JSON objects {"event": <name>, "data": <payload>} in both directions, for every event except
+//                    input. The server sends devicesUpdated and eventRate. Clients send subscribeToDevice,
+//                    unsubscribeFromDevice, updateConfiguration, saveConfiguration, updateSensorThreshold and
+//                    calibrate, plus setInputRate {"maxRate": <hz>} to limit their input messages, zero for no limit.
+//                    Commands with missing or mistyped fields are not applied, the client gets an error event
+//                    {"event": <name of the command>, "message": <reason>} instead.
+//
+//   binary messages  input events of the connected pad to subscribed clients, all values little endian:
+//                    u8 type (SERVER_FRAME_INPUT), u8 sensor count, u16 reserved, u32 frame number,
+//                    u32 button bits (bit 0 is the first button), u16 per sensor with the value scaled to 0-65535.
+//
+// Every input frame is encoded once and shared by all subscribed clients. A client holds at most one unsent input
+// frame, a newer frame replaces it, so slow clients and rate limited clients skip frames instead of queueing them.
+// Other messages are queued, a client that lets SERVER_MAX_QUEUED_BYTES of them pile up is disconnected.
+//
+// WebSocket handshakes with an Origin header are refused with 403 unless the origin is on this machine (localhost,
+// 127.0.0.1 or [::1] over http or https, any port) or one of the allowed origins given to Start.
+//
+// A plain HTTP GET of /metrics is answered with the metrics of Metrics.h instead of a WebSocket handshake.
+//
+// The sockets are served by a background thread. Commands that change the pad are applied on the thread that calls
+// Update, the same thread that updates the device.
+
+constexpr uint16_t SERVER_DEFAULT_PORT = 3333;
+constexpr uint8_t SERVER_FRAME_INPUT = 1;
+constexpr size_t SERVER_MAX_QUEUED_BYTES = 1 << 20;
+constexpr const char* SERVER_DEVICE_ID = "adp-tool";
+
+class Server
+{
+public:
+	// Listens on the given address, only local clients can connect with the default. Allowed origins are compared
+	// with the Origin header of handshakes, like "https://example.com:8080".
+	static bool Start(uint16_t port = SERVER_DEFAULT_PORT, const char* address = "127.0.0.1",
+		const std::vector<std::string>& allowedOrigins = {});
+
+	static void Stop();
+
+	static bool IsRunning();
+
+	static uint16_t Port();
+
+	static int NumClients();
+
+	// Applies client commands and publishes the pad state, call after Device::Update with the changes it returned.
+	static void Update(DeviceChanges changes);
+};
+
+}; // namespace adp.
@@ -0,0 +1,169 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Model/SharedState.h"
+#include "Model/Device.h"
+#include "Model/Reporter.h"
+#include "Model/Log.h"
+
+using namespace std;
+
+namespace adp {
+
+static_assert(SHARED_STATE_MAX_SENSORS == MAX_SENSOR_COUNT, "the shared state must hold every sensor");
+
+SharedStateWriter::SharedStateWriter()
+{
+}
+
+SharedStateWriter::~SharedStateWriter()
+{
+	Stop();
+}
+
+bool SharedStateWriter::Start(const string& name)
+{
+	Stop();
+
+	void* memory = nullptr;
+
+#ifdef _WIN32
+	auto path = "Local\\" + name;
+	auto mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(SharedPadState), path.c_str());
+	if (mapping)
+	{
+		memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedPadState));
+		if (memory)
+			myMapping = mapping;
+		else
+			CloseHandle(mapping);
+	}
+#else
+	auto path = "/" + name;
+	// The region of a previous run that did not stop is reused, and left for whoever created it to remove.
+	int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	bool created = (fd >= 0);
+	if (!created && errno == EEXIST)
+		fd = shm_open(path.c_str(), O_RDWR, 0644);
+	if (fd >= 0)
+	{
+		if (ftruncate(fd, sizeof(SharedPadState)) == 0)
+		{
+			memory = mmap(nullptr, sizeof(SharedPadState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (memory == MAP_FAILED)
+				memory = nullptr;
+		}
+		close(fd);
+	}
+	if (!memory && created)
+		shm_unlink(path.c_str());
+	myIsCreator = created;
+#endif
+
+	if (!memory)
+	{
+		Log::Writef(L"SharedState :: could not create %hs", path.c_str());
+		return false;
+	}
+
+	// A reader may still have the region of a previous run mapped, start from an odd sequence so it waits.
+	myState = new (memory) SharedPadState;
+	myState->sequence.store(1, memory_order_relaxed);
+	myState->magic = SHARED_STATE_MAGIC;
+	myState->version = SHARED_STATE_VERSION;
+	myState->size = sizeof(SharedPadState);
+	myState->reserved = 0;
+	memset(&myState->data, 0, sizeof(myState->data));
+	myState->sequence.store(2, memory_order_release);
+
+	myName = path;
+	Log::Writef(L"SharedState :: publishing to %hs", path.c_str());
+	return true;
+}
+
+void SharedStateWriter::Stop()
+{
+	if (!myState)
+		return;
+
+	Disconnect();
+
+#ifdef _WIN32
+	UnmapViewOfFile(myState);
+	CloseHandle(myMapping);
+	myMapping = nullptr;
+#else
+	munmap(myState, sizeof(SharedPadState));
+	if (myIsCreator)
+		shm_unlink(myName.c_str());
+	myIsCreator = false;
+#endif
+
+	myState = nullptr;
+	myName.clear();
+}
+
+void SharedStateWriter::BeginWrite()
+{
+	auto sequence = myState->sequence.load(memory_order_relaxed);
+	myState->sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+void SharedStateWriter::EndWrite()
+{
+	auto sequence = myState->sequence.load(memory_order_relaxed);
+	myState->sequence.store(sequence + 1, memory_order_release);
+}
+
+void SharedStateWriter::Publish(const SensorValuesReport& report, int64_t hostTime, uint64_t reportCount,
+	int sensorCount, const SensorState* sensors)
+{
+	if (!myState)
+		return;
+
+	constexpr float scalar = 1.0f / (float)MAX_SENSOR_VALUE;
+	bool extended = (report.reportId == REPORT_SENSOR_VALUES_EXTENDED);
+
+	BeginWrite();
+
+	auto& data = myState->data;
+	data.flags = SHARED_STATE_CONNECTED | (extended ? SHARED_STATE_EXTENDED : 0);
+	data.sensorCount = sensorCount;
+	data.buttons = ReadU16LE(report.buttonBits);
+	data.deviceSequence = extended ? ReadU16LE(report.sequence) : 0;
+	data.deviceTime = extended ? ReadU32LE(report.timestamp) : 0;
+	data.reportCount = reportCount;
+	data.hostTime = hostTime;
+
+	for (int i = 0; i < sensorCount; ++i)
+	{
+		data.sensors[i] = min(1.0f, ReadU16LE(report.sensorValues[i]) * scalar);
+		data.thresholds[i] = (float)sensors[i].threshold;
+	}
+
+	EndWrite();
+}
+
+void SharedStateWriter::Disconnect()
+{
+	if (!myState || !(myState->data.flags & SHARED_STATE_CONNECTED))
+		return;
+
+	BeginWrite();
+	myState->data.flags = 0;
+	EndWrite();
+}
+
+}; // namespace adp.
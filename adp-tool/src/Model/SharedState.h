@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace adp {
+
+struct SensorState;
+struct SensorValuesReport;
+
+// Latest pad state published in shared memory, so other local processes like game plugins can read it without a
+// second HID handle. The region is named SHARED_STATE_DEFAULT_NAME unless another name is given: a POSIX shared
+// memory object "/<name>" (shm_open) or a named file mapping "Local\<name>" on Windows. It holds one SharedPadState.
+//
+// The writer updates the region for every input report as a seqlock: the sequence is odd while the data is written
+// and even once it is complete. Readers copy the data and retry if the sequence was odd or changed meanwhile, see
+// ReadSharedPadState. Readers never block the writer. All values are native endian. This header does not depend on
+// the rest of the model, so readers can include it on its own.
+
+constexpr uint32_t SHARED_STATE_MAGIC = 0x53504441; // "ADPS"
+constexpr uint16_t SHARED_STATE_VERSION = 1;
+constexpr const char* SHARED_STATE_DEFAULT_NAME = "adp-pad-state";
+constexpr int SHARED_STATE_MAX_SENSORS = 12;
+
+enum SharedStateFlags
+{
+	SHARED_STATE_CONNECTED = 1 << 0, // a pad is connected and the data is current
+	SHARED_STATE_EXTENDED  = 1 << 1, // the pad sends sequence numbers and timestamps
+};
+
+struct SharedPadData
+{
+	uint32_t flags;
+	uint32_t sensorCount;
+	uint32_t buttons; // bit 0 is the first button
+	uint32_t deviceSequence; // sequence number of the input report, extended input only
+	uint32_t deviceTime; // timestamp of the input report in us, extended input only
+	uint32_t reserved;
+	uint64_t reportCount; // input reports received since the pad connected
+	int64_t hostTime; // arrival of the input report in us of the monotonic clock, like std::chrono::steady_clock
+	float sensors[SHARED_STATE_MAX_SENSORS]; // 0 to 1
+	float thresholds[SHARED_STATE_MAX_SENSORS]; // 0 to 1
+};
+
+struct SharedPadState
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size; // sizeof(SharedPadState)
+	std::atomic<uint32_t> sequence;
+	uint32_t reserved;
+	SharedPadData data;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "lock free 32-bit atomics required");
+
+// Attempts of ReadSharedPadState. An update takes well under a microsecond, so running out of them means the writer
+// died in the middle of one or the region is not a SharedPadState.
+constexpr int SHARED_STATE_MAX_READ_ATTEMPTS = 1000;
+
+// Copies the data out of a mapped region, retries while the writer is in the middle of an update. Returns false if no
+// consistent copy was made within the given attempts, data is unchanged then.
+//
+// A consistent copy can still be stale: the writer clears SHARED_STATE_CONNECTED when the pad disconnects or it stops,
+// not when its process dies. Readers should compare hostTime with their own steady_clock and treat the data as
+// lost once it is older than they can accept, the writer updates it at the poll rate of the pad.
+inline bool ReadSharedPadState(const SharedPadState& state, SharedPadData& data,
+	int maxAttempts = SHARED_STATE_MAX_READ_ATTEMPTS)
+{
+	SharedPadData copy;
+	for (int attempt = 0; attempt < maxAttempts; ++attempt)
+	{
+		uint32_t before = state.sequence.load(std::memory_order_acquire);
+		if (before & 1)
+			continue;
+
+		memcpy(&copy, &state.data, sizeof(copy));
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (state.sequence.load(std::memory_order_relaxed) == before)
+		{
+			data = copy;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Owns the shared memory region and publishes to it, used by the device as input reports are read.
+class SharedStateWriter
+{
+public:
+	SharedStateWriter();
+	~SharedStateWriter();
+
+	bool Start(const std::string& name);
+
+	void Stop();
+
+	bool IsRunning() const { return myState != nullptr; }
+
+	void Publish(const SensorValuesReport& report, int64_t hostTime, uint64_t reportCount,
+		int sensorCount, const SensorState* sensors);
+
+	// Clears the connected flag, does nothing if it is not set.
+	void Disconnect();
+
+private:
+	void BeginWrite();
+	void EndWrite();
+
+	SharedPadState* myState = nullptr;
+	std::string myName;
+#ifdef _WIN32
+	void* myMapping = nullptr;
+#else
+	bool myIsCreator = false; // the region is unlinked on stop only by the writer that created it
+#endif
+};
+
+}; // namespace adp.
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace adp {
+
+struct VersionType {
+	uint16_t major;
+	uint16_t minor;
+
+	bool IsNewer(VersionType then)
+	{
+		if (major > then.major) {
+			return true;
+		}
+
+		if (major == then.major && minor > then.minor) {
+			return true;
+		}
+
+		return false;
+	}
+};
+
+static const VersionType versionTypeUnknown = { 0, 0 };
+
+}; // namespace adp.
@@ -23,7 +23,7 @@
 #include <wx/filefn.h>
 #include "wx/timer.h"
 
-#include "Model/Updater.h"
+#include "Update/Updater.h"
 #include "Model/Firmware.h"
 #include "Model/Log.h"
 #include "Model/Device.h"
@@ -6,6 +6,7 @@
 using json = nlohmann::json;
 
 #include "Model/Firmware.h"
+#include "Model/Version.h"
 
 using namespace std;
 
@@ -13,32 +14,12 @@ namespace adp {
 
 #define ADP_USER_AGENT "adp-tool"
 
-struct VersionType {
-	uint16_t major;
-	uint16_t minor;
-
-	bool IsNewer(VersionType then)
-	{
-		if (major > then.major) {
-			return true;
-		}
-
-		if (major == then.major && minor > then.minor) {
-			return true;
-		}
-
-		return false;
-	}
-};
-
 enum SoftwareType {
 	SW_TYPE_ADP_TOOL,
 	SW_TYPE_ADP_FIRMWARE,
 	SW_TYPE_ADP_OTHER
 };
 
-static const VersionType versionTypeUnknown = { 0, 0 };
-
 class SoftwareUpdate
 {
 public:
@@ -19,6 +19,8 @@ using namespace std;
 
 namespace adp {
 
+wxDEFINE_EVENT(EVT_AVRDUDE, wxCommandEvent);
+
 static constexpr const wchar_t* RenameMsg =
     L"Rename the pad device. Convenient if you have\nmultiple devices and want to tell them apart.";
 
@@ -141,7 +143,14 @@ FirmwareDialog::FirmwareDialog(const wxString& title)
 
     SetSizerAndFit(topSizer);
 
-    uploader.SetEventHandler(this);
+    // Avrdude reports from its own thread, pass the messages on to the ui thread.
+    uploader.SetEventCallback([this](const AvrdudeMessage& message) {
+        auto evt = new wxCommandEvent(EVT_AVRDUDE);
+        evt->SetExtraLong(message.type);
+        evt->SetInt(message.value);
+        evt->SetString(message.text);
+        wxQueueEvent(this, evt);
+    });
 }
 
 void FirmwareDialog::UpdateFirmware(wstring file)
@@ -11,6 +11,8 @@ using namespace std;
 
 namespace adp {
 
+wxDECLARE_EVENT(EVT_AVRDUDE, wxCommandEvent);
+
 class FirmwareDialog : public wxDialog
 {
 public:
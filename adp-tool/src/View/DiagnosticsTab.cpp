@@ -0,0 +1,118 @@
+#include "Adp.h"
+
+#include "wx/sizer.h"
+#include "wx/button.h"
+
+#include "Model/Device.h"
+
+#include "View/DiagnosticsTab.h"
+
+namespace adp {
+
+static constexpr const wchar_t* DiagnosticsMsg =
+    L"Timing of the input reports since connecting. Long intervals or large\n"
+    L"batches on the host with regular device intervals point to a hub,\n"
+    L"driver or this tool rather than the pad itself.";
+
+static const wchar_t* RowNames[] = { L"Report interval", L"Device interval", L"Latency", L"Batch size" };
+static const wchar_t* ColumnNames[] = { L"Count", L"p50", L"p99", L"p99.9", L"Max" };
+
+// The statistics change quickly, refreshing them every tick makes them unreadable.
+static constexpr int TICKS_PER_UPDATE = 25;
+
+const wchar_t* DiagnosticsTab::Title = L"Diagnostics";
+
+enum Ids { RESET_BUTTON = 1 };
+
+DiagnosticsTab::DiagnosticsTab(wxWindow* owner)
+    : wxWindow(owner, wxID_ANY)
+{
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+
+    auto lDiagnostics = new wxStaticText(this, wxID_ANY, DiagnosticsMsg);
+    sizer->Add(lDiagnostics, 0, wxALL, 10);
+
+    auto grid = new wxFlexGridSizer(NUM_COLUMNS + 1, 5, 15);
+    grid->AddSpacer(0);
+    for (auto name : ColumnNames)
+        grid->Add(new wxStaticText(this, wxID_ANY, name), 0, wxALIGN_RIGHT);
+
+    for (int row = 0; row < NUM_ROWS; ++row)
+    {
+        grid->Add(new wxStaticText(this, wxID_ANY, RowNames[row]));
+        for (int column = 0; column < NUM_COLUMNS; ++column)
+        {
+            myCells[row][column] = new wxStaticText(this, wxID_ANY, L"-",
+                wxDefaultPosition, wxSize(60, -1), wxALIGN_RIGHT | wxST_NO_AUTORESIZE);
+            grid->Add(myCells[row][column], 0, wxALIGN_RIGHT);
+        }
+    }
+    sizer->Add(grid, 0, wxLEFT | wxRIGHT, 10);
+
+    myReportText = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    sizer->Add(myReportText, 0, wxALL, 10);
+
+    auto bReset = new wxButton(this, RESET_BUTTON, L"Reset", wxDefaultPosition, wxSize(100, -1));
+    sizer->Add(bReset, 0, wxLEFT, 10);
+
+    SetSizer(sizer);
+}
+
+void DiagnosticsTab::OnReset(wxCommandEvent& event)
+{
+    Device::ResetPollingStats();
+    myTicksUntilUpdate = 0;
+}
+
+void DiagnosticsTab::UpdateRow(int row, const HistogramSummary& summary, bool isTime)
+{
+    myCells[row][COLUMN_COUNT]->SetLabel(wxString::Format("%llu", (unsigned long long)summary.count));
+
+    uint32_t values[] = { summary.p50, summary.p99, summary.p999, summary.max };
+    for (int i = 0; i < 4; ++i)
+    {
+        wxString text;
+        if (summary.count == 0)
+            text = L"-";
+        else if (isTime)
+            text = wxString::Format("%.2fms", values[i] / 1000.0);
+        else
+            text = wxString::Format("%u", values[i]);
+        myCells[row][COLUMN_P50 + i]->SetLabel(text);
+    }
+}
+
+void DiagnosticsTab::Tick()
+{
+    if (--myTicksUntilUpdate > 0)
+        return;
+
+    myTicksUntilUpdate = TICKS_PER_UPDATE;
+
+    auto stats = Device::PollingStats();
+    UpdateRow(ROW_INTERVALS, stats.intervals, true);
+    UpdateRow(ROW_DEVICE_INTERVALS, stats.deviceIntervals, true);
+    UpdateRow(ROW_LATENCY, stats.latency, true);
+    UpdateRow(ROW_BATCH_SIZES, stats.batchSizes, false);
+
+    auto reports = Device::Reports();
+    if (reports && reports->extended)
+    {
+        myReportText->SetLabel(wxString::Format(
+            "%llu reports received, %llu dropped in %llu gaps (largest %i)",
+            (unsigned long long)reports->received,
+            (unsigned long long)reports->dropped,
+            (unsigned long long)reports->gaps,
+            reports->largestGap));
+    }
+    else
+    {
+        myReportText->SetLabel(L"Device timing requires firmware with the extended input report.");
+    }
+}
+
+BEGIN_EVENT_TABLE(DiagnosticsTab, wxWindow)
+    EVT_BUTTON(RESET_BUTTON, DiagnosticsTab::OnReset)
+END_EVENT_TABLE()
+
+}; // namespace adp.
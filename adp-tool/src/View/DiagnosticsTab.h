@@ -0,0 +1,36 @@
+#pragma once
+
+#include "wx/window.h"
+#include "wx/stattext.h"
+
+#include "View/BaseTab.h"
+
+namespace adp {
+
+class DiagnosticsTab : public BaseTab, public wxWindow
+{
+public:
+    static const wchar_t* Title;
+
+    DiagnosticsTab(wxWindow* owner);
+
+    void OnReset(wxCommandEvent& event);
+
+    void Tick() override;
+
+    wxWindow* GetWindow() override { return this; }
+
+    DECLARE_EVENT_TABLE()
+
+private:
+    enum Rows { ROW_INTERVALS, ROW_DEVICE_INTERVALS, ROW_LATENCY, ROW_BATCH_SIZES, NUM_ROWS };
+    enum Columns { COLUMN_COUNT, COLUMN_P50, COLUMN_P99, COLUMN_P999, COLUMN_MAX, NUM_COLUMNS };
+
+    void UpdateRow(int row, const HistogramSummary& summary, bool isTime);
+
+    wxStaticText* myCells[NUM_ROWS][NUM_COLUMNS];
+    wxStaticText* myReportText;
+    int myTicksUntilUpdate = 0;
+};
+
+}; // namespace adp.
@@ -1,5 +1,8 @@
 #include "Adp.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "wx/dataview.h"
 #include "wx/dcbuffer.h"
 #include "wx/sizer.h"
@@ -14,6 +17,40 @@ namespace adp {
 
 enum Ids { DIALOG_SAVE_BUTTON = 1, SENSOR_CONFIG_BUTTON = 2 };
 
+static const wchar_t* AxisNames[JOYSTICK_AXIS_COUNT] =
+{
+    L"X axis", L"Y axis", L"Z axis", L"Rx axis", L"Ry axis", L"Rz axis", L"Slider", L"Dial"
+};
+
+// In the order of JoystickCurve.
+static const wchar_t* CurveNames[] = { L"Linear", L"Soft", L"Hard", L"S-curve" };
+
+// First entries of the button mode boxes. BUTTON_MODE_K_OF_N follows with one entry per sensor count, from 2 up to
+// the number of sensors mapped to the button.
+struct ButtonModeOption { const wchar_t* name; ButtonMode mode; };
+static const ButtonModeOption ButtonModeOptions[] =
+{
+    { L"Any sensor", BUTTON_MODE_ANY },
+    { L"Sum", BUTTON_MODE_SUM },
+    { L"Weighted sum", BUTTON_MODE_WEIGHTED_SUM },
+};
+static constexpr int MIN_K_OF_N_COUNT = 2;
+
+static int MappedSensorCount(int buttonIndex)
+{
+    int count = 0;
+    for (int i = 0; i < Device::Pad()->numSensors; ++i)
+    {
+        auto sensor = Device::Sensor(i);
+        if (sensor && sensor->button == buttonIndex + 1)
+            ++count;
+    }
+    return count;
+}
+
+// Weights are sent with 6 fraction bits in a byte, see ButtonReport.
+static constexpr double MAX_SENSOR_WEIGHT = 255.0 / ButtonReport::WEIGHT_ONE;
+
 class HorizontalSensorBar : public wxWindow
 {
 public:
@@ -63,8 +100,20 @@ MappingTab::MappingTab(wxWindow* owner, const PadState* pad)
         options.Add(wxString::Format("Button %i", i));
 
     bool configButton = Device::Pad()->featureDigipot;
+    bool joystickAxes = pad->featureJoystickAxes;
+    bool buttonModes = pad->featureButtonModes;
+
+    wxArrayString axisOptions;
+    axisOptions.Add(L"No axis");
+    for (auto name : AxisNames)
+        axisOptions.Add(name);
 
-    auto sizer = new wxGridSizer(pad->numSensors, configButton ? 4 : 3, 4, 4);
+    wxArrayString curveOptions;
+    for (auto name : CurveNames)
+        curveOptions.Add(name);
+
+    int columns = 3 + (configButton ? 1 : 0) + (joystickAxes ? 2 : 0) + (buttonModes ? 1 : 0);
+    auto sizer = new wxGridSizer(pad->numSensors, columns, 4, 4);
     for (int i = 0; i < pad->numSensors; ++i)
     {
         auto text = new wxStaticText(this, wxID_ANY, wxString::Format("Sensor %i", i + 1),
@@ -81,16 +130,62 @@ MappingTab::MappingTab(wxWindow* owner, const PadState* pad)
         sizer->Add(bar, 1, wxEXPAND);
         mySensorBars.push_back(bar);
 
+        if (joystickAxes) {
+            auto axisBox = new wxComboBox(this, i, axisOptions[0],
+                wxDefaultPosition, wxDefaultSize, axisOptions, wxCB_READONLY);
+            axisBox->Bind(wxEVT_COMBOBOX, &MappingTab::OnJoystickAxisChanged, this);
+            sizer->Add(axisBox, 1, wxEXPAND);
+            myAxisBoxes.push_back(axisBox);
+
+            auto curveBox = new wxComboBox(this, i, curveOptions[0],
+                wxDefaultPosition, wxDefaultSize, curveOptions, wxCB_READONLY);
+            curveBox->Bind(wxEVT_COMBOBOX, &MappingTab::OnJoystickAxisChanged, this);
+            sizer->Add(curveBox, 1, wxEXPAND);
+            myCurveBoxes.push_back(curveBox);
+        }
+
+        if (buttonModes) {
+            auto weightBox = new wxSpinCtrlDouble(this, i, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+                wxSP_ARROW_KEYS, 0.0, MAX_SENSOR_WEIGHT, 1.0, 0.25);
+            weightBox->SetToolTip(L"Weight of the sensor when its button uses the weighted sum");
+            weightBox->Bind(wxEVT_SPINCTRLDOUBLE, &MappingTab::OnWeightChanged, this);
+            sizer->Add(weightBox, 1, wxEXPAND);
+            myWeightBoxes.push_back(weightBox);
+        }
+
         if (configButton) {
             auto configButton = new wxButton(this, i, "Config");
             configButton->Bind(wxEVT_BUTTON, &MappingTab::OnSensorConfig, this);
             sizer->Add(configButton, 1, wxEXPAND);
         }
     }
+
+    wxGridSizer* buttonSizer = nullptr;
+    if (buttonModes) {
+        wxArrayString modeOptions;
+        for (auto& option : ButtonModeOptions)
+            modeOptions.Add(option.name);
+
+        buttonSizer = new wxGridSizer(pad->numButtons, 2, 4, 4);
+        for (int i = 0; i < pad->numButtons; ++i)
+        {
+            auto text = new wxStaticText(this, wxID_ANY, wxString::Format("Button %i presses on", i + 1),
+                wxDefaultPosition, wxDefaultSize);
+            buttonSizer->Add(text, 1, wxLEFT | wxTOP | wxRIGHT | wxEXPAND, 4);
+
+            auto modeBox = new wxComboBox(this, i, modeOptions[0],
+                wxDefaultPosition, wxDefaultSize, modeOptions, wxCB_READONLY);
+            modeBox->Bind(wxEVT_COMBOBOX, &MappingTab::OnButtonModeChanged, this);
+            buttonSizer->Add(modeBox, 1, wxEXPAND);
+            myModeBoxes.push_back(modeBox);
+        }
+    }
     UpdateButtonMapping();
 
     auto outerSizer = new wxBoxSizer(wxVERTICAL | wxALIGN_TOP);
     outerSizer->Add(sizer, 0, wxALL | wxEXPAND, 4);
+    if (buttonSizer)
+        outerSizer->Add(buttonSizer, 0, wxALL | wxEXPAND, 4);
     SetSizer(outerSizer);
 }
 
@@ -113,6 +208,31 @@ void MappingTab::OnButtonChanged(wxCommandEvent& event)
     Device::SetButtonMapping(sensorIndex, selectedButton);
 }
 
+void MappingTab::OnJoystickAxisChanged(wxCommandEvent& event)
+{
+    int sensorIndex = event.GetId();
+    auto axis = myAxisBoxes[sensorIndex]->GetSelection() - 1;
+    auto curve = (JoystickCurve)myCurveBoxes[sensorIndex]->GetSelection();
+    Device::SetJoystickAxis(sensorIndex, axis, curve);
+}
+
+void MappingTab::OnWeightChanged(wxSpinDoubleEvent& event)
+{
+    int sensorIndex = event.GetId();
+    Device::SetSensorWeight(sensorIndex, myWeightBoxes[sensorIndex]->GetValue());
+}
+
+void MappingTab::OnButtonModeChanged(wxCommandEvent& event)
+{
+    int buttonIndex = event.GetId();
+    int selection = myModeBoxes[buttonIndex]->GetSelection();
+    int numOptions = (int)std::size(ButtonModeOptions);
+    if (selection >= 0 && selection < numOptions)
+        Device::SetButtonMode(buttonIndex, ButtonModeOptions[selection].mode, MIN_K_OF_N_COUNT);
+    else if (selection >= numOptions)
+        Device::SetButtonMode(buttonIndex, BUTTON_MODE_K_OF_N, MIN_K_OF_N_COUNT + selection - numOptions);
+}
+
 void MappingTab::OnSensorConfig(wxCommandEvent& event)
 {
     SensorConfigDialog dialog(event.GetId());
@@ -126,6 +246,42 @@ void MappingTab::UpdateButtonMapping()
         auto sensor = Device::Sensor(i);
         auto button = sensor ? sensor->button : 0;
         myButtonBoxes[i]->SetSelection(button);
+
+        if (i < myAxisBoxes.size()) {
+            myAxisBoxes[i]->SetSelection(sensor ? sensor->JoystickAxis() + 1 : 0);
+            myCurveBoxes[i]->SetSelection(sensor ? sensor->GetJoystickCurve() : JOYSTICK_CURVE_LINEAR);
+        }
+
+        if (i < myWeightBoxes.size())
+            myWeightBoxes[i]->SetValue(sensor ? sensor->weight : 1.0);
+    }
+
+    for (uint32_t i = 0; i < myModeBoxes.size(); ++i)
+    {
+        auto button = Device::Button(i);
+        bool kOfN = button && button->mode == BUTTON_MODE_K_OF_N;
+
+        // Keep the entry of a count above the mapped sensors (e.g. from a profile) so the box shows what is set.
+        int maxCount = MappedSensorCount(i);
+        if (kOfN)
+            maxCount = std::max(maxCount, button->count);
+
+        wxArrayString modeOptions;
+        for (auto& option : ButtonModeOptions)
+            modeOptions.Add(option.name);
+        for (int count = MIN_K_OF_N_COUNT; count <= maxCount; ++count)
+            modeOptions.Add(wxString::Format("At least %i sensors", count));
+        myModeBoxes[i]->Set(modeOptions);
+
+        int selection = 0;
+        if (kOfN && button->count >= MIN_K_OF_N_COUNT)
+            selection = (int)std::size(ButtonModeOptions) + button->count - MIN_K_OF_N_COUNT;
+        for (int option = 0; button && !kOfN && option < (int)std::size(ButtonModeOptions); ++option)
+        {
+            if (ButtonModeOptions[option].mode == button->mode)
+                selection = option;
+        }
+        myModeBoxes[i]->SetSelection(selection);
     }
 }
 
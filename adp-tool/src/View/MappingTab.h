@@ -8,6 +8,7 @@
 #include "wx/combobox.h"
 #include "wx/dialog.h"
 #include "wx/slider.h"
+#include "wx/spinctrl.h"
 #include "wx/timer.h"
 
 #include "View/BaseTab.h"
@@ -30,9 +31,16 @@ public:
 
 private:
     std::vector<wxComboBox*> myButtonBoxes;
+    std::vector<wxComboBox*> myAxisBoxes;
+    std::vector<wxComboBox*> myCurveBoxes;
+    std::vector<wxSpinCtrlDouble*> myWeightBoxes;
+    std::vector<wxComboBox*> myModeBoxes;
     std::vector<HorizontalSensorBar*> mySensorBars;
 
     void OnButtonChanged(wxCommandEvent&);
+    void OnJoystickAxisChanged(wxCommandEvent&);
+    void OnWeightChanged(wxSpinDoubleEvent&);
+    void OnButtonModeChanged(wxCommandEvent&);
     void OnSensorConfig(wxCommandEvent&);
     void UpdateButtonMapping();
 };
@@ -0,0 +1,274 @@
+#include "Adp.h"
+
+#include <deque>
+#include <cmath>
+
+#include "wx/dcbuffer.h"
+#include "wx/sizer.h"
+
+#include "Assets/Assets.h"
+
+#include "View/ScopeTab.h"
+
+namespace adp {
+
+// Device time shown by the scope.
+static constexpr int64_t WINDOW_US = 50000;
+
+// The scale never zooms in further than this, so a quiet sensor does not fill the display with its noise.
+static constexpr int MIN_RANGE = 16;
+
+static constexpr int TICKS_PER_UPDATE = 25;
+
+static const unsigned char TraceColors[][3] =
+{
+    { 200, 40, 40 }, { 40, 120, 200 }, { 40, 160, 60 }, { 220, 140, 20 },
+    { 140, 60, 180 }, { 20, 160, 160 }, { 120, 90, 40 }, { 90, 90, 90 },
+};
+
+static constexpr int NUM_TRACE_COLORS = sizeof(TraceColors) / sizeof(TraceColors[0]);
+
+class ScopeDisplay : public wxWindow
+{
+public:
+    ScopeDisplay(wxWindow* owner)
+        : wxWindow(owner, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxBG_STYLE_PAINT | wxFULL_REPAINT_ON_RESIZE)
+    {
+        SetMinSize(wxSize(100, 100));
+    }
+
+    void Add(const vector<RawAdcSample>& samples)
+    {
+        mySamples.insert(mySamples.end(), samples.begin(), samples.end());
+        while (!mySamples.empty() && mySamples.front().time < mySamples.back().time - WINDOW_US)
+            mySamples.pop_front();
+    }
+
+    void Clear() { mySamples.clear(); }
+
+    const deque<RawAdcSample>& Samples() const { return mySamples; }
+
+    void OnPaint(wxPaintEvent& evt)
+    {
+        wxBufferedPaintDC dc(this);
+        auto size = GetClientSize();
+
+        dc.SetPen(Pens::Black1px());
+        dc.SetBrush(*wxWHITE_BRUSH);
+        dc.DrawRectangle(0, 0, size.x, size.y);
+
+        if (mySamples.empty())
+            return;
+
+        int low = mySamples.front().value, high = low;
+        for (auto& sample : mySamples)
+        {
+            low = min(low, sample.value);
+            high = max(high, sample.value);
+        }
+        int center = (low + high) / 2;
+        int range = max(high - low, MIN_RANGE) * 11 / 10;
+        low = center - range / 2;
+        high = low + range;
+
+        int64_t start = mySamples.back().time - WINDOW_US;
+        auto ToPoint = [&](const RawAdcSample& sample)
+        {
+            return wxPoint(
+                (int)((sample.time - start) * (size.x - 1) / WINDOW_US),
+                (size.y - 1) - (sample.value - low) * (size.y - 1) / range);
+        };
+
+        // One trace per sensor, the samples of a scan are interleaved.
+        vector<vector<wxPoint>> traces(MAX_SENSOR_COUNT);
+        for (auto& sample : mySamples)
+        {
+            if (sample.sensor >= 0 && sample.sensor < MAX_SENSOR_COUNT)
+                traces[sample.sensor].push_back(ToPoint(sample));
+        }
+
+        for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+        {
+            auto& trace = traces[i];
+            if (trace.size() < 2)
+                continue;
+
+            auto color = TraceColors[i % NUM_TRACE_COLORS];
+            dc.SetPen(wxPen(wxColour(color[0], color[1], color[2]), 1));
+            dc.DrawLines((int)trace.size(), trace.data());
+        }
+
+        dc.SetTextForeground(*wxBLACK);
+        dc.DrawText(wxString::Format("%i", high), 4, 2);
+        dc.DrawText(wxString::Format("%i", low), 4, size.y - dc.GetCharHeight() - 2);
+    }
+
+    DECLARE_EVENT_TABLE()
+
+private:
+    deque<RawAdcSample> mySamples;
+};
+
+BEGIN_EVENT_TABLE(ScopeDisplay, wxWindow)
+    EVT_PAINT(ScopeDisplay::OnPaint)
+END_EVENT_TABLE()
+
+static const wchar_t* ScopeMsg =
+    L"Unfiltered ADC conversions at the full rate of the pad, of all sensors in turn or of one sensor.\n"
+    L"While streaming, the pad sends no input reports and its buttons are released.";
+
+const wchar_t* ScopeTab::Title = L"Scope";
+
+enum Ids { START_STOP_BUTTON = 1 };
+
+ScopeTab::ScopeTab(wxWindow* owner, const PadState* pad)
+    : wxWindow(owner, wxID_ANY)
+{
+    auto sizer = new wxBoxSizer(wxVERTICAL);
+
+    auto lScope = new wxStaticText(this, wxID_ANY, ScopeMsg);
+    sizer->Add(lScope, 0, wxALL, 10);
+
+    wxArrayString options;
+    options.Add(L"All sensors");
+    for (int i = 1; i <= pad->numSensors; ++i)
+        options.Add(wxString::Format("Sensor %i", i));
+
+    auto controls = new wxBoxSizer(wxHORIZONTAL);
+
+    mySensorSelect = new wxComboBox(this, wxID_ANY, options[0],
+        wxDefaultPosition, wxSize(115, 25), options, wxCB_READONLY);
+    mySensorSelect->Bind(wxEVT_COMBOBOX, &ScopeTab::OnSensorChanged, this);
+    controls->Add(mySensorSelect, 0, wxRIGHT, 10);
+
+    myStartStopButton = new wxButton(this, START_STOP_BUTTON, L"Start", wxDefaultPosition, wxSize(100, -1));
+    controls->Add(myStartStopButton, 0, wxRIGHT, 10);
+
+    myStatsText = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    controls->Add(myStatsText, 0, wxALIGN_CENTER_VERTICAL);
+
+    sizer->Add(controls, 0, wxLEFT | wxRIGHT, 10);
+
+    myDisplay = new ScopeDisplay(this);
+    sizer->Add(myDisplay, 1, wxEXPAND | wxALL, 10);
+
+    SetSizer(sizer);
+}
+
+ScopeTab::~ScopeTab()
+{
+    // The pad would keep streaming without anyone looking.
+    Stop();
+}
+
+void ScopeTab::Start()
+{
+    myDisplay->Clear();
+    if (Device::StartRawAdc(mySensorSelect->GetSelection() - 1))
+        myStartStopButton->SetLabel(L"Stop");
+    else
+        myStatsText->SetLabel(L"The pad did not start streaming.");
+}
+
+void ScopeTab::Stop()
+{
+    if (!Device::IsStreamingRawAdc())
+        return;
+
+    Device::StopRawAdc();
+    myStartStopButton->SetLabel(L"Start");
+}
+
+void ScopeTab::OnStartStop(wxCommandEvent& event)
+{
+    if (Device::IsStreamingRawAdc())
+        Stop();
+    else
+        Start();
+}
+
+void ScopeTab::OnSensorChanged(wxCommandEvent& event)
+{
+    if (Device::IsStreamingRawAdc())
+        Start();
+}
+
+void ScopeTab::Tick()
+{
+    if (!Device::IsStreamingRawAdc())
+        return;
+
+    Device::ReadRawAdc(mySamples);
+    if (!mySamples.empty())
+    {
+        myDisplay->Add(mySamples);
+        myDisplay->Refresh();
+    }
+
+    if (--myTicksUntilUpdate > 0)
+        return;
+
+    myTicksUntilUpdate = TICKS_PER_UPDATE;
+    UpdateStats();
+}
+
+void ScopeTab::UpdateStats()
+{
+    auto& samples = myDisplay->Samples();
+    if (samples.size() < 2)
+    {
+        myStatsText->SetLabel(L"Waiting for samples...");
+        return;
+    }
+
+    // The noise of a sensor is the standard deviation of its samples in the window.
+    double sums[MAX_SENSOR_COUNT] = {};
+    double squares[MAX_SENSOR_COUNT] = {};
+    int counts[MAX_SENSOR_COUNT] = {};
+    for (auto& sample : samples)
+    {
+        if (sample.sensor < 0 || sample.sensor >= MAX_SENSOR_COUNT)
+            continue;
+        sums[sample.sensor] += sample.value;
+        squares[sample.sensor] += (double)sample.value * sample.value;
+        ++counts[sample.sensor];
+    }
+
+    int noisiest = -1, sensors = 0;
+    double noise = 0.0;
+    for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        ++sensors;
+        double mean = sums[i] / counts[i];
+        double deviation = sqrt(max(0.0, squares[i] / counts[i] - mean * mean));
+        if (noisiest < 0 || deviation > noise)
+        {
+            noisiest = i;
+            noise = deviation;
+        }
+    }
+
+    double seconds = max<int64_t>(1, samples.back().time - samples.front().time) / 1e6;
+    double rate = samples.size() / seconds / max(1, sensors);
+
+    if (sensors == 1)
+    {
+        myStatsText->SetLabel(wxString::Format(
+            "%.1f kHz, standard deviation %.2f", rate / 1000.0, noise));
+    }
+    else
+    {
+        myStatsText->SetLabel(wxString::Format(
+            "%.1f kHz per sensor, noisiest is sensor %i with standard deviation %.2f",
+            rate / 1000.0, noisiest + 1, noise));
+    }
+}
+
+BEGIN_EVENT_TABLE(ScopeTab, wxWindow)
+    EVT_BUTTON(START_STOP_BUTTON, ScopeTab::OnStartStop)
+END_EVENT_TABLE()
+
+}; // namespace adp.
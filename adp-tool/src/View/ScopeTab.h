@@ -0,0 +1,43 @@
+#pragma once
+
+#include "wx/window.h"
+#include "wx/stattext.h"
+#include "wx/button.h"
+#include "wx/combobox.h"
+
+#include "View/BaseTab.h"
+
+namespace adp {
+
+class ScopeDisplay;
+
+// Raw conversions of firmware with FEATURE_RAW_ADC, for diagnosing the sensor hardware.
+class ScopeTab : public BaseTab, public wxWindow
+{
+public:
+    static const wchar_t* Title;
+
+    ScopeTab(wxWindow* owner, const PadState* pad);
+    ~ScopeTab();
+
+    void OnStartStop(wxCommandEvent& event);
+    void OnSensorChanged(wxCommandEvent& event);
+
+    void Tick() override;
+
+    wxWindow* GetWindow() override { return this; }
+
+private:
+    void Start();
+    void Stop();
+    void UpdateStats();
+
+    ScopeDisplay* myDisplay;
+    wxComboBox* mySensorSelect;
+    wxButton* myStartStopButton;
+    wxStaticText* myStatsText;
+    std::vector<RawAdcSample> mySamples;
+    int myTicksUntilUpdate = 0;
+};
+
+}; // namespace adp.
@@ -4,6 +4,7 @@
 
 #include "wx/dcbuffer.h"
 #include "wx/stattext.h"
+#include "wx/checkbox.h"
 
 #include "Assets/Assets.h"
 
@@ -14,6 +15,7 @@ using namespace std;
 namespace adp {
 
 static constexpr int SENSOR_INDEX_NONE = -1;
+static constexpr int SENSOR_INDEX_SUM = -2;
 
 class SensorDisplay : public wxWindow
 {
@@ -37,7 +39,10 @@ public:
             myAdjustingSensorThreshold = clamp(1.0 - (value / range), 0.0, 1.0);
             if (!mouse.LeftIsDown())
             {
-                Device::SetThreshold(myAdjustingSensorIndex, myAdjustingSensorThreshold);
+                if (myAdjustingSensorIndex == SENSOR_INDEX_SUM)
+                    Device::SetButtonThreshold(myButton - 1, myAdjustingSensorThreshold * SumScale());
+                else
+                    Device::SetThreshold(myAdjustingSensorIndex, myAdjustingSensorThreshold);
                 myAdjustingSensorIndex = SENSOR_INDEX_NONE;
             }
         }
@@ -48,13 +53,20 @@ public:
         wxBufferedPaintDC dc(this);
         auto size = GetClientSize();
 
+        size_t numBars = NumBars();
         int x = 0;
-        for (size_t i = 0; i < mySensorIndices.size(); ++i)
+        for (size_t i = 0; i < numBars; ++i)
         {
-            int barW = (i < mySensorIndices.size() - 1)
-                ? size.x * (i + 1) / mySensorIndices.size() - x
+            int barW = (i < numBars - 1)
+                ? size.x * (i + 1) / numBars - x
                 : size.x - x;
 
+            if (i == mySensorIndices.size())
+            {
+                PaintSumBar(dc, x, barW, size.y);
+                break;
+            }
+
             auto sensor = Device::Sensor(mySensorIndices[i]);
             auto pressed = sensor ? sensor->pressed : false;
 
@@ -87,6 +99,17 @@ public:
             dc.SetBrush(*wxWHITE_BRUSH);
             dc.DrawRectangle(x, thresholdY - 1, barW, 3);
 
+            // Short marker at the edges of the bar for the threshold suggested by the sensor statistics.
+            auto suggestedThreshold = sensor ? sensor->statistics.suggestedThreshold : 0.0;
+            if (suggestedThreshold > 0.0)
+            {
+                int suggestedY = size.y - (suggestedThreshold * size.y);
+                int markerW = min(10, barW / 4);
+                dc.SetBrush(Brushes::SuggestedThreshold());
+                dc.DrawRectangle(x, suggestedY - 1, markerW, 3);
+                dc.DrawRectangle(x + barW - markerW, suggestedY - 1, markerW, 3);
+            }
+
             // Small text block at the top displaying sensitivity threshold.
             auto sensitivityText = wxString::Format("%i%%", (int)std::lround(threshold * 100.0));
             auto rect = wxRect(x + barW / 2 - 20, 5, 40, 20);
@@ -99,15 +122,69 @@ public:
         }
     }
 
+    // Bar for the button threshold of the sum modes. It is scaled to the sum of all sensors at their maximum, so
+    // the threshold line sits where it would for a single sensor if the others press equally hard.
+    void PaintSumBar(wxDC& dc, int x, int barW, int height)
+    {
+        auto button = Device::Button(myButton - 1);
+        auto scale = SumScale();
+
+        double sum = 0.0;
+        bool pressed = false;
+        for (auto index : mySensorIndices)
+        {
+            auto sensor = Device::Sensor(index);
+            if (!sensor)
+                continue;
+            sum += sensor->value * (button->mode == BUTTON_MODE_WEIGHTED_SUM ? sensor->weight : 1.0);
+            pressed |= sensor->pressed;
+        }
+
+        auto threshold = button->threshold / scale;
+        if (myAdjustingSensorIndex == SENSOR_INDEX_SUM)
+            threshold = myAdjustingSensorThreshold;
+
+        int barH = min(1.0, sum / scale) * height;
+        int thresholdY = height - (threshold * height);
+
+        dc.SetPen(Pens::Black1px());
+        dc.SetBrush(Brushes::SensorBar());
+        dc.DrawRectangle(x, 0, barW, height - barH);
+
+        auto releaseThreshold = myOwner->ReleaseThreshold();
+        if (releaseThreshold < 1.0)
+        {
+            dc.SetBrush(Brushes::ReleaseMargin());
+            int releaseY = height - (releaseThreshold * threshold * height);
+            dc.DrawRectangle(x, thresholdY, barW, max(1, releaseY - thresholdY));
+        }
+
+        dc.SetBrush(pressed ? Brushes::SensorOn() : Brushes::SensorOff());
+        dc.DrawRectangle(x, height - barH, barW, barH);
+
+        dc.SetBrush(*wxWHITE_BRUSH);
+        dc.DrawRectangle(x, thresholdY - 1, barW, 3);
+
+        // The text shows the threshold of the sum, which goes above 100% of a single sensor.
+        auto sumText = wxString::Format("Sum %i%%", (int)std::lround(threshold * scale * 100.0));
+        auto rect = wxRect(x + barW / 2 - 35, 5, 70, 20);
+        dc.SetBrush(Brushes::DarkGray());
+        dc.DrawRectangle(rect);
+        dc.SetTextForeground(*wxWHITE);
+        dc.DrawLabel(sumText, rect, wxALIGN_CENTER);
+    }
+
     void OnClick(wxMouseEvent& event)
     {
         auto pos = event.GetPosition();
         auto rect = GetClientRect();
         if (rect.Contains(pos))
         {
-            int barIndex = (pos.x - rect.x) * mySensorIndices.size() / max(1, rect.width);
+            int barIndex = (pos.x - rect.x) * (int)NumBars() / max(1, rect.width);
             if (barIndex >= 0 && barIndex < (int)mySensorIndices.size())
                 myAdjustingSensorIndex = mySensorIndices[barIndex];
+            else if (barIndex == (int)mySensorIndices.size())
+                myAdjustingSensorIndex = SENSOR_INDEX_SUM;
         }
     }
 
@@ -124,6 +201,27 @@ public:
 protected:
     wxSize DoGetBestSize() const override { return wxSize(20, 100); }
 
+    // Sensor bars, plus the sum bar for buttons in one of the sum modes.
+    size_t NumBars() const
+    {
+        auto button = Device::Button(myButton - 1);
+        bool sum = button && (button->mode == BUTTON_MODE_SUM || button->mode == BUTTON_MODE_WEIGHTED_SUM);
+        return mySensorIndices.size() + (sum ? 1 : 0);
+    }
+
+    // Sum of all sensors of the button at their maximum.
+    double SumScale() const
+    {
+        auto button = Device::Button(myButton - 1);
+        double scale = 0.0;
+        for (auto index : mySensorIndices)
+        {
+            auto sensor = Device::Sensor(index);
+            scale += (sensor && button && button->mode == BUTTON_MODE_WEIGHTED_SUM) ? sensor->weight : 1.0;
+        }
+        return max(scale, 1.0);
+    }
+
 private:
     SensitivityTab* myOwner;
     int myButton = 0;
@@ -138,11 +236,17 @@ BEGIN_EVENT_TABLE(SensorDisplay, wxWindow)
 END_EVENT_TABLE()
 
 static const wchar_t* ActivationMsg =
-    L"Click inside a sensor bar to adjust its activation threshold.";
+    L"Click inside a sensor bar to adjust its activation threshold, or inside a sum bar for the threshold of the button.";
+
+static const wchar_t* SuggestionMsg =
+    L"Blue markers show suggested thresholds, based on the noise of each sensor and the presses seen so far.";
 
 static const wchar_t* ReleaseMsg =
     L"Adjust release threshold (percentage of activation threshold).";
 
+static const wchar_t* BaselineMsg =
+    L"Compensate baseline drift (thresholds follow slow changes of the idle sensor values)";
+
 const wchar_t* SensitivityTab::Title = L"Sensitivity";
 
 SensitivityTab::SensitivityTab(wxWindow* owner, const PadState* pad)
@@ -166,6 +270,20 @@ SensitivityTab::SensitivityTab(wxWindow* owner, const PadState* pad)
     myReleaseThresholdSlider->Bind(wxEVT_SLIDER, &SensitivityTab::OnReleaseThresholdChanged, this);
     sizer->Add(myReleaseThresholdSlider, 0, wxALIGN_CENTER_HORIZONTAL);
 
+    myBaselineTrackingBox = new wxCheckBox(this, wxID_ANY, BaselineMsg);
+    myBaselineTrackingBox->Bind(wxEVT_CHECKBOX, &SensitivityTab::OnBaselineTrackingChanged, this);
+    myBaselineTrackingBox->Show(pad && pad->featureBaseline);
+    sizer->Add(myBaselineTrackingBox, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 4);
+
+    auto suggestionLabel = new wxStaticText(this, wxID_ANY, SuggestionMsg);
+    sizer->Add(suggestionLabel, 0, wxTOP | wxALIGN_CENTER_HORIZONTAL, 4);
+
+    myApplySuggestedThresholdsButton = new wxButton(this, wxID_ANY, L"Use suggested thresholds",
+        wxDefaultPosition, wxSize(200, -1));
+    myApplySuggestedThresholdsButton->Bind(wxEVT_BUTTON, &SensitivityTab::OnApplySuggestedThresholds, this);
+    myApplySuggestedThresholdsButton->Disable();
+    sizer->Add(myApplySuggestedThresholdsButton, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP | wxBOTTOM, 5);
+
     SetSizer(sizer);
 
     myIsAdjustingReleaseThreshold = false;
@@ -208,6 +326,20 @@ void SensitivityTab::Tick()
         display->Tick();
         display->Refresh(false);
     }
+
+    bool hasSuggestions = false;
+    auto pad = Device::Pad();
+    for (int i = 0; pad && i < pad->numSensors; ++i)
+    {
+        auto sensor = Device::Sensor(i);
+        hasSuggestions |= (sensor->button != 0 && sensor->statistics.suggestedThreshold > 0.0);
+    }
+    myApplySuggestedThresholdsButton->Enable(hasSuggestions);
+
+    // The firmware tracks baselines per sensor, the checkbox shows whether the first sensor is tracked.
+    bool isTracking = pad && pad->numSensors > 0 && (Device::Sensor(0)->flags & SensorReport::BASELINE_TRACKING);
+    if (myBaselineTrackingBox->GetValue() != isTracking)
+        myBaselineTrackingBox->SetValue(isTracking);
 }
 
 double SensitivityTab::ReleaseThreshold() const
@@ -220,6 +352,24 @@ void SensitivityTab::OnReleaseThresholdChanged(wxCommandEvent& event)
     myIsAdjustingReleaseThreshold = true;
 }
 
+void SensitivityTab::OnBaselineTrackingChanged(wxCommandEvent& event)
+{
+    Device::SetBaselineTracking(myBaselineTrackingBox->GetValue());
+}
+
+void SensitivityTab::OnApplySuggestedThresholds(wxCommandEvent& event)
+{
+    // Sensors without enough statistics keep their threshold.
+    DeviceTransaction transaction;
+    auto pad = Device::Pad();
+    for (int i = 0; pad && i < pad->numSensors; ++i)
+    {
+        auto sensor = Device::Sensor(i);
+        if (sensor->button != 0 && sensor->statistics.suggestedThreshold > 0.0)
+            Device::SetThreshold(i, sensor->statistics.suggestedThreshold);
+    }
+}
+
 void SensitivityTab::UpdateDisplays()
 {
     map<int, vector<int>> mapping; // button -> sensors[]
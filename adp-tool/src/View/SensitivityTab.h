@@ -3,6 +3,8 @@
 #include "wx/window.h"
 #include "wx/sizer.h"
 #include "wx/slider.h"
+#include "wx/button.h"
+#include "wx/checkbox.h"
 
 #include "View/BaseTab.h"
 
@@ -27,6 +29,8 @@ public:
     double ReleaseThreshold() const;
 
     void OnReleaseThresholdChanged(wxCommandEvent& event);
+    void OnBaselineTrackingChanged(wxCommandEvent& event);
+    void OnApplySuggestedThresholds(wxCommandEvent& event);
 
     wxWindow* GetWindow() override { return this; }
 
@@ -35,6 +39,8 @@ private:
 
     vector<SensorDisplay*> mySensorDisplays;
     wxSlider* myReleaseThresholdSlider;
+    wxCheckBox* myBaselineTrackingBox;
+    wxButton* myApplySuggestedThresholdsButton;
     wxBoxSizer* mySensorSizer;
     double myReleaseThreshold = 1.0;
     bool myIsAdjustingReleaseThreshold = false;
@@ -10,7 +10,7 @@
 #include "wx/app.h"
 
 #include "Main.h"
-#include "Model/Updater.h"
+#include "Update/Updater.h"
 #include "Model/Device.h"
 #include "View/UpdaterView.h"
 
@@ -2,7 +2,7 @@
 
 #include "wx/dialog.h"
 
-#include "Model/Updater.h"
+#include "Update/Updater.h"
 
 using namespace std;
 
@@ -0,0 +1,272 @@
+#include "Adp.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "Model/Device.h"
+#include "Model/Emulator.h"
+#include "Model/Histogram.h"
+#include "Model/Log.h"
+#include "Model/Recorder.h"
+
+using namespace std;
+using namespace chrono;
+using namespace adp;
+
+// Benchmarks of the model layer on virtual devices, no pad required. Every result is printed as one JSON object per
+// line on stdout, so runs of different releases can be collected and compared by scripts.
+//
+//   adp-bench [--quick] [--recording <path>]
+//
+// pipeline     input reports per second through Reporter::Get and PadDevice::UpdateSensorValues, replaying a
+//              synthetic recording as fast as possible
+// connect      time for ConnectToDeviceStage2 to identify an emulated pad and read its configuration
+// profile_*    SaveProfile and LoadProfile against an emulated pad, JSON serialisation and the profile file round trip
+
+struct BenchOptions
+{
+	bool quick = false;
+	string recordingPath = "adp-bench.adpr";
+};
+
+static uint32_t ToMicroseconds(steady_clock::duration d)
+{
+	return (uint32_t)min<int64_t>(duration_cast<microseconds>(d).count(), UINT32_MAX);
+}
+
+static double ToSeconds(steady_clock::duration d)
+{
+	return duration<double>(d).count();
+}
+
+static void PrintResult(const json& result)
+{
+	cout << result.dump() << endl;
+}
+
+// Runs the function the given number of times and prints the distribution of its duration in microseconds.
+static void Measure(const char* name, int iterations, const function<void()>& run, json extra = json::object())
+{
+	Histogram histogram;
+	steady_clock::duration total = {};
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		auto start = steady_clock::now();
+		run();
+		auto elapsed = steady_clock::now() - start;
+
+		total += elapsed;
+		histogram.Record(ToMicroseconds(elapsed));
+	}
+
+	auto summary = histogram.Summary();
+	json result = {
+		{"benchmark", name},
+		{"iterations", iterations},
+		{"mean_us", iterations > 0 ? ToSeconds(total) * 1e6 / iterations : 0.0},
+		{"p50_us", summary.p50},
+		{"p99_us", summary.p99},
+		{"max_us", summary.max},
+	};
+	result.update(extra);
+	PrintResult(result);
+}
+
+// Writes a recording of an extended input stream where the panels are stepped on in turn, so the replay exercises
+// button changes, sequence tracking and sensor deltas like a real session.
+static bool WriteRecording(const string& path, int numSamples, int sensorCount)
+{
+	Recorder recorder;
+	if (!recorder.Start(path, sensorCount, RECORDING_FLAG_EXTENDED_INPUT))
+		return false;
+
+	auto start = steady_clock::now();
+	SensorValuesReport report;
+	report.reportId = REPORT_SENSOR_VALUES_EXTENDED;
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		int pressed = (i / 125) % sensorCount;
+		bool down = (i % 125) < 60;
+
+		for (int s = 0; s < MAX_SENSOR_COUNT; ++s)
+			report.sensorValues[s] = WriteU16LE(s < sensorCount ? 80 + (i * 7 + s * 13) % 9 + (down && s == pressed ? 600 : 0) : 0);
+
+		report.buttonBits = WriteU16LE(down ? 1 << pressed : 0);
+		report.sequence = WriteU16LE(i);
+		report.timestamp = WriteU32LE(i * 1000);
+		recorder.Push(report, start + microseconds(i * 1000));
+
+		// Push never blocks, give the writer thread time to drain the ring before it fills up.
+		if (i % 16384 == 16383)
+			this_thread::sleep_for(50ms);
+	}
+
+	recorder.Stop();
+	return recorder.NumDropped() == 0;
+}
+
+static void BenchPipeline(const BenchOptions& options)
+{
+	const int numSamples = options.quick ? 50000 : 500000;
+	const int sensorCount = 12;
+
+	if (!WriteRecording(options.recordingPath, numSamples, sensorCount) || !Device::OpenReplay(options.recordingPath.c_str(), false))
+	{
+		PrintResult({{"benchmark", "pipeline"}, {"error", "could not write or open the recording"}});
+		return;
+	}
+
+	Device::ResetPollingStats();
+
+	Histogram updates;
+	int numUpdates = 0;
+	int idleUpdates = 0;
+	auto start = steady_clock::now();
+
+	// Every update reads at most 100 reports, like a tick of the ui. Stop early if the replay runs dry.
+	while (Device::Reports() && Device::Reports()->received < (uint64_t)numSamples && idleUpdates < 1000)
+	{
+		auto received = Device::Reports()->received;
+		auto updateStart = steady_clock::now();
+		Device::Update();
+		updates.Record(ToMicroseconds(steady_clock::now() - updateStart));
+		++numUpdates;
+
+		bool progress = Device::Reports() && Device::Reports()->received > received;
+		idleUpdates = progress ? 0 : idleUpdates + 1;
+	}
+
+	auto elapsed = ToSeconds(steady_clock::now() - start);
+	auto received = Device::Reports() ? Device::Reports()->received : 0;
+	auto summary = updates.Summary();
+
+	PrintResult({
+		{"benchmark", "pipeline"},
+		{"reports", received},
+		{"seconds", elapsed},
+		{"reports_per_second", elapsed > 0 ? received / elapsed : 0.0},
+		{"updates", numUpdates},
+		{"update_p50_us", summary.p50},
+		{"update_p99_us", summary.p99},
+		{"update_max_us", summary.max},
+	});
+
+	Device::CloseVirtualDevice();
+	remove(options.recordingPath.c_str());
+}
+
+static void BenchConnect(const BenchOptions& options)
+{
+	EmulatorSettings settings;
+	settings.pattern = EmulatorPattern::IDLE;
+
+	Measure("connect", options.quick ? 20 : 200, [&]()
+	{
+		Device::StartEmulator(settings);
+		Device::CloseVirtualDevice();
+	});
+}
+
+static void BenchProfile(const BenchOptions& options)
+{
+	EmulatorSettings settings;
+	settings.pattern = EmulatorPattern::IDLE;
+	if (!Device::StartEmulator(settings))
+	{
+		PrintResult({{"benchmark", "profile"}, {"error", "could not start the emulator"}});
+		return;
+	}
+
+	const int iterations = options.quick ? 200 : 2000;
+	const string profilePath = options.recordingPath + ".json";
+
+	json profile;
+	Device::SaveProfile(profile, DGP_ALL);
+	string text = profile.dump(4);
+
+	Measure("profile_save", iterations, [&]()
+	{
+		json j;
+		Device::SaveProfile(j, DGP_ALL);
+	});
+
+	Measure("profile_serialize", iterations, [&]()
+	{
+		text = profile.dump(4);
+	}, {{"bytes", text.size()}});
+
+	Measure("profile_parse", iterations, [&]()
+	{
+		profile = json::parse(text);
+	});
+
+	Measure("profile_load", iterations, [&]()
+	{
+		Device::LoadProfile(profile, DGP_ALL);
+	});
+
+	// The full round trip as done from the File menu, including the file system.
+	Measure("profile_file_save", iterations, [&]()
+	{
+		json j;
+		Device::SaveProfile(j, DGP_ALL);
+		ofstream file(profilePath);
+		file << j.dump(4);
+	});
+
+	Measure("profile_file_load", iterations, [&]()
+	{
+		ifstream file(profilePath);
+		json j;
+		file >> j;
+		Device::LoadProfile(j, DGP_ALL);
+	});
+
+	Device::CloseVirtualDevice();
+	remove(profilePath.c_str());
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+			options.quick = true;
+		else if (strcmp(argv[i], "--recording") == 0 && i + 1 < argc)
+			options.recordingPath = argv[++i];
+		else
+		{
+			cerr << "usage: adp-bench [--quick] [--recording <path>]" << endl;
+			return 1;
+		}
+	}
+
+	Log::Init();
+	Device::Init();
+	Device::SetSearching(false);
+
+	PrintResult({
+		{"benchmark", "info"},
+		{"version", to_string(ADP_VERSION_MAJOR) + "." + to_string(ADP_VERSION_MINOR)},
+		{"quick", options.quick},
+	});
+
+	BenchPipeline(options);
+	BenchConnect(options);
+	BenchProfile(options);
+
+	Device::Shutdown();
+	Log::Shutdown();
+	return 0;
+}
@@ -0,0 +1,575 @@
+#include "Adp.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Model/Daemon.h"
+#include "Model/Device.h"
+#include "Model/Emulator.h"
+#include "Model/Firmware.h"
+#include "Model/Log.h"
+#include "Model/Metrics.h"
+#include "Model/Server.h"
+#include "Model/Utils.h"
+
+using namespace std;
+using namespace chrono;
+using namespace adp;
+
+// Command line access to a pad for headless setups, built on the model only. Results are written to stdout, as JSON
+// where they are structured, so scripts can use them. Diagnostics go to stderr.
+
+static const char* USAGE =
+	"usage: adp-cli [options] <command> [arguments]\n"
+	"\n"
+	"commands:\n"
+	"  info                  print the pad identification and configuration as JSON\n"
+	"  stats [seconds]       read input for a while (default 5) and print polling and sensor statistics as JSON\n"
+	"  stream [seconds]      print sensor values as CSV until stopped or for the given time\n"
+	"  metrics [seconds]     read input for a while (default 2) and print the metrics in the Prometheus format\n"
+	"  profile-save <file>   save the pad configuration to a profile\n"
+	"  profile-load <file>   apply a profile to the pad and store it on the pad\n"
+	"  flash <file.hex>      flash firmware, the configuration is restored afterwards\n"
+	"  share [name]          publish the pad state in shared memory until stopped (default adp-pad-state)\n"
+	"  daemon [socket]       own the pad and serve it to other adp processes until stopped\n"
+	"  serve [port] [addr]   serve the pad to web clients over WebSocket until stopped (default 3333 on 127.0.0.1)\n"
+	"\n"
+	"options:\n"
+	"  --emulator            use an emulated pad instead of a connected one\n"
+	"  --direct              open the pad directly even if an adp daemon is running\n"
+	"  --force               flash even if the firmware is for another board\n"
+	"  --metrics <file>      write the metrics to a file every 10 seconds while running\n"
+	"  --origin <origin>     let web pages of this origin use serve, besides local pages (repeatable)\n"
+	"  --timeout <seconds>   time to wait for a pad to connect (default 5)\n"
+	"  --verbose             print the log to stderr\n";
+
+struct CliOptions
+{
+	bool emulator = false;
+	bool direct = false;
+	bool force = false;
+	bool verbose = false;
+	double timeout = 5.0;
+	string metricsPath;
+	vector<string> origins;
+	string command;
+	vector<string> arguments;
+};
+
+static int numLogMessagesPrinted = 0;
+
+static void PrintLog(const CliOptions& options)
+{
+	if (options.verbose)
+	{
+		for (; numLogMessagesPrinted < Log::NumMessages(); ++numLogMessagesPrinted)
+			fwprintf(stderr, L"%ls\n", Log::Message(numLogMessagesPrinted).c_str());
+	}
+}
+
+static steady_clock::time_point nextMetricsExport;
+
+// Writes the metrics file of --metrics when it is due.
+static void ExportMetrics(const CliOptions& options)
+{
+	auto now = steady_clock::now();
+	if (options.metricsPath.empty() || now < nextMetricsExport)
+		return;
+
+	nextMetricsExport = now + 10s;
+	if (!Metrics::WriteFile(options.metricsPath.c_str()))
+		Log::Writef(L"Metrics :: could not write %hs", options.metricsPath.c_str());
+}
+
+static void Tick(const CliOptions& options)
+{
+	Device::Update();
+	ExportMetrics(options);
+	PrintLog(options);
+}
+
+// Keeps the device updated for the given time, like the ui timer does.
+static void RunFor(const CliOptions& options, double seconds)
+{
+	auto end = steady_clock::now() + duration<double>(seconds);
+	while (steady_clock::now() < end && Device::Pad())
+	{
+		Tick(options);
+		this_thread::sleep_for(1ms);
+	}
+}
+
+// Reads the optional duration argument of a command, false if it is not a number of zero or more seconds.
+static bool ParseSeconds(const CliOptions& options, double defaultSeconds, double& seconds)
+{
+	if (options.arguments.empty())
+	{
+		seconds = defaultSeconds;
+		return true;
+	}
+
+	auto text = options.arguments[0].c_str();
+	char* end;
+	seconds = strtod(text, &end);
+	return end != text && *end == 0 && isfinite(seconds) && seconds >= 0.0;
+}
+
+static bool WaitForPad(const CliOptions& options)
+{
+	if (options.emulator)
+		return Device::StartEmulator(EmulatorSettings());
+
+	auto end = steady_clock::now() + duration<double>(options.timeout);
+	while (!Device::Pad() && steady_clock::now() < end)
+	{
+		Tick(options);
+		if (!Device::Pad())
+			this_thread::sleep_for(50ms);
+	}
+	return Device::Pad() != nullptr;
+}
+
+static json ToJson(const HistogramSummary& summary)
+{
+	return {
+		{"count", summary.count},
+		{"p50", summary.p50},
+		{"p99", summary.p99},
+		{"p999", summary.p999},
+		{"max", summary.max},
+	};
+}
+
+static int Info(const CliOptions& options)
+{
+	auto pad = Device::Pad();
+
+	json j;
+	j["name"] = pad->name;
+	j["board"] = narrow(BoardTypeToString(pad->boardType), wcslen(BoardTypeToString(pad->boardType)));
+	j["firmware"] = to_string(pad->firmwareVersion.major) + "." + to_string(pad->firmwareVersion.minor);
+	j["buttons"] = pad->numButtons;
+	j["releaseThreshold"] = pad->releaseThreshold;
+	j["features"] = {
+		{"debug", pad->featureDebug},
+		{"debugTrace", pad->featureDebugTrace},
+		{"extendedInput", pad->featureExtendedInput},
+		{"digipot", pad->featureDigipot},
+		{"lights", pad->featureLights},
+		{"profiling", pad->featureProfiling},
+		{"baseline", pad->featureBaseline},
+		{"joystickAxes", pad->featureJoystickAxes},
+		{"buttonModes", pad->featureButtonModes},
+		{"transactions", pad->featureTransactions},
+		{"sofSync", pad->featureSofSync},
+		{"rawAdc", pad->featureRawAdc},
+		{"packedInput", pad->featurePackedInput},
+	};
+
+	j["sensors"] = json::array();
+	for (int i = 0; i < pad->numSensors; ++i)
+	{
+		auto sensor = Device::Sensor(i);
+		j["sensors"].push_back({
+			{"threshold", sensor->threshold},
+			{"releaseThreshold", sensor->releaseThreshold},
+			{"button", sensor->button},
+			{"resistorValue", sensor->resistorValue},
+			{"baselineTracking", (sensor->flags & SensorReport::BASELINE_TRACKING) != 0},
+			{"joystickAxis", sensor->JoystickAxis()},
+			{"weight", sensor->weight},
+		});
+	}
+
+	static const char* modeNames[] = { "any", "sum", "weightedSum", "kOfN" };
+	for (int i = 0; pad->featureButtonModes && i < pad->numButtons; ++i)
+	{
+		auto button = Device::Button(i);
+		j["buttonModes"].push_back({
+			{"mode", modeNames[button->mode]},
+			{"count", button->count},
+			{"threshold", button->threshold},
+			{"releaseThreshold", button->releaseThreshold},
+		});
+	}
+
+	cout << j.dump(4) << endl;
+	return 0;
+}
+
+static int Stats(const CliOptions& options)
+{
+	double seconds;
+	if (!ParseSeconds(options, 5.0, seconds))
+	{
+		cerr << USAGE;
+		return 1;
+	}
+
+	Device::ResetPollingStats();
+	Device::ResetSensorStatistics();
+	RunFor(options, seconds);
+
+	if (!Device::Pad())
+	{
+		cerr << "adp-cli: pad disconnected" << endl;
+		return 1;
+	}
+
+	auto reports = Device::Reports();
+	auto polling = Device::PollingStats();
+
+	json j;
+	j["pollingRate"] = Device::PollingRate();
+	j["received"] = reports->received;
+	j["dropped"] = reports->dropped;
+	j["gaps"] = reports->gaps;
+	j["largestGap"] = reports->largestGap;
+	j["latencyMs"] = reports->latency;
+	j["maxLatencyMs"] = reports->maxLatency;
+	j["intervalsUs"] = ToJson(polling.intervals);
+	j["batchSizes"] = ToJson(polling.batchSizes);
+	j["deviceIntervalsUs"] = ToJson(polling.deviceIntervals);
+	j["latencyUs"] = ToJson(polling.latency);
+
+	j["sensors"] = json::array();
+	for (int i = 0; i < Device::Pad()->numSensors; ++i)
+	{
+		auto& statistics = Device::Sensor(i)->statistics;
+		j["sensors"].push_back({
+			{"mean", statistics.mean},
+			{"deviation", statistics.deviation},
+			{"restValue", statistics.restValue},
+			{"noise", statistics.noise},
+			{"drift", statistics.drift},
+			{"driftPerMinute", statistics.driftPerMinute},
+			{"presses", statistics.presses},
+			{"peaks", {statistics.peakLow, statistics.peakMedian, statistics.peakHigh}},
+			{"suggestedThreshold", statistics.suggestedThreshold},
+		});
+	}
+
+	FirmwareBaselines baselines;
+	if (Device::ReadBaselines(baselines))
+	{
+		for (int i = 0; i < Device::Pad()->numSensors; ++i)
+		{
+			j["sensors"][i]["firmwareBaseline"] = baselines.baselines[i];
+			j["sensors"][i]["baselineOffset"] = baselines.offsets[i];
+		}
+	}
+
+	cout << j.dump(4) << endl;
+	return 0;
+}
+
+static int Stream(const CliOptions& options)
+{
+	double seconds;
+	if (!ParseSeconds(options, 0.0, seconds))
+	{
+		cerr << USAGE;
+		return 1;
+	}
+	auto start = steady_clock::now();
+	auto numSensors = Device::Pad()->numSensors;
+
+	cout << "ms";
+	for (int i = 0; i < numSensors; ++i)
+		cout << ",s" << i;
+	cout << ",pressed" << endl;
+
+	// One line per ui tick, values are normalized to 0-1 and averaged over the reports read in that tick.
+	while (Device::Pad() && (seconds <= 0.0 || steady_clock::now() < start + duration<double>(seconds)))
+	{
+		Tick(options);
+
+		int pressed = 0;
+		char line[512];
+		int length = snprintf(line, sizeof(line), "%lld", (long long)duration_cast<milliseconds>(steady_clock::now() - start).count());
+		for (int i = 0; i < numSensors && Device::Pad(); ++i)
+		{
+			auto sensor = Device::Sensor(i);
+			length += snprintf(line + length, sizeof(line) - length, ",%.4f", sensor->value);
+			pressed |= sensor->pressed ? 1 << i : 0;
+		}
+		cout << line << "," << pressed << '\n';
+
+		this_thread::sleep_for(10ms);
+	}
+
+	cout.flush();
+	return Device::Pad() ? 0 : 1;
+}
+
+static int ProfileSave(const CliOptions& options)
+{
+	if (options.arguments.empty())
+	{
+		cerr << USAGE;
+		return 1;
+	}
+
+	ofstream file(options.arguments[0]);
+	if (!file.is_open())
+	{
+		cerr << "adp-cli: could not write " << options.arguments[0] << endl;
+		return 1;
+	}
+
+	json j;
+	Device::SaveProfile(j, DGP_ALL);
+	file << j.dump(4);
+	return 0;
+}
+
+static int ProfileLoad(const CliOptions& options)
+{
+	if (options.arguments.empty())
+	{
+		cerr << USAGE;
+		return 1;
+	}
+
+	ifstream file(options.arguments[0]);
+	if (!file.is_open())
+	{
+		cerr << "adp-cli: could not read " << options.arguments[0] << endl;
+		return 1;
+	}
+
+	try
+	{
+		json j;
+		file >> j;
+		Device::LoadProfile(j, DGP_ALL);
+		Device::SaveChanges();
+	}
+	catch (exception& e)
+	{
+		cerr << "adp-cli: could not apply profile: " << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int Flash(const CliOptions& options)
+{
+	if (options.arguments.empty())
+	{
+		cerr << USAGE;
+		return 1;
+	}
+
+	FirmwareUploader uploader;
+	uploader.SetIgnoreBoardType(options.force);
+
+	auto& path = options.arguments[0];
+	auto result = uploader.UpdateFirmware(wstring(path.begin(), path.end()));
+
+	// The upload runs on the avrdude thread, which waits for the pad to come back. Keep updating the device meanwhile.
+	while (result == FLASHRESULT_RUNNING && uploader.GetFlashResult() == FLASHRESULT_RUNNING)
+	{
+		Tick(options);
+		this_thread::sleep_for(10ms);
+	}
+
+	if (uploader.GetFlashResult() != FLASHRESULT_SUCCESS)
+	{
+		fwprintf(stderr, L"adp-cli: %ls\n", uploader.GetErrorMessage().c_str());
+		if (uploader.GetFlashResult() == FLASHRESULT_FAILURE_BOARDTYPE)
+			fwprintf(stderr, L"adp-cli: use --force to flash anyway\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int Share(const CliOptions& options)
+{
+	auto name = options.arguments.empty() ? SHARED_STATE_DEFAULT_NAME : options.arguments[0].c_str();
+	if (!Device::StartSharing(name))
+	{
+		PrintLog(options);
+		cerr << "adp-cli: could not create shared memory " << name << endl;
+		return 1;
+	}
+
+	// The state is published for every report, so read the device as often as possible.
+	while (true)
+	{
+		Tick(options);
+		this_thread::sleep_for(1ms);
+	}
+}
+
+static int RunDaemon(const CliOptions& options)
+{
+	auto path = options.arguments.empty() ? DaemonSocketPath() : options.arguments[0];
+	if (!Daemon::Start(path.c_str()))
+	{
+		PrintLog(options);
+		cerr << "adp-cli: could not serve on " << path << endl;
+		return 1;
+	}
+
+	// Reads the pad for the clients, as often as possible.
+	while (true)
+	{
+		Device::Update();
+		Daemon::Update();
+		ExportMetrics(options);
+		PrintLog(options);
+		this_thread::sleep_for(1ms);
+	}
+}
+
+static int Serve(const CliOptions& options)
+{
+	uint16_t port = SERVER_DEFAULT_PORT;
+	if (options.arguments.size() > 0)
+	{
+		auto text = options.arguments[0].c_str();
+		char* end;
+		long value = strtol(text, &end, 10);
+		if (end == text || *end != 0 || value < 0 || value > UINT16_MAX)
+		{
+			cerr << USAGE;
+			return 1;
+		}
+		port = (uint16_t)value;
+	}
+
+	auto address = options.arguments.size() > 1 ? options.arguments[1].c_str() : "127.0.0.1";
+
+	if (!Server::Start(port, address, options.origins))
+	{
+		PrintLog(options);
+		cerr << "adp-cli: could not listen on " << address << ":" << port << endl;
+		return 1;
+	}
+
+	// Wide output like the log, stderr keeps the orientation of its first use.
+	fwprintf(stderr, L"adp-cli: serving on %ls:%i\n", widen(address, strlen(address)).c_str(), Server::Port());
+
+	// Keeps serving across reconnects of the pad, like the ui.
+	while (true)
+	{
+		auto changes = Device::Update();
+		Server::Update(changes);
+		ExportMetrics(options);
+		PrintLog(options);
+		this_thread::sleep_for(1ms);
+	}
+}
+
+static int PrintMetrics(const CliOptions& options)
+{
+	// Long enough for the polling rate and the noise statistics.
+	double seconds;
+	if (!ParseSeconds(options, 2.0, seconds))
+	{
+		cerr << USAGE;
+		return 1;
+	}
+	RunFor(options, seconds);
+
+	cout << Metrics::Format();
+	return 0;
+}
+
+static int Run(const CliOptions& options)
+{
+	// The daemon owns the pad, other commands use it through a running daemon unless told otherwise.
+	bool isDaemon = (options.command == "daemon");
+	auto daemonPath = DaemonSocketPath();
+	if (!isDaemon && !options.emulator && !options.direct && IsDaemonRunning(daemonPath))
+		Device::UseDaemon(daemonPath.c_str());
+
+	// The daemon, the server and the shared state report pads as they come and go, they do not need one to start.
+	if (isDaemon || options.command == "serve" || options.command == "share")
+	{
+		if (options.emulator)
+			WaitForPad(options);
+		if (isDaemon)
+			return RunDaemon(options);
+		return options.command == "serve" ? Serve(options) : Share(options);
+	}
+
+	if (!WaitForPad(options))
+	{
+		cerr << "adp-cli: no pad found" << endl;
+		return 2;
+	}
+
+	if (options.command == "info")
+		return Info(options);
+	if (options.command == "stats")
+		return Stats(options);
+	if (options.command == "stream")
+		return Stream(options);
+	if (options.command == "metrics")
+		return PrintMetrics(options);
+	if (options.command == "profile-save")
+		return ProfileSave(options);
+	if (options.command == "profile-load")
+		return ProfileLoad(options);
+	if (options.command == "flash")
+		return Flash(options);
+
+	cerr << USAGE;
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	CliOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--emulator") == 0)
+			options.emulator = true;
+		else if (strcmp(argv[i], "--direct") == 0)
+			options.direct = true;
+		else if (strcmp(argv[i], "--force") == 0)
+			options.force = true;
+		else if (strcmp(argv[i], "--verbose") == 0)
+			options.verbose = true;
+		else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+			options.metricsPath = argv[++i];
+		else if (strcmp(argv[i], "--origin") == 0 && i + 1 < argc)
+			options.origins.push_back(argv[++i]);
+		else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc)
+			options.timeout = atof(argv[++i]);
+		else if (options.command.empty())
+			options.command = argv[i];
+		else
+			options.arguments.push_back(argv[i]);
+	}
+
+	if (options.command.empty() || options.command == "help")
+	{
+		cerr << USAGE;
+		return options.command.empty() ? 1 : 0;
+	}
+
+	Log::Init();
+	Device::Init();
+
+	int result = Run(options);
+
+	Device::Shutdown();
+	PrintLog(options);
+	Log::Shutdown();
+	return result;
+}
@@ -0,0 +1,545 @@
+#include "Adp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Model/Recorder.h"
+#include "Model/Replay.h"
+
+// The button decision of the firmware, shared with Pad.c.
+#include "PadDecision.h"
+
+using namespace std;
+using namespace chrono;
+using namespace adp;
+using json = nlohmann::json;
+
+// Offline threshold optimizer. Runs a recording made with adp-tool (File, Record) through the button decision of the
+// firmware for a grid of threshold and release threshold pairs, and scores every pair against the steps that were
+// actually taken. The sweep runs in parallel over sensors and release thresholds.
+//
+//   adp-optimize [options] <recording.adpr> <steps.csv>
+//
+// steps.csv has one step per line, "<ms since the start of the recording>,<button>" with buttons numbered from 1 as
+// in the ui. Lines starting with # are skipped. The step times of a chart work too, once they line up with the
+// recording.
+//
+// A press that starts within the window around a step of its button hits that step, every other press is a false
+// trigger and every step without a press is a miss. Each sensor is scored on its own against the steps of its
+// button, then all sensors of a button are checked together with the chosen thresholds. Out of the pairs with the
+// fewest errors the middle of the widest range of thresholds is taken, which leaves the most margin on both sides.
+//
+// The ui and the firmware share one release threshold (a fraction of the threshold) between all sensors, the profile
+// written with --out uses the fraction with the fewest errors over all sensors.
+
+static const char* USAGE =
+	"usage: adp-optimize [options] <recording.adpr> <steps.csv>\n"
+	"\n"
+	"options:\n"
+	"  --window <ms>          how far a press may start from its step (default 50)\n"
+	"  --step <n>             distance between candidate thresholds in device units (default 5)\n"
+	"  --profile <file>       take the sensor to button mapping from a profile instead of the recorded buttons\n"
+	"  --out <file>           write the thresholds as a profile for adp-cli profile-load or the ui\n"
+	"  --threads <n>          worker threads (default: all cores)\n";
+
+// Release thresholds as a fraction of the threshold, like the slider of the sensitivity tab.
+constexpr int RELEASE_STEPS = 11;
+constexpr int MIN_RELEASE_PERCENT = 50;
+constexpr int RELEASE_STEP_PERCENT = 5;
+
+// A recorded button counts as the button of a sensor if pressing it raises the sensor by at least this much.
+constexpr double MIN_MAPPING_DIFFERENCE = MAX_SENSOR_VALUE * 0.1;
+
+struct OptimizeOptions
+{
+	string recordingPath;
+	string stepsPath;
+	string profilePath;
+	string outPath;
+	int64_t window = 50000; // us
+	int thresholdStep = 5;
+	int numThreads = 0;
+};
+
+struct Session
+{
+	int sensorCount = 0;
+	vector<int64_t> times; // us since the start of the recording
+	vector<uint16_t> buttons; // as recorded
+	vector<uint16_t> values[MAX_SENSOR_COUNT];
+	vector<int64_t> steps[MAX_BUTTON_COUNT]; // us, per button
+};
+
+struct Score
+{
+	int missed = 0;
+	int falseTriggers = 0;
+
+	int Cost() const { return missed + falseTriggers; }
+};
+
+// Best pair of one sensor at one release threshold.
+struct Candidate
+{
+	Score score;
+	int threshold = 0;
+	int range = 0; // number of neighbouring thresholds with the same cost
+};
+
+static double ReleaseFraction(int releaseIndex)
+{
+	return (MIN_RELEASE_PERCENT + releaseIndex * RELEASE_STEP_PERCENT) / 100.0;
+}
+
+// Like ToDeviceSensorValue of the model, the release threshold the firmware ends up with.
+static int ReleaseThreshold(int threshold, int releaseIndex)
+{
+	return (int)lround(threshold * ReleaseFraction(releaseIndex));
+}
+
+// ====================================================================================================================
+// Input.
+// ====================================================================================================================
+
+static bool ReadSession(const OptimizeOptions& options, Session& session)
+{
+	RecordingReader reader;
+	if (!reader.Open(options.recordingPath))
+	{
+		cerr << "adp-optimize: could not read recording " << options.recordingPath << endl;
+		return false;
+	}
+
+	session.sensorCount = reader.SensorCount();
+
+	vector<RecordedSample> samples;
+	while (reader.ReadChunk(samples))
+	{
+		for (auto& sample : samples)
+		{
+			session.times.push_back(sample.time);
+			session.buttons.push_back(sample.buttons);
+			for (int i = 0; i < session.sensorCount; ++i)
+				session.values[i].push_back(sample.sensors[i]);
+		}
+	}
+
+	if (session.times.empty())
+	{
+		cerr << "adp-optimize: the recording holds no input" << endl;
+		return false;
+	}
+
+	ifstream file(options.stepsPath);
+	if (!file.is_open())
+	{
+		cerr << "adp-optimize: could not read steps " << options.stepsPath << endl;
+		return false;
+	}
+
+	string line;
+	int lineNumber = 0;
+	while (getline(file, line))
+	{
+		++lineNumber;
+		if (line.empty() || line[0] == '#' || line[0] == '\r')
+			continue;
+
+		double ms;
+		int button;
+		if (sscanf(line.c_str(), "%lf,%i", &ms, &button) != 2 || button < 1 || button > MAX_BUTTON_COUNT)
+		{
+			cerr << "adp-optimize: " << options.stepsPath << ":" << lineNumber << ": expected <ms>,<button>" << endl;
+			return false;
+		}
+		session.steps[button - 1].push_back(llround(ms * 1000.0));
+	}
+
+	for (auto& steps : session.steps)
+		sort(steps.begin(), steps.end());
+
+	return true;
+}
+
+// Sensor to button mapping (1-based, zero is unmapped) from a profile, or else the recorded button that goes down
+// with the sensor the most.
+static bool ReadMapping(const OptimizeOptions& options, const Session& session, int* mapping)
+{
+	if (!options.profilePath.empty())
+	{
+		try
+		{
+			ifstream file(options.profilePath);
+			json j;
+			file >> j;
+			for (int i = 0; i < session.sensorCount; ++i)
+			{
+				auto& sensors = j["sensors"];
+				int button = (i < (int)sensors.size() && sensors[i].contains("button")) ? (int)sensors[i]["button"] : 0;
+
+				// Buttons the recording cannot have are unmapped, like zero.
+				if (button < 0 || button > MAX_BUTTON_COUNT)
+				{
+					cerr << "adp-optimize: ignoring button " << button << " of sensor " << (i + 1) << endl;
+					button = 0;
+				}
+				mapping[i] = button;
+			}
+		}
+		catch (exception& e)
+		{
+			cerr << "adp-optimize: could not read profile " << options.profilePath << ": " << e.what() << endl;
+			return false;
+		}
+		return true;
+	}
+
+	for (int i = 0; i < session.sensorCount; ++i)
+	{
+		double pressedSums[MAX_BUTTON_COUNT] = {}, releasedSums[MAX_BUTTON_COUNT] = {};
+		uint64_t pressedCounts[MAX_BUTTON_COUNT] = {};
+		auto& values = session.values[i];
+		for (size_t n = 0; n < values.size(); ++n)
+		{
+			for (int b = 0; b < MAX_BUTTON_COUNT; ++b)
+			{
+				if (session.buttons[n] & (1 << b))
+				{
+					pressedSums[b] += values[n];
+					++pressedCounts[b];
+				}
+				else
+				{
+					releasedSums[b] += values[n];
+				}
+			}
+		}
+
+		mapping[i] = 0;
+		double bestDifference = MIN_MAPPING_DIFFERENCE;
+		for (int b = 0; b < MAX_BUTTON_COUNT; ++b)
+		{
+			auto releasedCount = values.size() - pressedCounts[b];
+			if (pressedCounts[b] == 0 || releasedCount == 0)
+				continue;
+
+			double difference = pressedSums[b] / pressedCounts[b] - releasedSums[b] / releasedCount;
+			if (difference > bestDifference)
+			{
+				bestDifference = difference;
+				mapping[i] = b + 1;
+			}
+		}
+	}
+	return true;
+}
+
+// ====================================================================================================================
+// Scoring.
+// ====================================================================================================================
+
+// Matches the presses of a button to its steps in time order. Steps are consumed as the presses go by, a step that is
+// left behind is a miss.
+class StepMatcher
+{
+public:
+	StepMatcher(const vector<int64_t>& steps, int64_t window) : mySteps(steps), myWindow(window) {}
+
+	void Press(int64_t time)
+	{
+		while (myNext < mySteps.size() && mySteps[myNext] + myWindow < time)
+		{
+			++myNext;
+			++myScore.missed;
+		}
+
+		if (myNext < mySteps.size() && mySteps[myNext] - myWindow <= time)
+			++myNext;
+		else
+			++myScore.falseTriggers;
+	}
+
+	Score Finish()
+	{
+		myScore.missed += (int)(mySteps.size() - myNext);
+		myNext = mySteps.size();
+		return myScore;
+	}
+
+private:
+	const vector<int64_t>& mySteps;
+	int64_t myWindow;
+	size_t myNext = 0;
+	Score myScore;
+};
+
+static Score ScoreSensor(const Session& session, int sensor, int button, int threshold, int releaseThreshold,
+	int64_t window)
+{
+	StepMatcher matcher(session.steps[button - 1], window);
+	auto& values = session.values[sensor];
+	bool pressed = false;
+
+	for (size_t n = 0; n < values.size(); ++n)
+	{
+		bool next = Pad_IsSensorPressed(pressed, values[n], (uint16_t)threshold, (uint16_t)releaseThreshold);
+		if (next && !pressed)
+			matcher.Press(session.times[n]);
+		pressed = next;
+	}
+
+	return matcher.Finish();
+}
+
+// All sensors of a button together, in the same way as Pad_UpdateState.
+static Score ScoreButton(const Session& session, const int* mapping, const int* thresholds,
+	const int* releaseThresholds, int button, int64_t window)
+{
+	StepMatcher matcher(session.steps[button - 1], window);
+	bool pressed = false;
+
+	for (size_t n = 0; n < session.times.size(); ++n)
+	{
+		bool next = false;
+		for (int i = 0; i < session.sensorCount && !next; ++i)
+		{
+			if (mapping[i] == button)
+				next = Pad_IsSensorPressed(pressed, session.values[i][n], (uint16_t)thresholds[i], (uint16_t)releaseThresholds[i]);
+		}
+		if (next && !pressed)
+			matcher.Press(session.times[n]);
+		pressed = next;
+	}
+
+	return matcher.Finish();
+}
+
+// The middle of the widest range of thresholds with the lowest cost.
+static Candidate PickCandidate(const vector<Score>& scores, int thresholdStep)
+{
+	int lowest = INT32_MAX;
+	for (auto& score : scores)
+		lowest = min(lowest, score.Cost());
+
+	Candidate candidate;
+	int runStart = 0;
+	for (int t = 0; t <= (int)scores.size(); ++t)
+	{
+		if (t < (int)scores.size() && scores[t].Cost() == lowest)
+			continue;
+
+		int range = t - runStart;
+		if (range > candidate.range)
+		{
+			int middle = runStart + range / 2;
+			candidate.range = range;
+			candidate.threshold = (middle + 1) * thresholdStep;
+			candidate.score = scores[middle];
+		}
+		runStart = t + 1;
+	}
+	return candidate;
+}
+
+static bool IsBetter(const Candidate& a, const Candidate& b)
+{
+	if (a.score.Cost() != b.score.Cost())
+		return a.score.Cost() < b.score.Cost();
+	return a.range > b.range;
+}
+
+// ====================================================================================================================
+// Main.
+// ====================================================================================================================
+
+int main(int argc, char** argv)
+{
+	OptimizeOptions options;
+	vector<string> arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--window") == 0 && hasValue)
+			options.window = llround(atof(argv[++i]) * 1000.0);
+		else if (strcmp(argv[i], "--step") == 0 && hasValue)
+			options.thresholdStep = clamp(atoi(argv[++i]), 1, MAX_SENSOR_VALUE);
+		else if (strcmp(argv[i], "--profile") == 0 && hasValue)
+			options.profilePath = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && hasValue)
+			options.outPath = argv[++i];
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+			options.numThreads = max(1, atoi(argv[++i]));
+		else if (argv[i][0] == '-')
+		{
+			cerr << USAGE;
+			return 1;
+		}
+		else
+			arguments.push_back(argv[i]);
+	}
+
+	if (arguments.size() != 2)
+	{
+		cerr << USAGE;
+		return 1;
+	}
+	options.recordingPath = arguments[0];
+	options.stepsPath = arguments[1];
+
+	auto start = steady_clock::now();
+
+	Session session;
+	int mapping[MAX_SENSOR_COUNT] = {};
+	if (!ReadSession(options, session) || !ReadMapping(options, session, mapping))
+		return 1;
+
+	// Thresholds above MAX_SENSOR_VALUE cannot be set from the ui.
+	int numThresholds = MAX_SENSOR_VALUE / options.thresholdStep;
+	int numJobs = session.sensorCount * RELEASE_STEPS;
+
+	// Every job scores all thresholds of one sensor at one release threshold.
+	vector<vector<Score>> scores(numJobs, vector<Score>(numThresholds));
+	atomic<int> nextJob(0);
+
+	auto worker = [&]()
+	{
+		for (int job = nextJob++; job < numJobs; job = nextJob++)
+		{
+			int sensor = job / RELEASE_STEPS;
+			int releaseIndex = job % RELEASE_STEPS;
+			if (mapping[sensor] == 0)
+				continue;
+
+			for (int t = 0; t < numThresholds; ++t)
+			{
+				int threshold = (t + 1) * options.thresholdStep;
+				scores[job][t] = ScoreSensor(session, sensor, mapping[sensor], threshold,
+					ReleaseThreshold(threshold, releaseIndex), options.window);
+			}
+		}
+	};
+
+	int numThreads = options.numThreads > 0 ? options.numThreads : max(1u, thread::hardware_concurrency());
+	vector<thread> threads;
+	for (int i = 0; i < min(numThreads, numJobs); ++i)
+		threads.emplace_back(worker);
+	for (auto& thread : threads)
+		thread.join();
+
+	// The best pair of every sensor on its own, and the shared release threshold with the fewest errors overall.
+	Candidate candidates[MAX_SENSOR_COUNT][RELEASE_STEPS];
+	int sharedRelease = RELEASE_STEPS - 1;
+	int sharedCost = INT32_MAX;
+	for (int r = RELEASE_STEPS - 1; r >= 0; --r)
+	{
+		int cost = 0;
+		for (int i = 0; i < session.sensorCount; ++i)
+		{
+			if (mapping[i] == 0)
+				continue;
+			candidates[i][r] = PickCandidate(scores[i * RELEASE_STEPS + r], options.thresholdStep);
+			cost += candidates[i][r].score.Cost();
+		}
+		if (cost < sharedCost)
+		{
+			sharedCost = cost;
+			sharedRelease = r;
+		}
+	}
+
+	json result;
+	json profile;
+	int thresholds[MAX_SENSOR_COUNT] = {};
+	int releaseThresholds[MAX_SENSOR_COUNT] = {};
+	constexpr double scalar = 1.0 / (double)MAX_SENSOR_VALUE;
+
+	result["sensors"] = json::array();
+	profile["sensors"] = json::array();
+	for (int i = 0; i < session.sensorCount; ++i)
+	{
+		if (mapping[i] == 0)
+		{
+			result["sensors"].push_back({{"button", 0}});
+			profile["sensors"].push_back(json::object());
+			continue;
+		}
+
+		int best = RELEASE_STEPS - 1;
+		for (int r = RELEASE_STEPS - 1; r >= 0; --r)
+		{
+			if (IsBetter(candidates[i][r], candidates[i][best]))
+				best = r;
+		}
+
+		auto& own = candidates[i][best];
+		auto& shared = candidates[i][sharedRelease];
+		thresholds[i] = shared.threshold;
+		releaseThresholds[i] = ReleaseThreshold(shared.threshold, sharedRelease);
+
+		result["sensors"].push_back({
+			{"button", mapping[i]},
+			{"steps", session.steps[mapping[i] - 1].size()},
+			{"best", {
+				{"threshold", own.threshold * scalar},
+				{"releaseThreshold", ReleaseThreshold(own.threshold, best) * scalar},
+				{"missed", own.score.missed},
+				{"falseTriggers", own.score.falseTriggers},
+			}},
+			{"shared", {
+				{"threshold", shared.threshold * scalar},
+				{"releaseThreshold", releaseThresholds[i] * scalar},
+				{"missed", shared.score.missed},
+				{"falseTriggers", shared.score.falseTriggers},
+			}},
+		});
+		profile["sensors"].push_back({
+			{"threshold", shared.threshold * scalar},
+			{"releaseThreshold", releaseThresholds[i] * scalar},
+		});
+	}
+
+	result["buttons"] = json::array();
+	for (int button = 1; button <= MAX_BUTTON_COUNT; ++button)
+	{
+		if (find(mapping, mapping + session.sensorCount, button) == mapping + session.sensorCount)
+			continue;
+
+		auto score = ScoreButton(session, mapping, thresholds, releaseThresholds, button, options.window);
+		result["buttons"].push_back({
+			{"button", button},
+			{"steps", session.steps[button - 1].size()},
+			{"missed", score.missed},
+			{"falseTriggers", score.falseTriggers},
+		});
+	}
+
+	result["releaseThreshold"] = ReleaseFraction(sharedRelease);
+	result["reports"] = session.times.size();
+	result["seconds"] = duration<double>(steady_clock::now() - start).count();
+	profile["releaseThreshold"] = ReleaseFraction(sharedRelease);
+
+	if (!options.outPath.empty())
+	{
+		ofstream file(options.outPath);
+		if (!file.is_open())
+		{
+			cerr << "adp-optimize: could not write " << options.outPath << endl;
+			return 1;
+		}
+		file << profile.dump(4);
+	}
+
+	cout << result.dump(4) << endl;
+	return 0;
+}
@@ -15,6 +15,11 @@ export namespace ServerEvents {
     deviceId: string
     inputData: DeviceInputData
   }
+
+  export type Error = {
+    event: string
+    message: string
+  }
 }
 
 // from client
@@ -35,9 +35,40 @@
 #include "Reset.h"
 #include "Lights.h"
 #include "Debug.h"
+#include "Timer.h"
+#include "Profiling.h"
+#include "Baseline.h"
+#include "Joystick.h"
+#include "Sampling.h"
+#include "RawAdc.h"
+#include "PackedInput.h"
 
 static Configuration configuration;
 
+/** Format of the input report, selected by the host through SPID_INPUT_REPORT_FORMAT. */
+static uint8_t inputReportFormat = INPUT_REPORT_FORMAT_DEFAULT;
+
+#if defined(FEATURE_RAW_ADC_ENABLED)
+/** Set when raw streaming starts, the first report of the stream is an input report with every button released. */
+static bool isReleaseReportDue = false;
+#endif
+
+/** Parts of the configuration to apply, see ApplyConfiguration. */
+#define APPLY_PAD     (1 << 0)
+#define APPLY_BUTTONS (1 << 1)
+#define APPLY_LIGHTS  (1 << 2)
+
+#if defined(FEATURE_TRANSACTIONS_ENABLED)
+/** Set between TRANSACTION_BEGIN and TRANSACTION_COMMIT, the parts of the configuration changed in between. */
+static bool isInTransaction = false;
+static uint8_t pendingApplies = 0;
+
+/** Timer_Micros() of the last report of the open transaction, see TransactionTask. */
+static uint32_t lastTransactionReport = 0;
+
+static void TransactionTask(void);
+#endif
+
 /** Buffer to hold the previously generated HID report, for comparison purposes inside the HID class driver. */
 static uint8_t PrevHIDReportBuffer[GENERIC_EPSIZE];
 
@@ -73,8 +104,15 @@ int main(void)
 
     for (;;)
     {
-        HID_Device_USBTask(&Generic_HID_Interface);
+        if (Sampling_IsScanDue())
+            HID_Device_USBTask(&Generic_HID_Interface);
         USB_USBTask();
+        Sampling_Poll();
+        RawAdc_Task();
+        PackedInput_Task();
+        #if defined(FEATURE_TRANSACTIONS_ENABLED)
+        TransactionTask();
+        #endif
     }
 }
 
@@ -101,20 +139,102 @@ void SetupHardware(void)
 #endif
 
     /* Hardware Initialization */
+    Timer_Init();
     USB_Init();
 }
 
 void SetupConfiguration()
 {
+	Pad_UpdateButtonConfiguration(&configuration.buttonConfiguration);
 	Pad_Initialize(&configuration.padConfiguration);
     Lights_UpdateConfiguration(&configuration.lightConfiguration);
 }
 
+/** Hands changed parts of the configuration to the pad and the lights, or stages them while a transaction is open. */
+static void ApplyConfiguration(uint8_t applies)
+{
+    #if defined(FEATURE_TRANSACTIONS_ENABLED)
+    if (isInTransaction)
+    {
+        pendingApplies |= applies;
+        lastTransactionReport = Timer_Micros();
+        return;
+    }
+    #endif
+
+    #if defined(FEATURE_BUTTON_MODES_ENABLED)
+    if (applies & APPLY_BUTTONS)
+    {
+        // keep the selection of the host, like the other selected indices it is not part of the configuration
+        configuration.buttonConfiguration.selectedButtonIndex = BUTTON_CONF.selectedButtonIndex;
+        Pad_UpdateButtonConfiguration(&configuration.buttonConfiguration);
+    }
+    #endif
+
+    if (applies & APPLY_PAD)
+        Pad_UpdateConfiguration(&configuration.padConfiguration);
+
+    if (applies & APPLY_LIGHTS)
+        Lights_UpdateConfiguration(&configuration.lightConfiguration);
+}
+
+#if defined(FEATURE_TRANSACTIONS_ENABLED)
+static void EndTransaction(void)
+{
+    isInTransaction = false;
+    ApplyConfiguration(pendingApplies);
+    pendingApplies = 0;
+}
+
+/** Commits a transaction that saw no report for TRANSACTION_TIMEOUT_MS, its host is gone or has forgotten it. */
+static void TransactionTask(void)
+{
+    if (isInTransaction && Timer_Micros() - lastTransactionReport > TRANSACTION_TIMEOUT_MS * 1000UL)
+        EndTransaction();
+}
+#endif
+
+/** Whether this build can send the given SPID_INPUT_REPORT_FORMAT, the optional ones depend on features. */
+static bool IsInputReportFormatSupported(uint32_t format)
+{
+    switch (format)
+    {
+    case INPUT_REPORT_FORMAT_DEFAULT:
+    case INPUT_REPORT_FORMAT_EXTENDED:
+        return true;
+
+    #if defined(FEATURE_RAW_ADC_ENABLED)
+    case INPUT_REPORT_FORMAT_RAW_ADC:
+        return true;
+    #endif
+
+    #if defined(FEATURE_PACKED_INPUT_ENABLED)
+    case INPUT_REPORT_FORMAT_PACKED:
+        return true;
+    #endif
+    }
+
+    return false;
+}
+
 /** Event handler for the library USB Configuration Changed event. */
 void EVENT_USB_Device_ConfigurationChanged(void)
 {
     HID_Device_ConfigureEndpoints(&Generic_HID_Interface);
     USB_Device_EnableSOFEvents();
+
+    // a (re)connected host has to ask for the extended input report again
+    inputReportFormat = INPUT_REPORT_FORMAT_DEFAULT;
+    RawAdc_SetActive(false);
+    PackedInput_SetActive(false);
+
+    #if defined(FEATURE_TRANSACTIONS_ENABLED)
+    // a host that went away during a transaction cannot commit it anymore, apply what it changed so far
+    if (isInTransaction)
+        EndTransaction();
+    #endif
+
+    Profiling_Configured();
 }
 
 /** Event handler for the library USB Control Request reception event. */
@@ -127,6 +247,8 @@ void EVENT_USB_Device_ControlRequest(void)
 void EVENT_USB_Device_StartOfFrame(void)
 {
     HID_Device_MillisecondElapsed(&Generic_HID_Interface);
+    Sampling_StartOfFrame();
+    Profiling_Frame();
 }
 
 /** HID class driver callback function for the creation of HID reports to the host.
@@ -146,10 +268,63 @@ bool CALLBACK_HID_Device_CreateHIDReport(
     void* ReportData,
     uint16_t* const ReportSize)
 {
-    if (*ReportID == 0)
+    #if defined(FEATURE_RAW_ADC_ENABLED)
+    if (*ReportID == 0 && inputReportFormat == INPUT_REPORT_FORMAT_RAW_ADC && isReleaseReportDue)
+    {
+        // no report id requested - the last input report before streaming, with every button released
+        memset(ReportData, 0, sizeof (InputHIDReport));
+        *ReportID = INPUT_REPORT_ID;
+        *ReportSize = sizeof (InputHIDReport);
+        isReleaseReportDue = false;
+    }
+    else if (*ReportID == 0 && inputReportFormat == INPUT_REPORT_FORMAT_RAW_ADC)
+    {
+        // no report id requested - write the raw conversions, nothing goes out until there are some
+        RawAdcHIDReport* report = ReportData;
+        *ReportID = RAW_ADC_REPORT_ID;
+        *ReportSize = RawAdc_Write(&report->samples) ? sizeof (RawAdcHIDReport) : 0;
+    }
+    else
+    #endif
+    #if defined(FEATURE_JOYSTICK_AXES_ENABLED)
+    if (*ReportID == 0 && Joystick_IsReportDue())
+    {
+        // no report id requested and a joystick axis changed - write the axes
+        JoystickHIDReport* report = ReportData;
+        Joystick_Write(&report->axes);
+        *ReportID = ANALOG_JOYSTICK_REPORT_ID;
+        *ReportSize = sizeof (JoystickHIDReport);
+    }
+    else
+    #endif
+    #if defined(FEATURE_PACKED_INPUT_ENABLED)
+    if (*ReportID == 0 && inputReportFormat == INPUT_REPORT_FORMAT_PACKED)
+    {
+        // no report id requested - write the scans since the previous report, nothing goes out until there are some
+        PackedInputHIDReport* report = ReportData;
+        *ReportID = PACKED_INPUT_REPORT_ID;
+        *ReportSize = 0;
+        if (PackedInput_Write(&report->input))
+        {
+            Sampling_InputReport();
+            *ReportSize = sizeof (PackedInputHIDReport);
+        }
+    }
+    else
+    #endif
+    if (*ReportID == 0 && inputReportFormat == INPUT_REPORT_FORMAT_EXTENDED)
+    {
+        // no report id requested - write button and sensor data with sequence number and timestamp
+        Communication_WriteInputExtendedHIDReport(ReportData);
+        Sampling_InputReport();
+        *ReportID = INPUT_EXTENDED_REPORT_ID;
+        *ReportSize = sizeof (InputExtendedHIDReport);
+    }
+    else if (*ReportID == 0)
     {
         // no report id requested - write button and sensor data
         Communication_WriteInputHIDReport(ReportData);
+        Sampling_InputReport();
         *ReportID = INPUT_REPORT_ID;
         *ReportSize = sizeof (InputHIDReport);
     }
@@ -157,13 +332,14 @@ bool CALLBACK_HID_Device_CreateHIDReport(
     {
         PadConfigurationFeatureHIDReport* report = ReportData;
 		
+		// the configuration in use, like the other reads, not the one staged by an open transaction
 		report->configuration.releaseMultiplier =
-			configuration.padConfiguration.sensors[0].threshold /
-			configuration.padConfiguration.sensors[0].releaseThreshold;
+			PAD_CONF.sensors[0].threshold /
+			PAD_CONF.sensors[0].releaseThreshold;
 		
 		for (int s = 0; s < SENSOR_COUNT; s++) {
-			report->configuration.sensorThresholds[s] = configuration.padConfiguration.sensors[s].threshold;
-			report->configuration.sensorToButtonMapping[s] = configuration.padConfiguration.sensors[s].buttonMapping;
+			report->configuration.sensorThresholds[s] = PAD_CONF.sensors[s].threshold;
+			report->configuration.sensorToButtonMapping[s] = PAD_CONF.sensors[s].buttonMapping;
 		}
         *ReportSize = sizeof (PadConfigurationFeatureHIDReport);
     }
@@ -217,22 +393,40 @@ bool CALLBACK_HID_Device_CreateHIDReport(
             memset(&report->sensor, 0, sizeof(SensorConfig));
         *ReportSize = sizeof(SensorHIDReport);
     }
+	#if defined(FEATURE_PROFILING_ENABLED)
+	else if (*ReportID == PROFILING_REPORT_ID)
+    {
+        ProfilingHIDReport* report = ReportData;
+        Profiling_Read(&report->counters);
+        *ReportSize = sizeof(ProfilingHIDReport);
+    }
+	#endif
+	#if defined(FEATURE_BUTTON_MODES_ENABLED)
+	else if (*ReportID == BUTTON_REPORT_ID)
+    {
+        ButtonHIDReport* report = ReportData;
+        report->index = BUTTON_CONF.selectedButtonIndex;
+        if (report->index < BUTTON_COUNT)
+            memcpy(&report->button, &BUTTON_CONF.buttons[report->index], sizeof(ButtonConfig));
+        else
+            memset(&report->button, 0, sizeof(ButtonConfig));
+        memcpy(report->sensorWeights, BUTTON_CONF.sensorWeights, sizeof(report->sensorWeights));
+        *ReportSize = sizeof(ButtonHIDReport);
+    }
+	#endif
+	#if defined(FEATURE_BASELINE_ENABLED)
+	else if (*ReportID == BASELINE_REPORT_ID)
+    {
+        BaselineHIDReport* report = ReportData;
+        Baseline_Read(&report->state);
+        *ReportSize = sizeof(BaselineHIDReport);
+    }
+	#endif
 	#if defined(FEATURE_DEBUG_ENABLED)
 	else if (*ReportID == DEBUG_REPORT_ID)
     {
         DebugHIDReport* report = ReportData;
-		
-		uint16_t readSize = Debug_Available();
-		uint16_t maxReadSize = sizeof(report->messagePacket);
-		
-		if(readSize > 0) {
-			if(readSize > maxReadSize) {
-				readSize = maxReadSize;
-			}
-			
-			report->messageSize = readSize;
-			Debug_ReadBuffer(&report->messagePacket, readSize);
-		}
+        report->messageSize = Debug_ReadBuffer(report->messagePacket, sizeof(report->messagePacket));
 		
         *ReportSize = sizeof(DebugHIDReport);
     }
@@ -263,7 +457,7 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
 			configuration.padConfiguration.sensors[s].releaseThreshold = report->configuration.sensorThresholds[s] * report->configuration.releaseMultiplier;
 			configuration.padConfiguration.sensors[s].buttonMapping = report->configuration.sensorToButtonMapping[s];
 		}
-        Pad_UpdateConfiguration(&configuration.padConfiguration);
+        ApplyConfiguration(APPLY_PAD);
     }
     else if (ReportID == RESET_REPORT_ID)
     {
@@ -291,7 +485,7 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
         if (report->index < MAX_LIGHT_RULES)
         {
             memcpy(&configuration.lightConfiguration.lightRules[report->index], &report->rule, sizeof(LightRule));
-            Lights_UpdateConfiguration(&configuration.lightConfiguration);
+            ApplyConfiguration(APPLY_LIGHTS);
         }
     }
     else if (ReportID == LED_MAPPING_REPORT_ID && ReportSize == sizeof(LedMappingHIDReport))
@@ -300,7 +494,7 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
         if (report->index < MAX_LED_MAPPINGS)
         {
             memcpy(&configuration.lightConfiguration.ledMappings[report->index], &report->mapping, sizeof(LedMapping));
-            Lights_UpdateConfiguration(&configuration.lightConfiguration);
+            ApplyConfiguration(APPLY_LIGHTS);
         }
     }
     else if (ReportID == SENSOR_REPORT_ID && ReportSize == sizeof(SensorHIDReport))
@@ -313,9 +507,38 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
 				&report->sensor,
 				sizeof(SensorConfig)
 			);
-            Pad_UpdateConfiguration(&configuration.padConfiguration);
+            ApplyConfiguration(APPLY_PAD);
+        }
+    }
+	#if defined(FEATURE_BUTTON_MODES_ENABLED)
+    else if (ReportID == BUTTON_REPORT_ID && ReportSize == sizeof(ButtonHIDReport))
+    {
+        const ButtonHIDReport* report = ReportData;
+        if (report->index < BUTTON_COUNT && ConfigStore_IsValidButtonConfig(&report->button))
+        {
+            ButtonConfiguration* buttons = &configuration.buttonConfiguration;
+            memcpy(&buttons->buttons[report->index], &report->button, sizeof(ButtonConfig));
+            for (int s = 0; s < SENSOR_COUNT; s++) {
+                if (configuration.padConfiguration.sensors[s].buttonMapping == report->index)
+                    buttons->sensorWeights[s] = report->sensorWeights[s];
+            }
+            ApplyConfiguration(APPLY_BUTTONS);
+        }
+    }
+	#endif
+	#if defined(FEATURE_TRANSACTIONS_ENABLED)
+    else if (ReportID == TRANSACTION_REPORT_ID && ReportSize == sizeof(TransactionHIDReport))
+    {
+        const TransactionHIDReport* report = ReportData;
+        if (report->action == TRANSACTION_BEGIN)
+        {
+            isInTransaction = true;
+            lastTransactionReport = Timer_Micros();
         }
+        else if (report->action == TRANSACTION_COMMIT && isInTransaction)
+            EndTransaction();
     }
+	#endif
     else if (ReportID == SET_PROPERTY_REPORT_ID && ReportSize == sizeof (SetPropertyHIDReport))
     {
         const SetPropertyHIDReport* report = ReportData;
@@ -332,6 +555,35 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
         case SPID_SELECTED_SENSOR_INDEX:
             PAD_CONF.selectedSensorIndex = (uint8_t)report->propertyValue;
             break;
+
+        case SPID_SELECTED_BUTTON_INDEX:
+            BUTTON_CONF.selectedButtonIndex = (uint8_t)report->propertyValue;
+            break;
+
+        case SPID_INPUT_REPORT_FORMAT:
+            if (IsInputReportFormatSupported(report->propertyValue))
+            {
+                #if defined(FEATURE_RAW_ADC_ENABLED)
+                if (report->propertyValue == INPUT_REPORT_FORMAT_RAW_ADC &&
+                    inputReportFormat != INPUT_REPORT_FORMAT_RAW_ADC)
+                {
+                    // the pad is not scanned while streaming, buttons and lights must not stick meanwhile
+                    Pad_ReleaseState();
+                    isReleaseReportDue = true;
+                }
+                #endif
+
+                inputReportFormat = (uint8_t)report->propertyValue;
+                RawAdc_SetActive(inputReportFormat == INPUT_REPORT_FORMAT_RAW_ADC);
+                PackedInput_SetActive(inputReportFormat == INPUT_REPORT_FORMAT_PACKED);
+            }
+            break;
+
+        #if defined(FEATURE_RAW_ADC_ENABLED)
+        case SPID_RAW_ADC_SENSOR:
+            RawAdc_Select((uint8_t)report->propertyValue);
+            break;
+        #endif
         }
     }
 }
@@ -0,0 +1,97 @@
+#include <stdbool.h>
+
+#include "Baseline.h"
+#include "Pad.h"
+
+#if defined(FEATURE_BASELINE_ENABLED)
+
+// The baseline has 16 fraction bits, so a difference of one step still moves it at the slow rate. Each scan moves it
+// 1/16384 of the way to the sensor value, a time constant of about 16 seconds at 1000 scans per second. After power on
+// it starts from the first value and converges faster, 1/64 per scan, until it has settled.
+#define BASELINE_FRACTION_BITS 16
+#define BASELINE_SHIFT 14
+#define BASELINE_SETTLE_SHIFT 6
+#define BASELINE_SETTLE_SCANS 1024
+
+// An FSR takes a while to recover after it was released.
+#define BASELINE_HOLD_SCANS 1000
+
+typedef struct {
+    int32_t value; // baseline << BASELINE_FRACTION_BITS
+    uint16_t reference; // baseline when the thresholds were set
+    uint16_t holdScans; // scans left before tracking resumes after a press
+    uint16_t settleScans; // scans left before the baseline has settled
+    bool isTracking;
+} SensorBaseline;
+
+static SensorBaseline baselines[SENSOR_COUNT];
+
+int16_t BASELINE_OFFSETS[SENSOR_COUNT];
+
+void Baseline_Update(const uint16_t* sensorValues, ButtonMask buttonsPressed) {
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        SensorConfig s = PAD_CONF.sensors[i];
+        SensorBaseline* b = &baselines[i];
+
+        if (!(s.flags & BASELINE_TRACKING)) {
+            b->isTracking = false;
+            BASELINE_OFFSETS[i] = 0;
+            continue;
+        }
+
+        uint16_t value = sensorValues[i];
+        int32_t target = (int32_t)value << BASELINE_FRACTION_BITS;
+
+        if (!b->isTracking) {
+            b->isTracking = true;
+            b->value = target;
+            b->holdScans = 0;
+            b->settleScans = BASELINE_SETTLE_SCANS;
+        }
+
+        // Frozen while pressed and above halfway to the release threshold, so slow or light presses are not learned.
+        uint16_t baseline = b->value >> BASELINE_FRACTION_BITS;
+        uint16_t releaseThreshold = Baseline_Apply(s.releaseThreshold, i);
+        bool pressed = s.buttonMapping >= 0 && s.buttonMapping < BUTTON_COUNT && (buttonsPressed & BUTTON_BIT(s.buttonMapping));
+
+        if (pressed || (uint32_t)value * 2 > (uint32_t)baseline + releaseThreshold) {
+            b->holdScans = BASELINE_HOLD_SCANS;
+            continue;
+        }
+
+        if (b->holdScans > 0) {
+            b->holdScans--;
+            continue;
+        }
+
+        if (b->settleScans > 0) {
+            b->value += (target - b->value) >> BASELINE_SETTLE_SHIFT;
+            if (--b->settleScans == 0) {
+                b->reference = b->value >> BASELINE_FRACTION_BITS;
+            }
+            continue;
+        }
+
+        b->value += (target - b->value) >> BASELINE_SHIFT;
+        BASELINE_OFFSETS[i] = (int16_t)((b->value >> BASELINE_FRACTION_BITS) - b->reference);
+    }
+}
+
+void Baseline_Rebase(uint8_t sensor) {
+    SensorBaseline* b = &baselines[sensor];
+
+    // While settling, the reference is taken once it has settled.
+    if (b->isTracking && b->settleScans == 0) {
+        b->reference = b->value >> BASELINE_FRACTION_BITS;
+        BASELINE_OFFSETS[sensor] = 0;
+    }
+}
+
+void Baseline_Read(BaselineState* state) {
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        state->baselines[i] = baselines[i].isTracking ? (uint16_t)(baselines[i].value >> BASELINE_FRACTION_BITS) : 0;
+        state->offsets[i] = BASELINE_OFFSETS[i];
+    }
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _BASELINE_H_
+#define _BASELINE_H_
+
+#include <stdint.h>
+#include "Config/DancePadConfig.h"
+#include "Pad.h"
+
+// Drift compensation. Sensors with the BASELINE_TRACKING flag follow their idle value with a slow fixed point IIR,
+// frozen while the sensor is pressed and for a while after. Their thresholds move along with the baseline, so the
+// distance between a threshold and the baseline stays what it was when the threshold was set (or when the baseline
+// first settled after power on).
+
+typedef struct {
+    uint16_t baselines[SENSOR_COUNT]; // idle value of every sensor, zero for sensors without tracking
+    int16_t offsets[SENSOR_COUNT]; // added to the thresholds, the drift since the thresholds were set
+} __attribute__((packed)) BaselineState;
+
+#if defined(FEATURE_BASELINE_ENABLED)
+    extern int16_t BASELINE_OFFSETS[SENSOR_COUNT];
+
+    // Called by Pad_UpdateState for every scan, with the sensor values just read and the buttons of the previous scan.
+    void Baseline_Update(const uint16_t* sensorValues, ButtonMask buttonsPressed);
+
+    // The threshold of the sensor was set, against the current baseline.
+    void Baseline_Rebase(uint8_t sensor);
+
+    void Baseline_Read(BaselineState* state);
+
+    static inline uint16_t Baseline_Apply(uint16_t threshold, uint8_t sensor) {
+        int32_t adjusted = (int32_t)threshold + BASELINE_OFFSETS[sensor];
+        return adjusted < 0 ? 0 : (adjusted > UINT16_MAX ? UINT16_MAX : (uint16_t)adjusted);
+    }
+#else
+    // the scan calls these for every sensor, make sure they cost nothing when tracking is disabled.
+    #define Baseline_Update(sensorValues, buttonsPressed) ((void)0)
+    #define Baseline_Rebase(sensor) ((void)0)
+    #define Baseline_Apply(threshold, sensor) (threshold)
+#endif
+
+#endif
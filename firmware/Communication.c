@@ -1,28 +1,38 @@
 #include <stdbool.h>
+#include <string.h>
 
 #include "Config/DancePadConfig.h"
 #include "Communication.h"
 #include "Pad.h"
 #include "Lights.h"
+#include "Timer.h"
 
 const char boardType[] = BOARD_TYPE;
 
 void Communication_WriteInputHIDReport(InputHIDReport* report) {
     // first, update pad state
     Pad_UpdateState();
+    const PadState* state = Pad_State();
 
-    // write buttons to the report
-    for (int i = 0; i < BUTTON_COUNT; i++) {
-        // trol https://stackoverflow.com/a/47990
-        report->buttons[i / 8] ^= (-PAD_STATE.buttonsPressed[i] ^ report->buttons[i / 8]) & (1UL << i % 8);
-    }
+    // write buttons to the report, the mask is little endian like the report so it is stored as is
+    memcpy(report->buttons, &state->buttonsPressed, sizeof(report->buttons));
    
     // write sensor values to the report
     for (int i = 0; i < SENSOR_COUNT; i++) {
-        report->sensorValues[i] = PAD_STATE.sensorValues[i];
+        report->sensorValues[i] = state->sensorValues[i];
     }
 }
 
+void Communication_WriteInputExtendedHIDReport(InputExtendedHIDReport* report) {
+    static uint16_t sequence = 0;
+
+    // sample the timestamp before the scan so it matches the moment the sensors were read
+    report->timestamp = Timer_Micros();
+    report->sequence = sequence++;
+
+    Communication_WriteInputHIDReport(&report->input);
+}
+
 void Communication_WriteIdentificationReport(IdentificationFeatureReport* ReportData) {
     ReportData->firmwareVersionMajor = FIRMWARE_VERSION_MAJOR;
     ReportData->firmwareVersionMinor = FIRMWARE_VERSION_MINOR;
@@ -39,9 +49,35 @@ void Communication_WriteIdentificationReport(IdentificationFeatureReport* Report
 void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* ReportData) {
 	Communication_WriteIdentificationReport(&ReportData->parent);
 	
-	ReportData->features = 0;
+	ReportData->features = FEATURE_EXTENDED_INPUT;
+	#if defined(FEATURE_PROFILING_ENABLED)
+		ReportData->features |= FEATURE_PROFILING;
+	#endif
+	#if defined(FEATURE_BASELINE_ENABLED)
+		ReportData->features |= FEATURE_BASELINE;
+	#endif
+	#if defined(FEATURE_JOYSTICK_AXES_ENABLED)
+		ReportData->features |= FEATURE_JOYSTICK_AXES;
+	#endif
+	#if defined(FEATURE_BUTTON_MODES_ENABLED)
+		ReportData->features |= FEATURE_BUTTON_MODES;
+	#endif
+	#if defined(FEATURE_TRANSACTIONS_ENABLED)
+		ReportData->features |= FEATURE_TRANSACTIONS;
+	#endif
+	#if defined(FEATURE_SOF_SYNC_ENABLED)
+		ReportData->features |= FEATURE_SOF_SYNC;
+	#endif
+	#if defined(FEATURE_RAW_ADC_ENABLED)
+		ReportData->features |= FEATURE_RAW_ADC;
+	#endif
+	#if defined(FEATURE_PACKED_INPUT_ENABLED)
+		ReportData->features |= FEATURE_PACKED_INPUT;
+	#endif
+	
 	#if defined(FEATURE_DEBUG_ENABLED)
 		ReportData->features |= FEATURE_DEBUG;
+		ReportData->features |= FEATURE_DEBUG_TRACE;
 	#endif
 	
 	#if defined(FEATURE_DIGIPOT_ENABLED)
@@ -8,6 +8,11 @@
 	#include "ADC.h"
     #include "ConfigStore.h"
 	#include "Debug.h"
+	#include "Profiling.h"
+	#include "Baseline.h"
+	#include "Joystick.h"
+	#include "RawAdc.h"
+	#include "PackedInput.h"
 
     // small helper macro to do x / y, but rounded up instead of floored.
     #define CEILING(x,y) (((x) + (y) - 1) / (y))
@@ -22,6 +27,29 @@
         uint16_t sensorValues[SENSOR_COUNT];
     } __attribute__((packed)) InputHIDReport;
 
+    // Input report sent instead of InputHIDReport once the host selects INPUT_REPORT_FORMAT_EXTENDED,
+    // lets the host detect dropped reports and measure latency.
+    typedef struct {
+        InputHIDReport input;
+        uint16_t sequence; // incremented for every report sent, wraps around
+        uint32_t timestamp; // Timer_Micros() when the sensors were sampled
+    } __attribute__((packed)) InputExtendedHIDReport;
+
+    // Sent instead of the input reports while INPUT_REPORT_FORMAT_RAW_ADC is selected, see RawAdc.h.
+    typedef struct {
+        RawAdcSamples samples;
+    } __attribute__((packed)) RawAdcHIDReport;
+
+    // Sent instead of the input reports while INPUT_REPORT_FORMAT_PACKED is selected, see PackedInput.h.
+    typedef struct {
+        PackedInput input;
+    } __attribute__((packed)) PackedInputHIDReport;
+
+    // Sent instead of an input report when a joystick axis changed, see Joystick.h.
+    typedef struct {
+        JoystickAxes axes;
+    } __attribute__((packed)) JoystickHIDReport;
+
     //
     // FEATURE REPORTS
     // ie. can be requested by computer and written by computer
@@ -50,10 +78,26 @@
         SensorConfig sensor;
     } __attribute__((packed)) SensorHIDReport;
 
+    // Weights of all sensors. Only those of the sensors mapped to the button are taken from a received report.
+    typedef struct {
+        uint8_t index;
+        ButtonConfig button;
+        uint8_t sensorWeights[SENSOR_COUNT];
+    } __attribute__((packed)) ButtonHIDReport;
+
     // IDS used by SetPropertyHIDReport.
     #define SPID_SELECTED_LIGHT_RULE_INDEX  0
     #define SPID_SELECTED_LED_MAPPING_INDEX 1
     #define SPID_SELECTED_SENSOR_INDEX 2
+    #define SPID_INPUT_REPORT_FORMAT 3
+    #define SPID_SELECTED_BUTTON_INDEX 4
+    #define SPID_RAW_ADC_SENSOR 5
+
+    // Values for SPID_INPUT_REPORT_FORMAT. Resets to default when the device is reconfigured by the host.
+    #define INPUT_REPORT_FORMAT_DEFAULT 0
+    #define INPUT_REPORT_FORMAT_EXTENDED 1
+    #define INPUT_REPORT_FORMAT_RAW_ADC 2
+    #define INPUT_REPORT_FORMAT_PACKED 3
 
     typedef struct {
         uint32_t propertyId;
@@ -76,14 +120,41 @@
     } __attribute__((packed)) IdentificationV2FeatureReport;
 	
 	
+	#if defined(FEATURE_PROFILING_ENABLED)
+		typedef struct {
+			ProfilingCounters counters;
+		} __attribute__((packed)) ProfilingHIDReport;
+	#endif
+	
+	#if defined(FEATURE_BASELINE_ENABLED)
+		typedef struct {
+			BaselineState state;
+		} __attribute__((packed)) BaselineHIDReport;
+	#endif
+	
+	#if defined(FEATURE_TRANSACTIONS_ENABLED)
+		// Sensor, button, light rule, LED mapping and pad configuration reports sent after TRANSACTION_BEGIN only
+		// change the stored configuration. The pad and the lights pick them up at TRANSACTION_COMMIT, once instead of
+		// after every report. Feature reports read in between still show the configuration in use. The name is not
+		// part of transactions and reads as last written. The pad commits a transaction by itself after
+		// TRANSACTION_TIMEOUT_MS without a report, or when the host reconnects.
+		#define TRANSACTION_COMMIT 0
+		#define TRANSACTION_BEGIN 1
+		
+		typedef struct {
+			uint8_t action;
+		} __attribute__((packed)) TransactionHIDReport;
+	#endif
+	
 	#if defined(FEATURE_DEBUG_ENABLED)
 		typedef struct {
 			uint16_t messageSize;
-			char messagePacket[32];
+			uint8_t messagePacket[DEBUG_PACKET_SIZE]; // whole debug records, see Debug.h
 		} DebugHIDReport;
 	#endif
 	
     void Communication_WriteInputHIDReport(InputHIDReport* report);
+    void Communication_WriteInputExtendedHIDReport(InputExtendedHIDReport* report);
     void Communication_WriteIdentificationReport(IdentificationFeatureReport* report);
     void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* report);
 #endif
@@ -7,6 +7,44 @@
 	#define FEATURE_DEBUG 1 << 0
 	#define FEATURE_DIGIPOT 1 << 1
 	#define FEATURE_LIGHTS 1 << 2
+	#define FEATURE_DEBUG_TRACE 1 << 3
+	#define FEATURE_EXTENDED_INPUT 1 << 4
+	#define FEATURE_PROFILING 1 << 5
+	#define FEATURE_BASELINE 1 << 6
+	#define FEATURE_JOYSTICK_AXES 1 << 7
+	#define FEATURE_BUTTON_MODES 1 << 8
+	#define FEATURE_TRANSACTIONS 1 << 9
+	#define FEATURE_SOF_SYNC 1 << 10
+	#define FEATURE_RAW_ADC 1 << 11
+	#define FEATURE_PACKED_INPUT 1 << 12
+	
+	// Counters for monitoring the pad, see Profiling.h. They cost two timer reads per scan.
+	#define FEATURE_PROFILING_ENABLED
+	
+	// Baseline tracking for sensors with the BASELINE_TRACKING flag, see Baseline.h. A few additions per sensor and scan.
+	#define FEATURE_BASELINE_ENABLED
+	
+	// Sensors with the JOYSTICK_AXIS flag as joystick axes, see Joystick.h. Costs nothing unless a sensor has the flag.
+	#define FEATURE_JOYSTICK_AXES_ENABLED
+	
+	// Sum, weighted sum and k of n combinations of the sensors of a button, see ButtonModes in Pad.h. Buttons that
+	// keep the default mode are decided like before.
+	#define FEATURE_BUTTON_MODES_ENABLED
+	
+	// Configuration reports between TRANSACTION_BEGIN and TRANSACTION_COMMIT are applied once at the commit, see
+	// TransactionHIDReport.
+	#define FEATURE_TRANSACTIONS_ENABLED
+	
+	// Scans start SOF_SCAN_OFFSET_US after the start of frame, so input reports are a scan old when the host takes
+	// them, see Sampling.h.
+	#define FEATURE_SOF_SYNC_ENABLED
+	
+	// Streaming of raw conversions for diagnosis, see RawAdc.h. Costs nothing until the host selects it.
+	#define FEATURE_RAW_ADC_ENABLED
+	
+	// Input reports with the scans since the previous report, packed in 10 bits, see PackedInput.h. Costs nothing until
+	// the host selects it.
+	#define FEATURE_PACKED_INPUT_ENABLED
 	
 	//#define FEATURE_DEBUG_ENABLED
 	//#define FEATURE_DIGIPOT_ENABLED
@@ -39,6 +77,8 @@
 		#define LED_PANELS 4
 		#define PANEL_LEDS 8
 		
+		#define SOF_SCAN_OFFSET_US 650
+		
 		// Trigger existing exceptions
 		#define BOARD_TYPE_FSRMINIPAD
 	
@@ -51,6 +91,8 @@
 		#define LED_PANELS 4
 		#define PANEL_LEDS 8
 		
+		#define SOF_SCAN_OFFSET_US 700
+		
 	#elif defined(BOARD_TYPE_FSRIO_1)
         #define BOARD_TYPE "fsrio1";
         #define BOOTLOADER_ADDRESS "0x7000"
@@ -60,6 +102,16 @@
 		
 		#define LED_PANELS 8
 		#define PANEL_LEDS 8
+		
+		#define SOF_SCAN_OFFSET_US 450
+
+    #elif defined(BOARD_TYPE_HOST)
+        // Virtual pad on a Linux host, see host/HostUSB.c. No led strip or digipot to drive.
+        #define BOARD_TYPE "uhid";
+        #define BOOTLOADER_ADDRESS "0x0000"
+        
+        // frames are simulated, the input report goes out right after the start of frame
+        #define SOF_SCAN_OFFSET_US 0
 
     #elif defined(BOARD_TYPE_TEENSY2)
     	#define BOARD_TYPE "teensy2";
@@ -75,6 +127,19 @@
 
     #endif
 	
+	// Microseconds from the start of frame to the scan for the next input report, see Sampling.h. The scan should end
+	// shortly before the next frame starts: the frame minus the longest scan of the board and some margin. The
+	// default fits 12 sensors, check maxScanTime of the profiling report when changing a board.
+	#if !defined(SOF_SCAN_OFFSET_US)
+		#define SOF_SCAN_OFFSET_US 250
+	#endif
+	
+	// Milliseconds without a report after which an open transaction is committed by the pad, see TransactionHIDReport.
+	// Hosts send the reports of a transaction right after each other.
+	#if !defined(TRANSACTION_TIMEOUT_MS)
+		#define TRANSACTION_TIMEOUT_MS 1000
+	#endif
+	
 	#if defined(FEATURE_LIGHTS_ENABLED)
 		#define LED_COUNT (LED_PANELS * PANEL_LEDS)
 	#else
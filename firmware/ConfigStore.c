@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <util/atomic.h>
@@ -7,9 +8,17 @@
 #include "Pad.h"
 #include "ConfigStore.h"
 
+// Layout of the stored configuration, bump it whenever Configuration changes and migrate the older layouts in
+// ConfigStore_LoadConfiguration.
+#define LAYOUT_WITHOUT_BUTTONS 9 // ends before the button configuration
+#define LAYOUT_VERSION 10
+
 // just some random bytes to figure out what we have in eeprom
 // change these to reset configuration!
-static const uint8_t magicBytes[5] = {9, 74, 9, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR};
+static const uint8_t magicBytes[5] = {9, 74, LAYOUT_VERSION, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR};
+
+// index of the layout version in magicBytes
+#define LAYOUT_VERSION_INDEX 2
 
 // where magic bytes (which indicate that a pad configuration is, in fact, stored) exist
 #define MAGIC_BYTES_ADDRESS ((void *) 0x00)
@@ -59,6 +68,14 @@ static const uint8_t magicBytes[5] = {9, 74, 9, FIRMWARE_VERSION_MAJOR, FIRMWARE
 	.flags = 0							\
 	}
 
+#define DEFAULT_BUTTON_CONFIG		\
+	{								\
+	.mode = BUTTON_MODE_ANY,		\
+	.count = 2,						\
+	.threshold = 800,				\
+	.releaseThreshold = 800 * 0.95	\
+	}
+
 static const Configuration DEFAULT_CONFIGURATION = {
     .padConfiguration = {
 		.sensors = {	
@@ -123,18 +140,57 @@ static const Configuration DEFAULT_CONFIGURATION = {
 			DEFAULT_LED_MAPPING(0, 7, 7, 8)
 		}
 #endif
+	},
+	.buttonConfiguration = {
+		.buttons = { [0 ... BUTTON_COUNT - 1] = DEFAULT_BUTTON_CONFIG },
+		.sensorWeights = { [0 ... SENSOR_COUNT - 1] = SENSOR_WEIGHT_ONE },
+		.selectedButtonIndex = 0
 	}
 };
 
+bool ConfigStore_IsValidButtonConfig(const ButtonConfig* button) {
+    return button->mode < BUTTON_MODE_COUNT &&
+        button->count <= SENSOR_COUNT &&
+        button->releaseThreshold <= button->threshold;
+}
+
+static bool ConfigStore_IsValidButtonConfiguration(const ButtonConfiguration* conf) {
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        if (!ConfigStore_IsValidButtonConfig(&conf->buttons[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Magic bytes of the given layout version, with the same firmware version.
+static bool ConfigStore_HasMagicBytes(const uint8_t* buffer, uint8_t layoutVersion) {
+    for (uint8_t i = 0; i < sizeof (magicBytes); i++) {
+        uint8_t expected = i == LAYOUT_VERSION_INDEX ? layoutVersion : magicBytes[i];
+        if (buffer[i] != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void ConfigStore_LoadConfiguration(Configuration* conf) {
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
         // see if we have magic bytes stored
         uint8_t magicByteBuffer[sizeof (magicBytes)];
         eeprom_read_block(magicByteBuffer, MAGIC_BYTES_ADDRESS, sizeof (magicBytes));
 
-        if (memcmp(magicByteBuffer, magicBytes, sizeof (magicBytes)) == 0) {
+        if (ConfigStore_HasMagicBytes(magicByteBuffer, LAYOUT_VERSION)) {
             // we had magic bytes, let's load the configuration!
             eeprom_read_block(conf, CONFIGURATION_ADDRESS, sizeof (Configuration));
+
+            if (!ConfigStore_IsValidButtonConfiguration(&conf->buttonConfiguration)) {
+                memcpy(&conf->buttonConfiguration, &DEFAULT_CONFIGURATION.buttonConfiguration, sizeof (ButtonConfiguration));
+            }
+        } else if (ConfigStore_HasMagicBytes(magicByteBuffer, LAYOUT_WITHOUT_BUTTONS)) {
+            // stored before the button configuration existed, keep the rest and start with the default buttons
+            eeprom_read_block(conf, CONFIGURATION_ADDRESS, offsetof(Configuration, buttonConfiguration));
+            memcpy(&conf->buttonConfiguration, &DEFAULT_CONFIGURATION.buttonConfiguration, sizeof (ButtonConfiguration));
         } else {
             // we had some garbage on magic byte address, let's just use the default configuration
             ConfigStore_FactoryDefaults(conf);
@@ -14,9 +14,13 @@
         PadConfigurationV2 padConfiguration;
         NameAndSize nameAndSize;
 		LightConfiguration lightConfiguration;
+		ButtonConfiguration buttonConfiguration; // added by layout 10, see ConfigStore_LoadConfiguration
     } __attribute__((packed)) Configuration;
 	
     void ConfigStore_LoadConfiguration(Configuration* conf);
     void ConfigStore_StoreConfiguration(const Configuration* conf);
     void ConfigStore_FactoryDefaults(Configuration* conf);
+
+    // Whether a button configuration from the host or the EEPROM can be applied.
+    bool ConfigStore_IsValidButtonConfig(const ButtonConfig* button);
 #endif
@@ -1,47 +1,119 @@
+#include <string.h>
+
 #include "Debug.h"
+#include "Timer.h"
 #include "Config/DancePadConfig.h"
 
 #if defined(FEATURE_DEBUG_ENABLED)
 
+// Has to be a power of two, ring positions wrap by masking.
 #define DEBUG_BUFFER_SIZE 128
+#define DEBUG_BUFFER_MASK (DEBUG_BUFFER_SIZE - 1)
+
+// Longest message that still fits a single debug report.
+#define DEBUG_MAX_MESSAGE_LENGTH (DEBUG_PACKET_SIZE - 2)
+
+static uint8_t debugBuffer [DEBUG_BUFFER_SIZE];
+static volatile uint8_t debugHead = 0; // where the next record is written
+static volatile uint8_t debugTail = 0; // where the next record is read
 
-char debugBuffer [DEBUG_BUFFER_SIZE];
-volatile uint16_t debugBufferAvailable = 0;
+static inline uint8_t Debug_Used(void) {
+    return (debugHead - debugTail) & DEBUG_BUFFER_MASK;
+}
+
+static inline uint8_t Debug_Free(void) {
+    // one byte stays unused so a full buffer can be told apart from an empty one
+    return DEBUG_BUFFER_SIZE - 1 - Debug_Used();
+}
 
-void Debug_MoveBuffer(uint16_t position) {
-	debugBufferAvailable -= position;
-	memcpy(debugBuffer, debugBuffer + position, debugBufferAvailable);
+static inline uint8_t Debug_Put(uint8_t position, uint8_t value) {
+    debugBuffer[position] = value;
+    return (position + 1) & DEBUG_BUFFER_MASK;
+}
+
+static inline uint8_t Debug_RecordSize(uint8_t position) {
+    if (debugBuffer[position] == DEBUG_EVENT_MESSAGE) {
+        return 2 + debugBuffer[(position + 1) & DEBUG_BUFFER_MASK];
+    }
+
+    return sizeof(DebugTraceRecord);
+}
+
+void Debug_Trace(uint8_t event, uint16_t arg0, uint16_t arg1) {
+    if (Debug_Free() < sizeof(DebugTraceRecord)) {
+        return;
+    }
+
+    uint16_t timestamp = Timer_Micros();
+    uint8_t head = debugHead;
+
+    head = Debug_Put(head, event);
+    head = Debug_Put(head, timestamp & 0xFF);
+    head = Debug_Put(head, timestamp >> 8);
+    head = Debug_Put(head, arg0 & 0xFF);
+    head = Debug_Put(head, arg0 >> 8);
+    head = Debug_Put(head, arg1 & 0xFF);
+    head = Debug_Put(head, arg1 >> 8);
+
+    debugHead = head;
 }
 
 void Debug_Message(const char* message) {
-	uint16_t freeBufferSpace = DEBUG_BUFFER_SIZE - debugBufferAvailable;
-	uint16_t readLength = strlen(message);
-	if(readLength > freeBufferSpace) {
-		readLength = freeBufferSpace;
-	}
-	
-	memcpy(debugBuffer + debugBufferAvailable, message, readLength);
-	debugBufferAvailable += readLength;
+    uint8_t freeBufferSpace = Debug_Free();
+    if (freeBufferSpace < 2) {
+        return;
+    }
+
+    size_t length = strlen(message);
+    if (length > DEBUG_MAX_MESSAGE_LENGTH) {
+        length = DEBUG_MAX_MESSAGE_LENGTH;
+    }
+    if (length > freeBufferSpace - 2) {
+        length = freeBufferSpace - 2;
+    }
+
+    uint8_t head = debugHead;
+
+    head = Debug_Put(head, DEBUG_EVENT_MESSAGE);
+    head = Debug_Put(head, length);
+    for (uint8_t i = 0; i < length; i++) {
+        head = Debug_Put(head, message[i]);
+    }
+
+    debugHead = head;
 }
 
-void Debug_ReadBuffer(char* target, uint16_t length) {
-	if(length > debugBufferAvailable) {
-		length = debugBufferAvailable;
-	}
-	
-	memcpy(target, debugBuffer, length);
-	Debug_MoveBuffer(length);
+uint16_t Debug_ReadBuffer(uint8_t* target, uint16_t length) {
+    uint8_t tail = debugTail;
+    uint8_t head = debugHead;
+    uint16_t readLength = 0;
+
+    // only whole records are handed out, the host decodes every packet on its own.
+    while (tail != head) {
+        uint8_t recordSize = Debug_RecordSize(tail);
+        if (readLength + recordSize > length) {
+            break;
+        }
+
+        for (uint8_t i = 0; i < recordSize; i++) {
+            target[readLength++] = debugBuffer[tail];
+            tail = (tail + 1) & DEBUG_BUFFER_MASK;
+        }
+    }
+
+    debugTail = tail;
+    return readLength;
 }
 
 uint16_t Debug_Available() {
-	return debugBufferAvailable;
+    return Debug_Used();
 }
 
 #else
 
 void Debug_Init() {;}
 void Debug_Message(const char* message) {;}
-void Debug_ReadBuffer(char* target, uint16_t length) {;}
+uint16_t Debug_ReadBuffer(uint8_t* target, uint16_t length) { return 0; }
 uint16_t Debug_Available() { return 0; }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,9 +2,36 @@
 #define _DEBUG_H_
 
 #include <stdint.h>
+#include "Config/DancePadConfig.h"
+
+// Size of the packet carried by a single debug report.
+#define DEBUG_PACKET_SIZE 32
+
+// Every record in the debug buffer starts with one of these ids. Trace records are a fixed size
+// DebugTraceRecord, a message record is followed by a length byte and that many characters.
+enum DebugEvent
+{
+    DEBUG_EVENT_PRESS     = 0x01, // args: button index, sensor value that caused the press
+    DEBUG_EVENT_RELEASE   = 0x02, // args: button index, unused
+    DEBUG_EVENT_SCAN_TIME = 0x03, // args: last scan duration, max scan duration since previous record (us)
+    DEBUG_EVENT_MESSAGE   = 0xFF
+};
+
+typedef struct {
+    uint8_t event;
+    uint16_t timestamp; // lower 16 bits of Timer_Micros()
+    uint16_t args[2];
+} __attribute__((packed)) DebugTraceRecord;
+
+#if defined(FEATURE_DEBUG_ENABLED)
+    void Debug_Trace(uint8_t event, uint16_t arg0, uint16_t arg1);
+#else
+    // tracing sits in hot paths, make sure it costs nothing when debugging is disabled.
+    #define Debug_Trace(event, arg0, arg1) ((void)0)
+#endif
 
 void Debug_Message(const char* message);
-void Debug_ReadBuffer(char* target, uint16_t length);
+uint16_t Debug_ReadBuffer(uint8_t* target, uint16_t length);
 uint16_t Debug_Available();
 
-#endif
\ No newline at end of file
+#endif
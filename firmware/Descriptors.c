@@ -60,6 +60,28 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
             HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
         HID_RI_END_COLLECTION(0),
 
+        // same buttons as the regular input report so games keep working while the
+        // configuration tool has the extended report enabled.
+        HID_RI_REPORT_ID(8, INPUT_EXTENDED_REPORT_ID),
+        HID_RI_USAGE_PAGE(8, 0x09),
+        HID_RI_USAGE_MINIMUM(8, 0x01),
+        HID_RI_USAGE_MAXIMUM(8, BUTTON_COUNT),
+        HID_RI_LOGICAL_MINIMUM(8, 0x00),
+        HID_RI_LOGICAL_MAXIMUM(8, 0x01),
+        HID_RI_REPORT_SIZE(8, 0x01),
+        HID_RI_REPORT_COUNT(8, BUTTON_COUNT),
+        HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+        HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+        HID_RI_USAGE(8, 0x01),
+        HID_RI_COLLECTION(8, 0x00),
+            HID_RI_USAGE(8, 0x01),
+            HID_RI_LOGICAL_MINIMUM(8, 0x00),
+            HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+            HID_RI_REPORT_SIZE(8, 0x08),
+            HID_RI_REPORT_COUNT(8, sizeof (InputExtendedHIDReport) - CEILING(BUTTON_COUNT, 8)),
+            HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+        HID_RI_END_COLLECTION(0),
+
         HID_RI_REPORT_ID(8, PAD_CONFIGURATION_REPORT_ID),
         HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
         HID_RI_USAGE(8, 0x02),
@@ -96,10 +118,28 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
             HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
         HID_RI_END_COLLECTION(0),
 
+#if defined(FEATURE_JOYSTICK_AXES_ENABLED)
+        // sensors as joystick axes, see Joystick.h. stepmania on linux also needs
+        // an analog axis to use the new joystick interface.
+        HID_RI_REPORT_ID(8, ANALOG_JOYSTICK_REPORT_ID),
+        HID_RI_USAGE_PAGE(8, 0x01),
+        HID_RI_USAGE(8, 0x04),
+        HID_RI_COLLECTION(8, 0x00),
+            HID_RI_USAGE_MINIMUM(8, 0x30), // X axis
+            HID_RI_USAGE_MAXIMUM(8, 0x30 + JOYSTICK_AXIS_COUNT - 1), // up to the dial
+            HID_RI_LOGICAL_MINIMUM(16, 0),
+            HID_RI_LOGICAL_MAXIMUM(16, 255),
+            HID_RI_PHYSICAL_MINIMUM(16, 0),
+            HID_RI_PHYSICAL_MAXIMUM(16, 255),
+            HID_RI_REPORT_COUNT(8, JOYSTICK_AXIS_COUNT),
+            HID_RI_REPORT_SIZE(8, 8),
+            HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+        HID_RI_END_COLLECTION(0),
+#else
         // unused joystick report. we only report this because stepmania uses
         // old joystick interface on linux if device doesn't have any analog
         // axis.
-        HID_RI_REPORT_ID(8, UNUSED_ANALOG_JOYSTICK_REPORT_ID),
+        HID_RI_REPORT_ID(8, ANALOG_JOYSTICK_REPORT_ID),
         HID_RI_USAGE_PAGE(8, 0x01),
         HID_RI_USAGE(8, 0x04),
         HID_RI_COLLECTION(8, 0x00),
@@ -112,6 +152,7 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
             HID_RI_REPORT_SIZE(8, 8),
             HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
         HID_RI_END_COLLECTION(0),
+#endif
 
         HID_RI_REPORT_ID(8, LIGHT_RULE_REPORT_ID),
         HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
@@ -203,6 +244,100 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
 			HID_RI_REPORT_COUNT(8, sizeof(IdentificationV2FeatureReport)),
 			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
 		HID_RI_END_COLLECTION(0),
+		
+		#if defined(FEATURE_PROFILING_ENABLED)
+			HID_RI_REPORT_ID(8, PROFILING_REPORT_ID),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x02),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(ProfilingHIDReport)),
+				HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+			HID_RI_END_COLLECTION(0),
+		#endif
+		
+		#if defined(FEATURE_BASELINE_ENABLED)
+			HID_RI_REPORT_ID(8, BASELINE_REPORT_ID),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x02),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(BaselineHIDReport)),
+				HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+			HID_RI_END_COLLECTION(0),
+		#endif
+		
+		#if defined(FEATURE_BUTTON_MODES_ENABLED)
+			HID_RI_REPORT_ID(8, BUTTON_REPORT_ID),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x02),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(ButtonHIDReport)),
+				HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+			HID_RI_END_COLLECTION(0),
+		#endif
+		
+		#if defined(FEATURE_TRANSACTIONS_ENABLED)
+			HID_RI_REPORT_ID(8, TRANSACTION_REPORT_ID),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x02),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(TransactionHIDReport)),
+				HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+			HID_RI_END_COLLECTION(0),
+		#endif
+		
+		#if defined(FEATURE_RAW_ADC_ENABLED)
+			HID_RI_REPORT_ID(8, RAW_ADC_REPORT_ID),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x01),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x01),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(RawAdcHIDReport)),
+				HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+			HID_RI_END_COLLECTION(0),
+		#endif
+		
+		#if defined(FEATURE_PACKED_INPUT_ENABLED)
+			// same buttons as the regular input report, of the newest scan, so games keep working while the
+			// configuration tool has the packed report enabled.
+			HID_RI_REPORT_ID(8, PACKED_INPUT_REPORT_ID),
+			HID_RI_USAGE_PAGE(8, 0x09),
+			HID_RI_USAGE_MINIMUM(8, 0x01),
+			HID_RI_USAGE_MAXIMUM(8, BUTTON_COUNT),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0x01),
+			HID_RI_REPORT_SIZE(8, 0x01),
+			HID_RI_REPORT_COUNT(8, BUTTON_COUNT),
+			HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+			HID_RI_USAGE(8, 0x01),
+			HID_RI_COLLECTION(8, 0x00),
+				HID_RI_USAGE(8, 0x01),
+				HID_RI_LOGICAL_MINIMUM(8, 0x00),
+				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+				HID_RI_REPORT_SIZE(8, 0x08),
+				HID_RI_REPORT_COUNT(8, sizeof(PackedInputHIDReport) - CEILING(BUTTON_COUNT, 8)),
+				HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+			HID_RI_END_COLLECTION(0),
+		#endif
 
     HID_RI_END_COLLECTION(0)
 };
@@ -74,7 +74,7 @@
         #define RESET_REPORT_ID                  0x3
         #define SAVE_CONFIGURATION_REPORT_ID     0x4
         #define NAME_REPORT_ID                   0x5
-        #define UNUSED_ANALOG_JOYSTICK_REPORT_ID 0x6
+        #define ANALOG_JOYSTICK_REPORT_ID        0x6
         #define LIGHT_RULE_REPORT_ID             0x7
         #define FACTORY_RESET_REPORT_ID          0x8
         #define IDENTIFICATION_REPORT_ID         0x9
@@ -87,6 +87,31 @@
 		#endif
 		
 		#define IDENTIFICATION_V2_REPORT_ID      0xE
+		#define INPUT_EXTENDED_REPORT_ID         0xF
+		
+		#if defined(FEATURE_PROFILING_ENABLED)
+			#define PROFILING_REPORT_ID          0x10
+		#endif
+		
+		#if defined(FEATURE_BASELINE_ENABLED)
+			#define BASELINE_REPORT_ID           0x11
+		#endif
+		
+		#if defined(FEATURE_BUTTON_MODES_ENABLED)
+			#define BUTTON_REPORT_ID             0x12
+		#endif
+		
+		#if defined(FEATURE_TRANSACTIONS_ENABLED)
+			#define TRANSACTION_REPORT_ID        0x13
+		#endif
+		
+		#if defined(FEATURE_RAW_ADC_ENABLED)
+			#define RAW_ADC_REPORT_ID            0x14
+		#endif
+		
+		#if defined(FEATURE_PACKED_INPUT_ENABLED)
+			#define PACKED_INPUT_REPORT_ID       0x15
+		#endif
 
     /* Macros: */
         /** Endpoint address of the Generic HID reporting IN endpoint. */
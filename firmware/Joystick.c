@@ -0,0 +1,121 @@
+#include <stdbool.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "Joystick.h"
+#include "Pad.h"
+#include "Baseline.h"
+
+#if defined(FEATURE_JOYSTICK_AXES_ENABLED)
+
+// Input reports between joystick reports at least, 4 ms at 1000 reports per second.
+#define JOYSTICK_REPORT_INTERVAL 4
+
+// The curves have 17 points, the sensor range is split in 16 segments of 64 and interpolated in between.
+#define JOYSTICK_CURVE_POINTS 17
+#define JOYSTICK_SEGMENT_SHIFT 6
+#define JOYSTICK_SEGMENT_MASK ((1 << JOYSTICK_SEGMENT_SHIFT) - 1)
+#define JOYSTICK_CURVE_COUNT 4
+
+// The range above the release threshold is scaled to the curve with 8 fraction bits. A release threshold close to
+// MAX_SENSOR_VALUE still leaves this much range, so the scale fits 16 bits.
+#define JOYSTICK_MIN_RANGE 64
+
+static const uint8_t CURVES[JOYSTICK_CURVE_COUNT][JOYSTICK_CURVE_POINTS] PROGMEM = {
+    [JOYSTICK_CURVE_LINEAR] = { 0, 16, 32, 48, 64, 80, 96, 112, 128, 143, 159, 175, 191, 207, 223, 239, 255 },
+    [JOYSTICK_CURVE_SOFT] = { 0, 64, 90, 110, 128, 143, 156, 169, 180, 191, 202, 211, 221, 230, 239, 247, 255 },
+    [JOYSTICK_CURVE_HARD] = { 0, 1, 4, 9, 16, 25, 36, 49, 64, 81, 100, 121, 143, 168, 195, 224, 255 },
+    [JOYSTICK_CURVE_S] = { 0, 3, 11, 24, 40, 59, 81, 104, 128, 151, 174, 196, 215, 231, 244, 252, 255 }
+};
+
+typedef struct {
+    uint16_t scale; // (MAX_SENSOR_VALUE << 8) / range above the release threshold
+    uint8_t axis;
+    uint8_t curve;
+} SensorAxis;
+
+static SensorAxis sensorAxes[SENSOR_COUNT];
+static bool hasAxes = false;
+
+static uint8_t reportsSinceJoystick = 0;
+static JoystickAxes nextAxes;
+static JoystickAxes sentAxes;
+
+void Joystick_UpdateConfiguration(void) {
+    hasAxes = false;
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        SensorConfig s = PAD_CONF.sensors[i];
+        SensorAxis* a = &sensorAxes[i];
+
+        a->axis = (s.flags & JOYSTICK_AXIS) ? (s.flags & JOYSTICK_AXIS_MASK) >> JOYSTICK_AXIS_SHIFT : 0xFF;
+        a->curve = (s.flags & JOYSTICK_CURVE_MASK) >> JOYSTICK_CURVE_SHIFT;
+
+        uint16_t range = s.releaseThreshold < MAX_SENSOR_VALUE - JOYSTICK_MIN_RANGE
+            ? MAX_SENSOR_VALUE - s.releaseThreshold
+            : JOYSTICK_MIN_RANGE;
+        a->scale = ((uint32_t)MAX_SENSOR_VALUE << 8) / range;
+
+        hasAxes |= (a->axis != 0xFF);
+    }
+
+    // axes no longer driven by a sensor go back to zero with the next report
+    memset(&nextAxes, 0, sizeof(nextAxes));
+}
+
+static uint8_t Joystick_ApplyCurve(uint8_t curve, uint16_t x) {
+    uint8_t segment = x >> JOYSTICK_SEGMENT_SHIFT;
+    uint8_t low = pgm_read_byte(&CURVES[curve][segment]);
+    uint8_t high = pgm_read_byte(&CURVES[curve][segment + 1]);
+    return low + (((int16_t)(high - low) * (x & JOYSTICK_SEGMENT_MASK)) >> JOYSTICK_SEGMENT_SHIFT);
+}
+
+static void Joystick_UpdateAxes(void) {
+    const PadState* state = Pad_State();
+    memset(&nextAxes, 0, sizeof(nextAxes));
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        const SensorAxis* a = &sensorAxes[i];
+        if (a->axis == 0xFF) {
+            continue;
+        }
+
+        uint16_t value = state->sensorValues[i];
+        uint16_t low = Baseline_Apply(PAD_CONF.sensors[i].releaseThreshold, i);
+        if (value <= low) {
+            continue;
+        }
+
+        uint32_t x = ((uint32_t)(value - low) * a->scale) >> 8;
+        uint8_t axisValue = Joystick_ApplyCurve(a->curve, x < MAX_SENSOR_VALUE ? x : MAX_SENSOR_VALUE - 1);
+        if (axisValue > nextAxes.axes[a->axis]) {
+            nextAxes.axes[a->axis] = axisValue;
+        }
+    }
+}
+
+bool Joystick_IsReportDue(void) {
+    if (!hasAxes && memcmp(&nextAxes, &sentAxes, sizeof(JoystickAxes)) == 0) {
+        return false;
+    }
+
+    if (reportsSinceJoystick < JOYSTICK_REPORT_INTERVAL) {
+        reportsSinceJoystick++;
+        return false;
+    }
+
+    // axes come from the previous scan, the input report that is skipped would have scanned again
+    if (hasAxes) {
+        Joystick_UpdateAxes();
+    }
+
+    return memcmp(&nextAxes, &sentAxes, sizeof(JoystickAxes)) != 0;
+}
+
+void Joystick_Write(JoystickAxes* axes) {
+    memcpy(axes, &nextAxes, sizeof(JoystickAxes));
+    memcpy(&sentAxes, &nextAxes, sizeof(JoystickAxes));
+    reportsSinceJoystick = 0;
+}
+
+#endif
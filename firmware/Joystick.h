@@ -0,0 +1,49 @@
+#ifndef _JOYSTICK_H_
+#define _JOYSTICK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Config/DancePadConfig.h"
+
+// Sensors as joystick axes, so games that read pressure can use the OS joystick API. A sensor with the JOYSTICK_AXIS
+// flag drives the axis in its flags, through one of the response curves below. The axis is zero up to the release
+// threshold of the sensor and reaches its maximum at MAX_SENSOR_VALUE. Sensors on the same axis give their maximum.
+//
+// The axes go out in their own report, ANALOG_JOYSTICK_REPORT_ID, which takes the place of an input report. To
+// keep the button latency of the input reports, that happens at most every JOYSTICK_REPORT_INTERVAL reports and only
+// when an axis changed. Nothing changes for pads without axes configured.
+
+// X, Y, Z, Rx, Ry, Rz, slider and dial.
+#define JOYSTICK_AXIS_COUNT 8
+
+// Response curves, stored in PROGMEM.
+#define JOYSTICK_CURVE_LINEAR 0
+#define JOYSTICK_CURVE_SOFT 1 // square root, most of the range goes to light presses
+#define JOYSTICK_CURVE_HARD 2 // square, most of the range goes to hard presses
+#define JOYSTICK_CURVE_S 3 // smoothstep, flat at both ends
+
+// Axis and curve of a sensor in SensorConfig.flags.
+#define JOYSTICK_AXIS_SHIFT 8
+#define JOYSTICK_AXIS_MASK (0x7 << JOYSTICK_AXIS_SHIFT)
+#define JOYSTICK_CURVE_SHIFT 12
+#define JOYSTICK_CURVE_MASK (0x3 << JOYSTICK_CURVE_SHIFT)
+
+typedef struct {
+    uint8_t axes[JOYSTICK_AXIS_COUNT];
+} __attribute__((packed)) JoystickAxes;
+
+#if defined(FEATURE_JOYSTICK_AXES_ENABLED)
+    // Called by Pad_UpdateConfiguration.
+    void Joystick_UpdateConfiguration(void);
+
+    // Called for every input report, true if the joystick report should go out instead.
+    bool Joystick_IsReportDue(void);
+
+    // Writes the axes that made Joystick_IsReportDue return true.
+    void Joystick_Write(JoystickAxes* axes);
+#else
+    #define Joystick_UpdateConfiguration() ((void)0)
+    #define Joystick_IsReportDue() (false)
+#endif
+
+#endif
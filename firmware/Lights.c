@@ -115,6 +115,7 @@ void Lights_Update(bool force)
 	
 	updateWait = UPDATE_WAIT_CYCLES;
 	bool update = false;
+	const PadState* state = Pad_State();
 	
 	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
 	{
@@ -131,7 +132,7 @@ void Lights_Update(bool force)
 		update = true;
 		
 		SensorConfig s = PAD_CONF.sensors[mapping->sensorIndex];
-		uint16_t sensorValue = PAD_STATE.sensorValues[mapping->sensorIndex];
+		uint16_t sensorValue = state->sensorValues[mapping->sensorIndex];
 		uint16_t sensorThreshold = s.threshold;
 		
 		bool sensorState = sensorValue > sensorThreshold;
@@ -0,0 +1,101 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "PackedInput.h"
+#include "Pad.h"
+#include "Timer.h"
+
+#if defined(FEATURE_PACKED_INPUT_ENABLED)
+
+#define PACKED_INPUT_MAX_VALUE 0x3FF
+
+// The last scan of a report has to be at most this long after the first one to have its time.
+#define PACKED_INPUT_MAX_TIME_US (UINT8_MAX * PACKED_INPUT_TIME_UNIT_US)
+
+#if PACKED_INPUT_MAX_SCANS < 1
+    #error "A scan has to fit a packed input report"
+#endif
+
+static bool isActive = false;
+static uint16_t sequence = 0;
+static uint32_t lastScan = 0;
+static PackedInput pending;
+
+void PackedInput_SetActive(bool active) {
+    isActive = active;
+    memset(&pending, 0, sizeof(pending));
+}
+
+static void PackedInput_Pack(uint8_t* values, uint8_t index, uint16_t value) {
+    if (value > PACKED_INPUT_MAX_VALUE) {
+        value = PACKED_INPUT_MAX_VALUE;
+    }
+
+    // values start at an even bit, so every value spans exactly two bytes
+    uint16_t bit = index * 10;
+    uint8_t shift = bit & 7;
+    uint8_t* bytes = &values[bit >> 3];
+
+    bytes[0] |= (uint8_t)(value << shift);
+    bytes[1] |= (uint8_t)(value >> (8 - shift));
+}
+
+// Drops the first scan, the second one becomes the first and the times are rebased on it.
+static void PackedInput_DropOldest(void) {
+    uint8_t shift = pending.count > 1 ? pending.scans[1].time : 0;
+
+    pending.count--;
+    memmove(&pending.scans[0], &pending.scans[1], pending.count * sizeof(PackedScan));
+    memset(&pending.scans[pending.count], 0, sizeof(PackedScan));
+
+    pending.timestamp += (uint32_t)shift * PACKED_INPUT_TIME_UNIT_US;
+    for (uint8_t i = 0; i < pending.count; i++) {
+        pending.scans[i].time -= shift;
+    }
+}
+
+void PackedInput_Task(void) {
+    if (!isActive) {
+        return;
+    }
+
+    uint32_t now = Timer_Micros();
+    if (now - lastScan < PACKED_INPUT_SCAN_INTERVAL_US) {
+        return;
+    }
+
+    // the host did not take the report yet, the newest scans are the ones it wants
+    while (pending.count == PACKED_INPUT_MAX_SCANS ||
+           (pending.count > 0 && now - pending.timestamp > PACKED_INPUT_MAX_TIME_US)) {
+        PackedInput_DropOldest();
+    }
+
+    if (pending.count == 0) {
+        pending.timestamp = now;
+    }
+
+    lastScan = now;
+    Pad_UpdateState();
+    const PadState* state = Pad_State();
+
+    PackedScan* scan = &pending.scans[pending.count++];
+    scan->time = (now - pending.timestamp) / PACKED_INPUT_TIME_UNIT_US;
+    memcpy(scan->buttons, &state->buttonsPressed, sizeof(scan->buttons));
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        PackedInput_Pack(scan->sensorValues, i, state->sensorValues[i]);
+    }
+}
+
+bool PackedInput_Write(PackedInput* input) {
+    if (pending.count == 0) {
+        return false;
+    }
+
+    memcpy(pending.buttons, pending.scans[pending.count - 1].buttons, sizeof(pending.buttons));
+    pending.sequence = sequence++;
+    memcpy(input, &pending, sizeof(PackedInput));
+    memset(&pending, 0, sizeof(pending));
+    return true;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef _PACKED_INPUT_H_
+#define _PACKED_INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Config/DancePadConfig.h"
+#include "Descriptors.h"
+#include "Sampling.h"
+
+// Input reports with several scans. While the host has INPUT_REPORT_FORMAT_PACKED selected, the main loop scans every
+// PACKED_INPUT_SCAN_INTERVAL_US instead of once per input report, and the next PACKED_INPUT_REPORT_ID report carries
+// the scans since the previous one, each with its buttons, its sensor values packed in 10 bits and its time relative
+// to the first scan. That gives the host the scan rate of the pad at the poll rate of USB. The report starts with the
+// buttons of the newest scan, declared as buttons like in the input report, so games keep working while the
+// configuration tool has the packed report enabled.
+//
+// The report keeps the newest scans: when it is full, or its first scan is too old to give the time of the next, the
+// oldest scan makes room. So the scans keep going until the host takes the report and the last one is at most a scan
+// interval old, which keeps the start of frame alignment of FEATURE_SOF_SYNC. Everything that runs per scan, like
+// baseline tracking, runs at the scan rate meanwhile.
+
+#define PACKED_INPUT_BUTTONS_SIZE ((BUTTON_COUNT + 7) / 8)
+#define PACKED_INPUT_VALUES_SIZE ((SENSOR_COUNT * 10 + 7) / 8)
+
+// Unit of the scan times, a byte covers a millisecond.
+#define PACKED_INPUT_TIME_UNIT_US 4
+
+// Scans that fit a report of GENERIC_EPSIZE after the report id, the buttons and the header.
+#define PACKED_INPUT_MAX_SCANS \
+    ((GENERIC_EPSIZE - 1 - PACKED_INPUT_BUTTONS_SIZE - 7) / (PACKED_INPUT_BUTTONS_SIZE + 1 + PACKED_INPUT_VALUES_SIZE))
+
+// Microseconds between the scans, a board can set its own in DancePadConfig.h. The default spreads the scans of a
+// report over a frame, so reports polled every frame cover it without gaps. Scans that take longer follow each other
+// without a pause.
+#if !defined(PACKED_INPUT_SCAN_INTERVAL_US)
+    #define PACKED_INPUT_SCAN_INTERVAL_US (FRAME_US / PACKED_INPUT_MAX_SCANS)
+#endif
+
+typedef struct {
+    uint8_t buttons[PACKED_INPUT_BUTTONS_SIZE]; // like the buttons of the input report
+    uint8_t time; // since the first scan of the report, in PACKED_INPUT_TIME_UNIT_US
+    uint8_t sensorValues[PACKED_INPUT_VALUES_SIZE]; // 10 bits each, least significant bit first
+} __attribute__((packed)) PackedScan;
+
+typedef struct {
+    uint8_t buttons[PACKED_INPUT_BUTTONS_SIZE]; // of the newest scan, like the buttons of the input report
+    uint16_t sequence; // incremented for every report sent, wraps around
+    uint32_t timestamp; // Timer_Micros() at the first scan
+    uint8_t count; // scans used, the others are zero
+    PackedScan scans[PACKED_INPUT_MAX_SCANS];
+} __attribute__((packed)) PackedInput;
+
+#if defined(FEATURE_PACKED_INPUT_ENABLED)
+    // Called when the input report format changes, starts with an empty report.
+    void PackedInput_SetActive(bool active);
+
+    // Called from the main loop, scans while the format is selected and the interval passed.
+    void PackedInput_Task(void);
+
+    // Writes the scans since the previous report, returns false if there are none yet.
+    bool PackedInput_Write(PackedInput* input);
+#else
+    #define PackedInput_SetActive(active) ((void)0)
+    #define PackedInput_Task() ((void)0)
+#endif
+
+#endif
@@ -4,49 +4,97 @@
 #include "Config/DancePadConfig.h"
 #include "ConfigStore.h"
 #include "Pad.h"
+#include "PadDecision.h"
 #include "ADC.h"
 #include "Lights.h"
+#include "Debug.h"
+#include "Timer.h"
+#include "Profiling.h"
+#include "Sampling.h"
+#include "Baseline.h"
+#include "Joystick.h"
 
 #define MIN(a,b) ((a) < (b) ? a : b)
 
 PadConfigurationV2 PAD_CONF;
+ButtonConfiguration BUTTON_CONF;
 
-PadState PAD_STATE = { 
-    .sensorValues = { [0 ... SENSOR_COUNT - 1] = 0 },
-    .buttonsPressed = { [0 ... BUTTON_COUNT - 1] = false }
-};
+PadState PAD_STATES[2];
+volatile uint8_t PAD_STATE_INDEX = 0;
 
 typedef struct {
     uint16_t sensorReleaseThresholds[SENSOR_COUNT];
-    int8_t buttonToSensorMap[BUTTON_COUNT][SENSOR_COUNT + 1];
+    SensorMask buttonToSensors[BUTTON_COUNT];
+    ButtonMask sensorToButton[SENSOR_COUNT]; // zero for unmapped sensors
+#if defined(FEATURE_BUTTON_MODES_ENABLED)
+    ButtonMask sumButtons; // BUTTON_MODE_SUM and BUTTON_MODE_WEIGHTED_SUM
+    ButtonMask kOfNButtons;
+    // Weight of every sensor in the sum of its button, SENSOR_WEIGHT_ONE unless the button uses BUTTON_MODE_WEIGHTED_SUM.
+    uint8_t sensorWeights[SENSOR_COUNT];
+#endif
 } InternalPadConfiguration;
 
 InternalPadConfiguration INTERNAL_PAD_CONF;
 
-void Pad_UpdateInternalConfiguration(void) {
-	/*
-    for (int i = 0; i < SENSOR_COUNT; i++) {
-        INTERNAL_PAD_CONF.sensorReleaseThresholds[i] = PAD_CONF.sensorThresholds[i] * PAD_CONF.releaseMultiplier;
+#if defined(FEATURE_DEBUG_ENABLED)
+// Scan durations are traced in batches, tracing every scan would flood the debug buffer.
+#define SCAN_TRACE_INTERVAL 1024
+
+static uint16_t scansSinceTrace = 0;
+static uint16_t maxScanTime = 0;
+
+static void Pad_TraceScanTime(uint16_t scanTime) {
+    if (scanTime > maxScanTime) {
+        maxScanTime = scanTime;
     }
-	*/
-
-    // Precalculate array for mapping buttons to sensors.
-    // For every button, there is an array of sensor indices. when there are no more buttons assigned to that sensor,
-    // the value is -1.
-    for (int buttonIndex = 0; buttonIndex < BUTTON_COUNT; buttonIndex++) {
-        int mapIndex = 0;
-
-        for (int sensorIndex = 0; sensorIndex < SENSOR_COUNT; sensorIndex++) {
-			SensorConfig s = PAD_CONF.sensors[sensorIndex];
-			
-            if (s.buttonMapping == buttonIndex) {
-                INTERNAL_PAD_CONF.buttonToSensorMap[buttonIndex][mapIndex++] = sensorIndex;
-            }
+
+    if (++scansSinceTrace >= SCAN_TRACE_INTERVAL) {
+        Debug_Trace(DEBUG_EVENT_SCAN_TIME, scanTime, maxScanTime);
+        scansSinceTrace = 0;
+        maxScanTime = 0;
+    }
+}
+#endif
+
+void Pad_UpdateInternalConfiguration(void) {
+    // Precalculate the masks mapping buttons to sensors and back, so a scan evaluates all buttons with a few bitwise
+    // operations per sensor.
+    memset(INTERNAL_PAD_CONF.buttonToSensors, 0, sizeof(INTERNAL_PAD_CONF.buttonToSensors));
+
+    for (uint8_t sensorIndex = 0; sensorIndex < SENSOR_COUNT; sensorIndex++) {
+        int8_t buttonIndex = PAD_CONF.sensors[sensorIndex].buttonMapping;
+
+        if (buttonIndex < 0 || buttonIndex >= BUTTON_COUNT) {
+            INTERNAL_PAD_CONF.sensorToButton[sensorIndex] = 0;
+            continue;
         }
 
-        // mark -1 to end
-        INTERNAL_PAD_CONF.buttonToSensorMap[buttonIndex][mapIndex] = -1;
+        INTERNAL_PAD_CONF.buttonToSensors[buttonIndex] |= SENSOR_BIT(sensorIndex);
+        INTERNAL_PAD_CONF.sensorToButton[sensorIndex] = BUTTON_BIT(buttonIndex);
+
+#if defined(FEATURE_BUTTON_MODES_ENABLED)
+        INTERNAL_PAD_CONF.sensorWeights[sensorIndex] = BUTTON_CONF.buttons[buttonIndex].mode == BUTTON_MODE_WEIGHTED_SUM
+            ? BUTTON_CONF.sensorWeights[sensorIndex]
+            : SENSOR_WEIGHT_ONE;
+#endif
     }
+
+#if defined(FEATURE_BUTTON_MODES_ENABLED)
+    INTERNAL_PAD_CONF.sumButtons = 0;
+    INTERNAL_PAD_CONF.kOfNButtons = 0;
+
+    for (uint8_t buttonIndex = 0; buttonIndex < BUTTON_COUNT; buttonIndex++) {
+        uint8_t mode = BUTTON_CONF.buttons[buttonIndex].mode;
+
+        if (mode == BUTTON_MODE_SUM || mode == BUTTON_MODE_WEIGHTED_SUM) {
+            INTERNAL_PAD_CONF.sumButtons |= BUTTON_BIT(buttonIndex);
+        } else if (mode == BUTTON_MODE_K_OF_N) {
+            INTERNAL_PAD_CONF.kOfNButtons |= BUTTON_BIT(buttonIndex);
+        }
+    }
+#endif
+
+    Joystick_UpdateConfiguration();
 }
 
 void Pad_Initialize(const PadConfigurationV2* padConfiguration) {
@@ -55,47 +103,192 @@ void Pad_Initialize(const PadConfigurationV2* padConfiguration) {
 }
 
 void Pad_UpdateConfiguration(const PadConfigurationV2* padConfiguration) {
+#if defined(FEATURE_BASELINE_ENABLED)
+    // New thresholds are set against the current baseline.
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        const SensorConfig* s = &padConfiguration->sensors[i];
+        if (s->threshold != PAD_CONF.sensors[i].threshold || s->releaseThreshold != PAD_CONF.sensors[i].releaseThreshold) {
+            Baseline_Rebase(i);
+        }
+    }
+#endif
+
     memcpy(&PAD_CONF, padConfiguration, sizeof (PadConfigurationV2));
     Pad_UpdateInternalConfiguration();
 }
 
+void Pad_UpdateButtonConfiguration(const ButtonConfiguration* buttonConfiguration) {
+    memcpy(&BUTTON_CONF, buttonConfiguration, sizeof (ButtonConfiguration));
+    Pad_UpdateInternalConfiguration();
+}
+
+#if defined(FEATURE_DEBUG_ENABLED) || defined(FEATURE_PROFILING_ENABLED)
+    #define PAD_TIME_SCANS
+#endif
+
+#if defined(FEATURE_BUTTON_MODES_ENABLED)
+static uint16_t Pad_Clamp(int32_t value) {
+    return value < 0 ? 0 : (value > UINT16_MAX ? UINT16_MAX : (uint16_t)value);
+}
+
+// BUTTON_MODE_SUM and BUTTON_MODE_WEIGHTED_SUM. The thresholds of the button move with the weighted baseline offsets
+// of its sensors.
+static bool Pad_IsSumPressed(uint8_t button, const PadState* previous, const PadState* next) {
+    const ButtonConfig* b = &BUTTON_CONF.buttons[button];
+    SensorMask sensors = INTERNAL_PAD_CONF.buttonToSensors[button];
+    uint32_t sum = 0;
+    int32_t offset = 0;
+
+    for (uint8_t i = 0; sensors != 0; i++, sensors >>= 1) {
+        if (!(sensors & 1)) {
+            continue;
+        }
+
+        uint8_t weight = INTERNAL_PAD_CONF.sensorWeights[i];
+        sum += (uint32_t)next->sensorValues[i] * weight;
+    #if defined(FEATURE_BASELINE_ENABLED)
+        offset += (int32_t)BASELINE_OFFSETS[i] * weight;
+    #endif
+    }
+
+    offset >>= SENSOR_WEIGHT_SHIFT;
+
+    return Pad_IsSensorPressed(previous->buttonsPressed & BUTTON_BIT(button), Pad_Clamp(sum >> SENSOR_WEIGHT_SHIFT),
+        Pad_Clamp((int32_t)b->threshold + offset), Pad_Clamp((int32_t)b->releaseThreshold + offset));
+}
+
+// BUTTON_MODE_K_OF_N, counts the sensors of the button that hold it on their own.
+static bool Pad_IsKOfNPressed(uint8_t button, SensorMask sensorsHolding) {
+    uint8_t needed = BUTTON_CONF.buttons[button].count > 0 ? BUTTON_CONF.buttons[button].count : 1;
+    SensorMask holding = sensorsHolding & INTERNAL_PAD_CONF.buttonToSensors[button];
+
+    for (uint8_t count = 1; holding != 0; count++, holding &= holding - 1) {
+        if (count >= needed) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Buttons that combine their sensors, they are evaluated one by one after the sensors.
+static ButtonMask Pad_EvaluateCombinedButtons(ButtonMask buttonsPressed, SensorMask sensorsHolding,
+        const PadState* previous, const PadState* next) {
+    ButtonMask sumButtons = INTERNAL_PAD_CONF.sumButtons;
+    ButtonMask kOfNButtons = INTERNAL_PAD_CONF.kOfNButtons;
+    ButtonMask combined = sumButtons | kOfNButtons;
+
+    buttonsPressed &= ~combined;
+
+    for (uint8_t i = 0; combined != 0; i++, combined >>= 1, sumButtons >>= 1) {
+        if (!(combined & 1)) {
+            continue;
+        }
+
+        bool pressed = (sumButtons & 1) ? Pad_IsSumPressed(i, previous, next) : Pad_IsKOfNPressed(i, sensorsHolding);
+        if (pressed) {
+            buttonsPressed |= BUTTON_BIT(i);
+        }
+    }
+
+    return buttonsPressed;
+}
+#endif
+
+#if defined(FEATURE_DEBUG_ENABLED)
+// Press events carry the highest value of the sensors of the button.
+static void Pad_TraceButtonChanges(ButtonMask changed, const PadState* next) {
+    for (uint8_t i = 0; changed != 0; i++, changed >>= 1) {
+        if (!(changed & 1)) {
+            continue;
+        }
+
+        bool pressed = next->buttonsPressed & BUTTON_BIT(i);
+        uint16_t pressValue = 0;
+
+        for (uint8_t j = 0; pressed && j < SENSOR_COUNT; j++) {
+            if ((INTERNAL_PAD_CONF.buttonToSensors[i] & SENSOR_BIT(j)) && next->sensorValues[j] > pressValue) {
+                pressValue = next->sensorValues[j];
+            }
+        }
+
+        Debug_Trace(pressed ? DEBUG_EVENT_PRESS : DEBUG_EVENT_RELEASE, i, pressValue);
+    }
+}
+#endif
+
 void Pad_UpdateState(void) {
+#if defined(PAD_TIME_SCANS)
+    uint32_t scanStart = Timer_Micros();
+#endif
+
+    // Only this function and Pad_ReleaseState write PAD_STATE_INDEX, the scan goes into the buffer that is not
+    // published.
+    uint8_t nextIndex = PAD_STATE_INDEX ^ 1;
+    const PadState* previous = &PAD_STATES[PAD_STATE_INDEX];
+    PadState* next = &PAD_STATES[nextIndex];
+
     for (int i = 0; i < SENSOR_COUNT; i++) {
-        PAD_STATE.sensorValues[i] = ADC_Read(i);
+        next->sensorValues[i] = ADC_Read(i);
     }
 
-    for (int i = 0; i < BUTTON_COUNT; i++) {
-        bool newButtonPressedState = false;
+    Baseline_Update(next->sensorValues, previous->buttonsPressed);
 
-        for (int j = 0; j < SENSOR_COUNT; j++) {
-            int8_t sensor = INTERNAL_PAD_CONF.buttonToSensorMap[i][j];
-            
-            if (sensor == -1) {
-                break;
-            }
+    // Every sensor is compared against the threshold that applies to the state of its button, a button is pressed
+    // when any of its sensors holds it.
+    SensorMask sensorsHolding = 0;
+    ButtonMask buttonsPressed = 0;
 
-            if (sensor < 0 || sensor > SENSOR_COUNT) {
-                break;
-            }
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        ButtonMask button = INTERNAL_PAD_CONF.sensorToButton[i];
+        if (button == 0) {
+            continue;
+        }
 
-			SensorConfig s = PAD_CONF.sensors[sensor];
-            uint16_t sensorVal = PAD_STATE.sensorValues[sensor];
-
-            if (PAD_STATE.buttonsPressed[i]) {
-                if (sensorVal > s.releaseThreshold) {
-                    newButtonPressedState = true;
-                    break;
-                }
-            } else {
-                if (sensorVal > s.threshold) {
-                    newButtonPressedState = true;
-                    break;
-                }
-            }
+        const SensorConfig* s = &PAD_CONF.sensors[i];
+        uint16_t threshold = Baseline_Apply(s->threshold, i);
+        uint16_t releaseThreshold = Baseline_Apply(s->releaseThreshold, i);
+
+        if (Pad_IsSensorPressed(previous->buttonsPressed & button, next->sensorValues[i], threshold, releaseThreshold)) {
+            sensorsHolding |= SENSOR_BIT(i);
+            buttonsPressed |= button;
         }
+    }
 
-        PAD_STATE.buttonsPressed[i] = newButtonPressedState;
+#if defined(FEATURE_BUTTON_MODES_ENABLED)
+    if (INTERNAL_PAD_CONF.sumButtons | INTERNAL_PAD_CONF.kOfNButtons) {
+        buttonsPressed = Pad_EvaluateCombinedButtons(buttonsPressed, sensorsHolding, previous, next);
     }
+#else
+    (void)sensorsHolding;
+#endif
+
+    next->buttonsPressed = buttonsPressed;
+
+#if defined(FEATURE_DEBUG_ENABLED)
+    if (buttonsPressed != previous->buttonsPressed) {
+        Pad_TraceButtonChanges(buttonsPressed ^ previous->buttonsPressed, next);
+    }
+#endif
+
+    PAD_STATE_INDEX = nextIndex;
+
+#if defined(PAD_TIME_SCANS)
+    uint16_t scanTime = Timer_Micros() - scanStart;
+    Profiling_Scan(scanTime);
+    Sampling_Scan(scanStart);
+    #if defined(FEATURE_DEBUG_ENABLED)
+        Pad_TraceScanTime(scanTime);
+    #endif
+#endif
 	
 	Lights_Update(false);
 }
+
+void Pad_ReleaseState(void) {
+    uint8_t nextIndex = PAD_STATE_INDEX ^ 1;
+    memset(&PAD_STATES[nextIndex], 0, sizeof (PadState));
+    PAD_STATE_INDEX = nextIndex;
+
+    Lights_Update(true);
+}
@@ -7,7 +7,9 @@
 
 enum SensorConfigFlags
 {
-	ADC_DISABLED     = 0x1
+	ADC_DISABLED      = 0x1,
+	BASELINE_TRACKING = 0x2, // thresholds follow the drift of the idle value, see Baseline.h
+	JOYSTICK_AXIS     = 0x4  // drives a joystick axis, axis and curve in the upper bits, see Joystick.h
 };
 
 typedef struct {
@@ -29,16 +31,71 @@ typedef struct {
 	uint8_t selectedSensorIndex;
 } __attribute__((packed)) PadConfigurationV2;
 
+// How the sensors of a button are combined. A button with BUTTON_MODE_ANY is pressed while any of its sensors is above
+// its own threshold. The sums compare the sensor values, each multiplied by its weight for BUTTON_MODE_WEIGHTED_SUM,
+// to the thresholds of the button. BUTTON_MODE_K_OF_N needs count sensors above their own thresholds.
+enum ButtonModes
+{
+	BUTTON_MODE_ANY          = 0,
+	BUTTON_MODE_SUM          = 1,
+	BUTTON_MODE_WEIGHTED_SUM = 2,
+	BUTTON_MODE_K_OF_N       = 3
+};
+
+#define BUTTON_MODE_COUNT 4
+
+// Sensor weights are fixed point with 6 fraction bits, up to almost 4.
+#define SENSOR_WEIGHT_SHIFT 6
+#define SENSOR_WEIGHT_ONE (1 << SENSOR_WEIGHT_SHIFT)
+
+typedef struct {
+	uint8_t mode;
+	uint8_t count; // sensors needed by BUTTON_MODE_K_OF_N
+	uint16_t threshold; // of the sum modes
+	uint16_t releaseThreshold;
+} __attribute__((packed)) ButtonConfig;
+
+typedef struct {
+	ButtonConfig buttons[BUTTON_COUNT];
+	uint8_t sensorWeights[SENSOR_COUNT]; // of BUTTON_MODE_WEIGHTED_SUM, per sensor like the button mapping
+	uint8_t selectedButtonIndex;
+} __attribute__((packed)) ButtonConfiguration;
+
+// Bit i stands for button or sensor i. The button mask has the layout of the buttons in the input report.
+#if BUTTON_COUNT > 16 || SENSOR_COUNT > 16
+    #error "Button and sensor masks hold 16 buttons and 16 sensors"
+#endif
+
+typedef uint16_t ButtonMask;
+typedef uint16_t SensorMask;
+
+#define BUTTON_BIT(button) ((ButtonMask)1 << (button))
+#define SENSOR_BIT(sensor) ((SensorMask)1 << (sensor))
+
 typedef struct {
     uint16_t sensorValues[SENSOR_COUNT];
-    bool buttonsPressed[BUTTON_COUNT];
+    ButtonMask buttonsPressed;
 } PadState;
 
+// The pad state is double buffered. Pad_UpdateState fills the buffer readers do not see and then publishes it by
+// writing the one byte PAD_STATE_INDEX, so a reader that takes Pad_State() once sees one whole scan, even when a scan
+// interrupts it. The buffer is reused two scans later, readers must be done with it by then.
+extern PadState PAD_STATES[2];
+extern volatile uint8_t PAD_STATE_INDEX;
+
+static inline const PadState* Pad_State(void) {
+    return &PAD_STATES[PAD_STATE_INDEX];
+}
+
 void Pad_Initialize(const PadConfigurationV2* padConfiguration);
 void Pad_UpdateState(void);
+
+// Publishes a state with every button released and every sensor at zero, for the times the pad is not scanned.
+void Pad_ReleaseState(void);
 void Pad_UpdateConfiguration(const PadConfigurationV2* padConfiguration);
+void Pad_UpdateButtonConfiguration(const ButtonConfiguration* buttonConfiguration);
 
 extern PadConfigurationV2 PAD_CONF;
-extern PadState PAD_STATE;
+extern ButtonConfiguration BUTTON_CONF;
 
 #endif
@@ -0,0 +1,16 @@
+#ifndef _PAD_DECISION_H_
+#define _PAD_DECISION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Whether a sensor holds its button down. A released button needs a value above the threshold, a pressed one stays
+// down as long as the value is above the release threshold. A button is down when any of its sensors holds it.
+//
+// Kept free of the board configuration, so host tools (adp-optimize) run the exact decision of the firmware on
+// recorded input.
+static inline bool Pad_IsSensorPressed(bool buttonPressed, uint16_t value, uint16_t threshold, uint16_t releaseThreshold) {
+    return buttonPressed ? value > releaseThreshold : value > threshold;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include <util/atomic.h>
+
+#include "Profiling.h"
+#include "Config/DancePadConfig.h"
+
+#if defined(FEATURE_PROFILING_ENABLED)
+
+static ProfilingCounters counters;
+
+// Called from the USB interrupt, the other counters only change in the main loop.
+void Profiling_Frame(void) {
+    counters.frames++;
+}
+
+void Profiling_Configured(void) {
+    counters.configurations++;
+}
+
+void Profiling_Scan(uint16_t scanTime) {
+    counters.scans++;
+    counters.scanTime += scanTime;
+
+    if (scanTime > counters.maxScanTime) {
+        counters.maxScanTime = scanTime;
+    }
+}
+
+void Profiling_ReportAge(uint16_t reportAge) {
+    counters.reports++;
+    counters.reportAge += reportAge;
+
+    if (reportAge > counters.maxReportAge) {
+        counters.maxReportAge = reportAge;
+    }
+}
+
+void Profiling_Read(ProfilingCounters* target) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *target = counters;
+    }
+
+    counters.maxScanTime = 0;
+    counters.maxReportAge = 0;
+}
+
+#endif
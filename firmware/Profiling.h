@@ -0,0 +1,32 @@
+#ifndef _PROFILING_H_
+#define _PROFILING_H_
+
+#include <stdint.h>
+#include "Config/DancePadConfig.h"
+
+// Counters the host reads through the profiling report to monitor the pad. They all wrap around.
+typedef struct {
+    uint32_t frames; // USB start of frame events, one per millisecond while the host is connected
+    uint32_t scans; // sensor scans, one for every input report
+    uint32_t scanTime; // total time spent scanning (us)
+    uint16_t maxScanTime; // longest scan since the counters were previously read (us)
+    uint16_t configurations; // times a host configured the device since power on
+    uint32_t reports; // input reports the host took, see Sampling.h
+    uint32_t reportAge; // total time from the start of their scan until the host took them (us)
+    uint16_t maxReportAge; // oldest input report since the counters were previously read (us)
+} __attribute__((packed)) ProfilingCounters;
+
+#if defined(FEATURE_PROFILING_ENABLED)
+    void Profiling_Frame(void);
+    void Profiling_Configured(void);
+    void Profiling_Scan(uint16_t scanTime);
+    void Profiling_ReportAge(uint16_t reportAge);
+    void Profiling_Read(ProfilingCounters* counters);
+#else
+    // counting sits in hot paths, make sure it costs nothing when profiling is disabled.
+    #define Profiling_Frame() ((void)0)
+    #define Profiling_Configured() ((void)0)
+    #define Profiling_Scan(scanTime) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "RawAdc.h"
+#include "ADC.h"
+#include "Timer.h"
+
+#if defined(FEATURE_RAW_ADC_ENABLED)
+
+#define RAW_ADC_MAX_VALUE 0x3FF
+
+#if SENSOR_COUNT > RAW_ADC_MAX_SAMPLES
+    #error "A scan of all sensors has to fit a raw ADC report"
+#endif
+
+static bool isActive = false;
+static uint8_t selectedSensor = RAW_ADC_ALL_SENSORS;
+static RawAdcSamples pending;
+
+static void RawAdc_Clear(void) {
+    memset(&pending, 0, sizeof(pending));
+    pending.sensor = selectedSensor;
+}
+
+void RawAdc_SetActive(bool active) {
+    isActive = active;
+    RawAdc_Clear();
+}
+
+void RawAdc_Select(uint8_t sensor) {
+    selectedSensor = sensor < SENSOR_COUNT ? sensor : RAW_ADC_ALL_SENSORS;
+    RawAdc_Clear();
+}
+
+static void RawAdc_Pack(uint16_t value) {
+    if (value > RAW_ADC_MAX_VALUE) {
+        value = RAW_ADC_MAX_VALUE;
+    }
+
+    // samples start at an even bit, so every sample spans exactly two bytes
+    uint16_t bit = pending.count * 10;
+    uint8_t shift = bit & 7;
+    uint8_t* bytes = &pending.samples[bit >> 3];
+
+    bytes[0] |= (uint8_t)(value << shift);
+    bytes[1] |= (uint8_t)(value >> (8 - shift));
+    pending.count++;
+}
+
+static void RawAdc_Stamp(uint32_t now) {
+    if (pending.count == 0) {
+        pending.timestamp = now;
+    }
+
+    pending.duration = now - pending.timestamp;
+}
+
+void RawAdc_Task(void) {
+    if (!isActive) {
+        return;
+    }
+
+    if (selectedSensor == RAW_ADC_ALL_SENSORS) {
+        if (pending.count + SENSOR_COUNT > RAW_ADC_MAX_SAMPLES) {
+            return;
+        }
+
+        RawAdc_Stamp(Timer_Micros());
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            RawAdc_Pack(ADC_Read(i));
+        }
+    } else {
+        if (pending.count == RAW_ADC_MAX_SAMPLES) {
+            return;
+        }
+
+        RawAdc_Stamp(Timer_Micros());
+        RawAdc_Pack(ADC_Read(selectedSensor));
+    }
+}
+
+bool RawAdc_Write(RawAdcSamples* samples) {
+    if (pending.count == 0) {
+        return false;
+    }
+
+    memcpy(samples, &pending, sizeof(RawAdcSamples));
+    RawAdc_Clear();
+    return true;
+}
+
+#endif
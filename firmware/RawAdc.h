@@ -0,0 +1,48 @@
+#ifndef _RAW_ADC_H_
+#define _RAW_ADC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Config/DancePadConfig.h"
+
+// Raw conversions for diagnosing sensor hardware. While the host has INPUT_REPORT_FORMAT_RAW_ADC selected, the main
+// loop converts back to back and every conversion goes to the host, packed in 10 bits, in RAW_ADC_REPORT_ID reports
+// instead of the input reports. That shows the noise and ringing the pad state hides.
+//
+// With RAW_ADC_ALL_SENSORS selected through SPID_RAW_ADC_SENSOR the sensors are scanned in turn and a report carries
+// whole scans, otherwise only the selected sensor is converted, at the full rate of the ADC. The pad is not scanned
+// meanwhile: its buttons and lights are released when streaming starts, with one input report before the first
+// RAW_ADC_REPORT_ID report, and baselines keep the state they had.
+
+#define RAW_ADC_ALL_SENSORS 0xFF
+
+// Samples that fit a report of GENERIC_EPSIZE, 4 samples take 5 bytes.
+#define RAW_ADC_MAX_SAMPLES 40
+#define RAW_ADC_PACKED_SIZE (RAW_ADC_MAX_SAMPLES * 10 / 8)
+
+typedef struct {
+    uint8_t sensor; // RAW_ADC_ALL_SENSORS or the sensor converted
+    uint8_t count; // samples, whole scans of SENSOR_COUNT samples when all sensors are scanned
+    uint32_t timestamp; // Timer_Micros() at the first sample
+    uint16_t duration; // from the first sample to the last, or to the start of the last scan (us)
+    uint8_t samples[RAW_ADC_PACKED_SIZE]; // 10 bits each, least significant bit first
+} __attribute__((packed)) RawAdcSamples;
+
+#if defined(FEATURE_RAW_ADC_ENABLED)
+    // Called when the input report format changes, starts with an empty report.
+    void RawAdc_SetActive(bool active);
+
+    // RAW_ADC_ALL_SENSORS or a sensor index, starts with an empty report.
+    void RawAdc_Select(uint8_t sensor);
+
+    // Called from the main loop, converts while streaming and the report has room.
+    void RawAdc_Task(void);
+
+    // Writes the samples since the previous report, returns false if there are none yet.
+    bool RawAdc_Write(RawAdcSamples* samples);
+#else
+    #define RawAdc_SetActive(active) ((void)0)
+    #define RawAdc_Task() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#include <stdbool.h>
+#include <util/atomic.h>
+
+#include "Sampling.h"
+#include "Descriptors.h"
+#include "Profiling.h"
+#include "Timer.h"
+
+#if defined(FEATURE_SOF_SYNC_ENABLED)
+
+#if SOF_SCAN_OFFSET_US >= FRAME_US
+    #error "SOF_SCAN_OFFSET_US has to leave time for the scan within the frame"
+#endif
+
+// Written from the USB interrupt.
+static volatile uint32_t startOfFrame = 0;
+static volatile bool hasStartOfFrame = false;
+
+void Sampling_StartOfFrame(void) {
+    startOfFrame = Timer_Micros();
+    hasStartOfFrame = true;
+}
+
+bool Sampling_IsScanDue(void) {
+#if SOF_SCAN_OFFSET_US > 0
+    uint32_t frameStart;
+    bool synchronized;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        frameStart = startOfFrame;
+        synchronized = hasStartOfFrame;
+    }
+
+    if (!synchronized) {
+        return true;
+    }
+
+    // the class driver scans at most once per frame, this only holds the scan back until the offset
+    return Timer_Micros() - frameStart >= SOF_SCAN_OFFSET_US;
+#else
+    // the class driver already waits for the next frame
+    return true;
+#endif
+}
+
+#endif
+
+#if defined(FEATURE_PROFILING_ENABLED)
+
+static uint32_t lastScanStart = 0;
+static uint32_t reportScanStart = 0;
+static bool isReportPending = false;
+
+void Sampling_Scan(uint32_t scanStart) {
+    lastScanStart = scanStart;
+}
+
+void Sampling_InputReport(void) {
+    reportScanStart = lastScanStart;
+    isReportPending = true;
+}
+
+void Sampling_Poll(void) {
+    if (!isReportPending) {
+        return;
+    }
+
+    // the bank of the endpoint is free again once the host took the report
+    Endpoint_SelectEndpoint(GENERIC_IN_EPADDR);
+    if (!Endpoint_IsINReady()) {
+        return;
+    }
+
+    uint32_t age = Timer_Micros() - reportScanStart;
+    Profiling_ReportAge(age < UINT16_MAX ? age : UINT16_MAX);
+    isReportPending = false;
+}
+
+#endif
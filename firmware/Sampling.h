@@ -0,0 +1,48 @@
+#ifndef _SAMPLING_H_
+#define _SAMPLING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Config/DancePadConfig.h"
+
+// When the sensors are scanned for an input report. The class driver scans as soon as the host took the previous
+// report, after which the report waits in the endpoint until the IN token of the next frame. How long depends on
+// where in the frame the host polls, so the age of the data varies between a scan and a whole frame.
+//
+// With FEATURE_SOF_SYNC the scan for the next report starts SOF_SCAN_OFFSET_US after the start of frame, so it ends
+// just before the next frame and every report is about a scan old when the host takes it. Without start of frame
+// events, while suspended or before a host configured the pad, the scans run free like before.
+//
+// With FEATURE_PROFILING the age of the input reports, from the start of their newest scan until the host took them,
+// is measured for the profiling report.
+
+// A full speed frame.
+#define FRAME_US 1000
+
+#if defined(FEATURE_SOF_SYNC_ENABLED)
+    // Called from the start of frame event.
+    void Sampling_StartOfFrame(void);
+
+    // Called from the main loop, true when the class driver may scan for the next input report.
+    bool Sampling_IsScanDue(void);
+#else
+    #define Sampling_StartOfFrame() ((void)0)
+    #define Sampling_IsScanDue() (true)
+#endif
+
+#if defined(FEATURE_PROFILING_ENABLED)
+    // Called from Pad_UpdateState with the time its scan started.
+    void Sampling_Scan(uint32_t scanStart);
+
+    // Called after an input report with a new scan was written.
+    void Sampling_InputReport(void);
+
+    // Called from the main loop, counts the age of the input report once the host took it.
+    void Sampling_Poll(void);
+#else
+    #define Sampling_Scan(scanStart) ((void)0)
+    #define Sampling_InputReport() ((void)0)
+    #define Sampling_Poll() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "Timer.h"
+
+// Timer1 runs freely at F_CPU / 8. With the 16MHz clock every tick is half a microsecond and the
+// 16-bit counter overflows every 32.768ms. The overflow interrupt extends the counter to 32 bits.
+static volatile uint32_t timerOverflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+    timerOverflows++;
+}
+
+void Timer_Init(void) {
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11);
+    TCNT1 = 0;
+    TIMSK1 = (1 << TOIE1);
+}
+
+uint32_t Timer_Micros(void) {
+    uint32_t overflows;
+    uint16_t ticks;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks = TCNT1;
+        overflows = timerOverflows;
+
+        // the counter may have wrapped while interrupts were disabled, without the interrupt handled yet.
+        if ((TIFR1 & (1 << TOV1)) && ticks < 0x8000) {
+            overflows++;
+        }
+    }
+
+    return (overflows << 15) | (ticks >> 1);
+}
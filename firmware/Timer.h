@@ -0,0 +1,7 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+    #include <stdint.h>
+
+    void Timer_Init(void);
+    uint32_t Timer_Micros(void);
+#endif
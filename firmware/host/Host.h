@@ -0,0 +1,8 @@
+#ifndef _HOST_H_
+#define _HOST_H_
+    #include <stdint.h>
+
+    // Sensor values the virtual pad reports, set from stdin by HostUSB.c.
+    void HostADC_Set(uint8_t sensor, uint16_t value);
+    void HostADC_HandleCommand(const char* command);
+#endif
@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "Config/DancePadConfig.h"
+#include "ADC.h"
+#include "Host.h"
+
+static uint16_t sensorValues[SENSOR_COUNT];
+
+void ADC_Init(void) {
+}
+
+uint16_t ADC_Read(uint8_t sensor) {
+    return sensorValues[sensor];
+}
+
+void HostADC_Set(uint8_t sensor, uint16_t value) {
+    if (sensor >= SENSOR_COUNT) {
+        return;
+    }
+
+    sensorValues[sensor] = value < MAX_SENSOR_VALUE ? value : MAX_SENSOR_VALUE - 1;
+}
+
+// Commands are "<sensor> <value>" to set one sensor, or "all <value>" to set every sensor.
+void HostADC_HandleCommand(const char* command) {
+    unsigned int sensor, value;
+
+    if (sscanf(command, "all %u", &value) == 1) {
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            HostADC_Set(i, value);
+        }
+    } else if (sscanf(command, "%u %u", &sensor, &value) == 2) {
+        HostADC_Set(sensor, value);
+    } else {
+        fprintf(stderr, "adp-uhid: expected \"<sensor> <value>\" or \"all <value>\", got: %s\n", command);
+    }
+}
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/eeprom.h>
+
+// EEPROM of the atmega32u4, kept in a file so the configuration survives restarts like on a board.
+// The file is named by ADP_UHID_EEPROM and defaults to adp-uhid.eeprom in the working directory.
+#define EEPROM_SIZE 1024
+
+static uint8_t eeprom[EEPROM_SIZE];
+static int loaded = 0;
+
+static const char* EEPROM_Path(void) {
+    const char* path = getenv("ADP_UHID_EEPROM");
+    return path ? path : "adp-uhid.eeprom";
+}
+
+static void EEPROM_Load(void) {
+    if (loaded) {
+        return;
+    }
+
+    // erased cells read as 0xFF
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    loaded = 1;
+
+    FILE* file = fopen(EEPROM_Path(), "rb");
+    if (file) {
+        fread(eeprom, 1, sizeof(eeprom), file);
+        fclose(file);
+    }
+}
+
+static void EEPROM_Store(void) {
+    FILE* file = fopen(EEPROM_Path(), "wb");
+    if (!file) {
+        perror("adp-uhid: could not write eeprom file");
+        return;
+    }
+
+    fwrite(eeprom, 1, sizeof(eeprom), file);
+    fclose(file);
+}
+
+void eeprom_read_block(void* dst, const void* src, size_t size) {
+    uintptr_t address = (uintptr_t) src;
+    EEPROM_Load();
+
+    if (address + size > EEPROM_SIZE) {
+        memset(dst, 0xFF, size);
+        return;
+    }
+
+    memcpy(dst, eeprom + address, size);
+}
+
+void eeprom_update_block(const void* src, void* dst, size_t size) {
+    uintptr_t address = (uintptr_t) dst;
+    EEPROM_Load();
+
+    if (address + size > EEPROM_SIZE || memcmp(eeprom + address, src, size) == 0) {
+        return;
+    }
+
+    memcpy(eeprom + address, src, size);
+    EEPROM_Store();
+}
@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <util/delay.h>
+#include <LUFA/Drivers/USB/USB.h>
+#include "Reset.h"
+
+void Reconnect_Usb(void) {
+    // destroys and recreates the uhid device, so the host sees an unplug and replug
+    USB_Detach();
+    _delay_ms(5);
+    USB_Attach();
+}
+
+void Reset_JumpToBootloader(void) {
+    // there is no bootloader to jump to, behave like a pad that left the bus
+    fprintf(stderr, "adp-uhid: bootloader requested, exiting\n");
+    USB_Disable();
+    exit(0);
+}
@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <time.h>
+
+#include "Timer.h"
+
+// Monotonic clock instead of Timer1, wraps at 32 bits like the firmware counter.
+static uint64_t startMicros = 0;
+
+static uint64_t MonotonicMicros(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void Timer_Init(void) {
+    startMicros = MonotonicMicros();
+}
+
+uint32_t Timer_Micros(void) {
+    return (uint32_t) (MonotonicMicros() - startMicros);
+}
@@ -0,0 +1,311 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/uhid.h>
+#include <LUFA/Drivers/USB/USB.h>
+
+#include "Config/DancePadConfig.h"
+#include "Host.h"
+
+// USB device side of the host build. Instead of the AVR USB controller, the pad is exposed to the
+// kernel through /dev/uhid: the report descriptor comes from CALLBACK_USB_GetDescriptor, feature and
+// output reports from the kernel are passed to the firmware callbacks and input reports are sent
+// once per frame, like the interrupt endpoint polled at 1ms. Sensor values are read from stdin.
+//
+// Environment:
+//   ADP_UHID_FRAME_US  microseconds between input reports, defaults to 1000 (full speed frame)
+//   ADP_UHID_EEPROM    file backing the eeprom, see HostEEPROM.c
+
+#define UHID_PATH "/dev/uhid"
+#define DEFAULT_FRAME_US 1000
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+static int uhidFd = -1;
+static bool attached = false;
+static uint32_t frameMicros = DEFAULT_FRAME_US;
+static uint64_t nextFrame = 0;
+
+static char commandBuffer[128];
+static size_t commandLength = 0;
+static bool commandsOpen = true;
+
+static uint64_t USB_Micros(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void USB_Write(const struct uhid_event* event) {
+    ssize_t written = write(uhidFd, event, sizeof(*event));
+    if (written != sizeof(*event)) {
+        perror("adp-uhid: write to " UHID_PATH " failed");
+    }
+}
+
+void USB_Init(void) {
+    const char* frame = getenv("ADP_UHID_FRAME_US");
+    if (frame && atoi(frame) > 0) {
+        frameMicros = atoi(frame);
+    }
+
+    uhidFd = open(UHID_PATH, O_RDWR | O_CLOEXEC);
+    if (uhidFd < 0) {
+        perror("adp-uhid: could not open " UHID_PATH);
+        exit(1);
+    }
+
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+
+    USB_Attach();
+}
+
+void USB_Disable(void) {
+    USB_Detach();
+    close(uhidFd);
+    uhidFd = -1;
+}
+
+void USB_Attach(void) {
+    if (attached) {
+        return;
+    }
+
+    const USB_Descriptor_Device_t* device;
+    const void* reportDescriptor;
+    CALLBACK_USB_GetDescriptor(DTYPE_Device << 8, 0, (const void**) &device);
+    uint16_t reportDescriptorSize = CALLBACK_USB_GetDescriptor(HID_DTYPE_Report << 8, 0, &reportDescriptor);
+
+    struct uhid_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = UHID_CREATE2;
+    snprintf((char*) event.u.create2.name, sizeof(event.u.create2.name), "DDR-EXP Virtual FSR pad");
+    snprintf((char*) event.u.create2.phys, sizeof(event.u.create2.phys), "adp-uhid");
+    event.u.create2.rd_size = reportDescriptorSize;
+    event.u.create2.bus = BUS_USB;
+    event.u.create2.vendor = device->VendorID;
+    event.u.create2.product = device->ProductID;
+    event.u.create2.version = device->ReleaseNumber;
+    memcpy(event.u.create2.rd_data, reportDescriptor, reportDescriptorSize);
+
+    USB_Write(&event);
+    attached = true;
+}
+
+void USB_Detach(void) {
+    if (!attached) {
+        return;
+    }
+
+    struct uhid_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = UHID_DESTROY;
+
+    USB_Write(&event);
+    attached = false;
+}
+
+void USB_USBTask(void) {
+}
+
+void USB_Device_EnableSOFEvents(void) {
+}
+
+void GlobalInterruptEnable(void) {
+}
+
+bool HID_Device_ConfigureEndpoints(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) {
+    memset(&HIDInterfaceInfo->State, 0, sizeof(HIDInterfaceInfo->State));
+    HIDInterfaceInfo->State.UsingReportProtocol = true;
+    return true;
+}
+
+void HID_Device_ProcessControlRequest(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) {
+    // control requests arrive as uhid events, see HID_Device_HandleEvent
+}
+
+void HID_Device_MillisecondElapsed(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) {
+}
+
+void Endpoint_SelectEndpoint(const uint8_t Address) {
+}
+
+bool Endpoint_IsINReady(void) {
+    // input reports are written to uhid right away, there is no bank waiting for the host
+    return true;
+}
+
+static void HID_Device_GetReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                 const struct uhid_get_report_req* request) {
+    struct uhid_event reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.type = UHID_GET_REPORT_REPLY;
+    reply.u.get_report_reply.id = request->id;
+
+    // like a control transfer, the report id goes first
+    uint8_t reportID = request->rnum;
+    uint16_t reportSize = 0;
+    uint8_t reportType = request->rtype == UHID_INPUT_REPORT ? HID_REPORT_ITEM_In : HID_REPORT_ITEM_Feature;
+
+    CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &reportID, reportType, reply.u.get_report_reply.data + 1, &reportSize);
+
+    if (reportSize == 0) {
+        reply.u.get_report_reply.err = EIO;
+    } else {
+        reply.u.get_report_reply.data[0] = reportID;
+        reply.u.get_report_reply.size = reportSize + 1;
+    }
+
+    USB_Write(&reply);
+}
+
+static void HID_Device_SetReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo,
+                                 const struct uhid_set_report_req* request) {
+    if (request->size > 0) {
+        uint8_t reportType = request->rtype == UHID_OUTPUT_REPORT ? HID_REPORT_ITEM_Out : HID_REPORT_ITEM_Feature;
+        CALLBACK_HID_Device_ProcessHIDReport(HIDInterfaceInfo, request->rnum, reportType, request->data + 1, request->size - 1);
+    }
+
+    struct uhid_event reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.type = UHID_SET_REPORT_REPLY;
+    reply.u.set_report_reply.id = request->id;
+    reply.u.set_report_reply.err = 0;
+
+    USB_Write(&reply);
+}
+
+static void HID_Device_HandleEvent(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) {
+    struct uhid_event event;
+    ssize_t size = read(uhidFd, &event, sizeof(event));
+    if (size <= 0) {
+        return;
+    }
+
+    switch (event.type) {
+        case UHID_START:
+            // the kernel bound a driver, as good as a host selecting the configuration
+            EVENT_USB_Device_ConfigurationChanged();
+            break;
+        case UHID_GET_REPORT:
+            HID_Device_GetReport(HIDInterfaceInfo, &event.u.get_report);
+            break;
+        case UHID_SET_REPORT:
+            HID_Device_SetReport(HIDInterfaceInfo, &event.u.set_report);
+            break;
+        case UHID_OUTPUT:
+            // hid_write() of reports without an output item, report id is the first byte
+            if (event.u.output.size > 0) {
+                CALLBACK_HID_Device_ProcessHIDReport(HIDInterfaceInfo, event.u.output.data[0], HID_REPORT_ITEM_Out,
+                                                     event.u.output.data + 1, event.u.output.size - 1);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void HID_Device_ReadCommands(void) {
+    ssize_t size = read(STDIN_FILENO, commandBuffer + commandLength, sizeof(commandBuffer) - commandLength - 1);
+    if (size == 0) {
+        // stdin closed, keep the last sensor values
+        commandsOpen = false;
+    }
+    if (size <= 0) {
+        return;
+    }
+
+    commandLength += size;
+    commandBuffer[commandLength] = '\0';
+
+    char* line = commandBuffer;
+    char* end;
+    while ((end = strchr(line, '\n')) != NULL) {
+        *end = '\0';
+        HostADC_HandleCommand(line);
+        line = end + 1;
+    }
+
+    // keep an incomplete line for the next read, drop it if it can never complete
+    commandLength = strlen(line);
+    if (commandLength == sizeof(commandBuffer) - 1) {
+        commandLength = 0;
+    }
+    memmove(commandBuffer, line, commandLength);
+}
+
+static void HID_Device_SendInputReport(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) {
+    // same rules as the LUFA class driver: send if forced or if the report changed
+    struct uhid_event event;
+    memset(&event, 0, sizeof(event));
+    event.type = UHID_INPUT2;
+
+    uint8_t reportID = 0;
+    uint16_t reportSize = 0;
+    uint8_t* reportData = event.u.input2.data + 1;
+
+    bool forceSend = CALLBACK_HID_Device_CreateHIDReport(HIDInterfaceInfo, &reportID, HID_REPORT_ITEM_In, reportData, &reportSize);
+    bool statesChanged = false;
+
+    if (HIDInterfaceInfo->Config.PrevReportINBuffer != NULL) {
+        uint16_t previousSize = MIN(reportSize, HIDInterfaceInfo->Config.PrevReportINBufferSize);
+        statesChanged = memcmp(reportData, HIDInterfaceInfo->Config.PrevReportINBuffer, previousSize) != 0;
+        memcpy(HIDInterfaceInfo->Config.PrevReportINBuffer, reportData, previousSize);
+    }
+
+    if (reportSize == 0 || !(forceSend || statesChanged)) {
+        return;
+    }
+
+    event.u.input2.data[0] = reportID;
+    event.u.input2.size = reportSize + 1;
+    USB_Write(&event);
+}
+
+void HID_Device_USBTask(USB_ClassInfo_HID_Device_t* const HIDInterfaceInfo) {
+    if (!attached) {
+        return;
+    }
+
+    uint64_t now = USB_Micros();
+    if (nextFrame == 0) {
+        nextFrame = now;
+    }
+
+    // wait for kernel requests or stdin until the next frame is due
+    struct pollfd fds[2] = {
+        { .fd = uhidFd, .events = POLLIN },
+        { .fd = STDIN_FILENO, .events = POLLIN },
+    };
+    uint64_t wait = nextFrame > now ? nextFrame - now : 0;
+    struct timespec timeout = { .tv_sec = wait / 1000000, .tv_nsec = (wait % 1000000) * 1000 };
+
+    if (ppoll(fds, commandsOpen ? 2 : 1, &timeout, NULL) > 0) {
+        if (fds[0].revents & POLLIN) {
+            HID_Device_HandleEvent(HIDInterfaceInfo);
+        }
+        if (commandsOpen && (fds[1].revents & (POLLIN | POLLHUP))) {
+            HID_Device_ReadCommands();
+        }
+    }
+
+    now = USB_Micros();
+    if (now < nextFrame) {
+        return;
+    }
+
+    // skip frames we were too late for instead of sending a burst
+    nextFrame += frameMicros;
+    if (nextFrame <= now) {
+        nextFrame = now + frameMicros;
+    }
+
+    EVENT_USB_Device_StartOfFrame();
+    HID_Device_SendInputReport(HIDInterfaceInfo);
+}
@@ -0,0 +1,11 @@
+#ifndef _HOST_LUFA_PLATFORM_H_
+#define _HOST_LUFA_PLATFORM_H_
+    // ARCH is left at ARCH_HOST so SetupHardware() skips the AVR8 and XMEGA clock setup.
+    #define ARCH_AVR8  0
+    #define ARCH_XMEGA 1
+    #define ARCH_HOST  2
+
+    #ifndef ARCH
+        #define ARCH ARCH_HOST
+    #endif
+#endif
@@ -0,0 +1,8 @@
+#ifndef _HOST_AVR_EEPROM_H_
+#define _HOST_AVR_EEPROM_H_
+    #include <stddef.h>
+
+    // Backed by a file, see HostEEPROM.c.
+    void eeprom_read_block(void* dst, const void* src, size_t size);
+    void eeprom_update_block(const void* src, void* dst, size_t size);
+#endif
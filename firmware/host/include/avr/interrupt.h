@@ -0,0 +1,6 @@
+#ifndef _HOST_AVR_INTERRUPT_H_
+#define _HOST_AVR_INTERRUPT_H_
+    // The daemon is single threaded, there is nothing to mask.
+    #define cli()
+    #define sei()
+#endif
@@ -0,0 +1,6 @@
+#ifndef _HOST_AVR_IO_H_
+#define _HOST_AVR_IO_H_
+    // The host build has no registers. Sources that touch them (ADC.c, Timer.c, Reset.c) are
+    // replaced by the Host*.c files, the rest only needs this header to exist.
+    #include <stdint.h>
+#endif
@@ -0,0 +1,11 @@
+#ifndef _HOST_AVR_PGMSPACE_H_
+#define _HOST_AVR_PGMSPACE_H_
+    #include <stdint.h>
+
+    // Flash and RAM share one address space on the host.
+    #define PROGMEM
+    #define PSTR(s) (s)
+    #define pgm_read_byte(address) (*(const uint8_t*) (address))
+    #define pgm_read_word(address) (*(const uint16_t*) (address))
+    #define memcpy_P memcpy
+#endif
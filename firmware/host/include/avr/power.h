@@ -0,0 +1,4 @@
+#ifndef _HOST_AVR_POWER_H_
+#define _HOST_AVR_POWER_H_
+    #define clock_prescale_set(x)
+#endif
@@ -0,0 +1,4 @@
+#ifndef _HOST_AVR_WDT_H_
+#define _HOST_AVR_WDT_H_
+    #define wdt_disable()
+#endif
@@ -0,0 +1,7 @@
+#ifndef _HOST_UTIL_ATOMIC_H_
+#define _HOST_UTIL_ATOMIC_H_
+    // No interrupts on the host, the block simply runs once.
+    #define ATOMIC_RESTORESTATE
+    #define ATOMIC_FORCEON
+    #define ATOMIC_BLOCK(type) for (int _atomicOnce = 1; _atomicOnce; _atomicOnce = 0)
+#endif
@@ -0,0 +1,7 @@
+#ifndef _HOST_UTIL_DELAY_H_
+#define _HOST_UTIL_DELAY_H_
+    #include <unistd.h>
+
+    #define _delay_ms(ms) usleep((ms) * 1000)
+    #define _delay_us(us) usleep(us)
+#endif